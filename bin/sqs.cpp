@@ -95,9 +95,9 @@ bool sendMessage (SQSConnectionPtr aSQS, std::string aQueueName, std::string aMe
 }
 
 
-bool receiveMessage (SQSConnectionPtr aSQS, std::string aQueueName,  int aMaxNbMessages, int aVisibilityTimeout, bool aDecode = true) {
+bool receiveMessage (SQSConnectionPtr aSQS, std::string aQueueName,  int aMaxNbMessages, int aVisibilityTimeout, bool aDecode = true, int aWaitTime = 0) {
   try {
-      ReceiveMessageResponsePtr lReceiveMessages = aSQS->receiveMessage (aQueueName, aMaxNbMessages, aVisibilityTimeout, aDecode);
+      ReceiveMessageResponsePtr lReceiveMessages = aSQS->receiveMessage (aQueueName, aMaxNbMessages, aVisibilityTimeout, aDecode, aWaitTime);
       lReceiveMessages->open();
       ReceiveMessageResponse::Message lMessage;
       std::cout << "received messages:" << std::endl;
@@ -171,13 +171,14 @@ main (int argc, char** argv) {
   char* lReceiptHandle = 0;
   char* lHost = 0;
   bool lBase64 = true;
+  int lWaitTime = 0;
 
   int c;
   opterr = 0;
 
   AWSConnectionFactory* lFactory = AWSConnectionFactory::getInstance();
 
-  while ( (c = getopt (argc, argv, "hbi:s:a:n:p:x:m:r:")) != -1)
+  while ( (c = getopt (argc, argv, "hbi:s:a:n:p:x:m:r:w:")) != -1)
     switch (c) {
       case 'i':
         lAccessKeyId = optarg;
@@ -209,6 +210,9 @@ main (int argc, char** argv) {
       case 'r':
         lReceiptHandle = optarg;
         break;
+      case 'w':
+        lWaitTime = atoi (optarg);
+        break;
       case 'h': {
           std::cout << "libaws version " << lFactory->getVersion() << std::endl;
           std::cout << "Usage: sqs <options>" << std::endl;
@@ -230,6 +234,7 @@ main (int argc, char** argv) {
           std::cout << "  -m message: the message to send" << std::endl;
           std::cout << "  -v visibility timeout: the visibility timeout" << std::endl;
           std::cout << "  -r receipt-handle: the receipt-handle" << std::endl;
+          std::cout << "  -w wait time: seconds to wait for messages (long polling, max. 20)" << std::endl;
           std::cout << "  -b base64-handle: do not encode/decode message bodies to/from base64" << std::endl;
           std::cout << "  -h help: display help" << std::endl;
           exit (1);
@@ -326,7 +331,7 @@ main (int argc, char** argv) {
           std::cerr << "Use -n as a command line argument" << std::endl;
           exit (1);
         }
-      receiveMessage (lSQSRest, lQueueName, lMaxNbMessages, lVisibilityTimeOut, lBase64);
+      receiveMessage (lSQSRest, lQueueName, lMaxNbMessages, lVisibilityTimeOut, lBase64, lWaitTime);
     } else if (lActionString.compare ("delete-message") == 0) {
       if (!lQueueName) {
           std::cerr << "No queue name parameter specified." << std::endl;
@@ -18,12 +18,13 @@
 #  MEMCACHED_FOUND - system has libmemcache
 #  MEMCACHED_INCLUDE_DIR - the libmemcache include directory
 #  MEMCACHED_LIBRARY - Link these to use libmemcache
+#  MEMCACHED_UTIL_LIBRARY - Link these to use the libmemcache connection pool
 #
 
-IF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY)
+IF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY AND MEMCACHED_UTIL_LIBRARY)
    # in cache already
    SET(Memcached_FIND_QUIETLY TRUE)
-ENDIF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY)
+ENDIF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY AND MEMCACHED_UTIL_LIBRARY)
 
 FIND_PATH(MEMCACHED_INCLUDE_DIR memcached.h
   /usr/include
@@ -37,15 +38,21 @@ FIND_LIBRARY(MEMCACHED_LIBRARY NAMES memcached
   /usr/${LIB_DESTINATION}
   /usr/local/${LIB_DESTINATION})
 
-IF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY)
+FIND_LIBRARY(MEMCACHED_UTIL_LIBRARY NAMES memcachedutil
+  PATHS
+  /usr/${LIB_DESTINATION}
+  /usr/local/${LIB_DESTINATION})
+
+IF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY AND MEMCACHED_UTIL_LIBRARY)
    SET(MEMCACHED_FOUND TRUE)
-ELSE (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY)
+ELSE (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY AND MEMCACHED_UTIL_LIBRARY)
    SET(MEMCACHED_FOUND FALSE)
-ENDIF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY)
+ENDIF (MEMCACHED_INCLUDE_DIR AND MEMCACHED_LIBRARY AND MEMCACHED_UTIL_LIBRARY)
 
 IF(MEMCACHED_FOUND)
   IF(NOT Memcached_FIND_QUIETLY)
     MESSAGE(STATUS "Found libMemcached: ${MEMCACHED_LIBRARY}")
+    MESSAGE(STATUS "Found libMemcachedUtil: ${MEMCACHED_UTIL_LIBRARY}")
     MESSAGE(STATUS "Found libMemcached include dir: ${MEMCACHED_INCLUDE_DIR}")
   ENDIF(NOT Memcached_FIND_QUIETLY)
 ELSE(MEMCACHED_FOUND)
@@ -54,4 +61,4 @@ ELSE(MEMCACHED_FOUND)
   ENDIF(Memcached_FIND_REQUIRED)
 ENDIF(MEMCACHED_FOUND)
 
-MARK_AS_ADVANCED(MEMCACHED_INCLUDE_DIR MEMCACHED_LIBRARY)
+MARK_AS_ADVANCED(MEMCACHED_INCLUDE_DIR MEMCACHED_LIBRARY MEMCACHED_UTIL_LIBRARY)
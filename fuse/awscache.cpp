@@ -17,6 +17,7 @@
 #include <cassert>
 #include <memory>
 #include <syslog.h>
+#include <unistd.h>
 
 #define S3FS_LOG_SYSLOG 1
 //#define CACHE_TEXT_FILES_ONLY 1
@@ -79,44 +80,70 @@ namespace aws {
   std::string AWSCache::PREFIX_FILE("file");
   std::string AWSCache::PREFIX_SYMLINK("symlink");
 
-  unsigned int AWSCache::FILE_CACHING_UPPER_LIMIT=300000; // 1000 (means approx. 1kb)
+  unsigned int AWSCache::FILE_CACHING_UPPER_LIMIT=16777216; // 16 MB
+  unsigned int AWSCache::FILE_CHUNK_SIZE=512000; // memcached items are limited to 1 MB by default
+  unsigned int AWSCache::CONNECTION_POOL_SIZE=10;
   std::string AWSCache::DELIMITER_FOLDER_ENTRIES=",";
 
   AWSCache::AWSCache(std::string bucketname):
-     theBucketname(bucketname)
+     theBucketname(bucketname),
+     theMaster(NULL),
+     thePool(NULL)
   {
     if (!(theServers= getenv("MEMCACHED_SERVERS")))
     {
       std::cerr << "Unable to use memcached client functionality. Please specify the MEMCACHED_SERVERS environment variable" << std::endl;
       exit(4);
     }
+
+    memcached_server_st *servers;
+    theMaster=memcached_create(NULL);
+    servers= memcached_servers_parse(theServers);
+
+    // tell memc where the memcached servers are
+    memcached_server_push(theMaster, servers);
+    memcached_server_list_free(servers);
+
+    // the binary protocol saves the parsing of the text protocol and allows pipelined multi gets
+    memcached_behavior_set(theMaster, MEMCACHED_BEHAVIOR_BINARY_PROTOCOL, 1);
+    memcached_behavior_set(theMaster, MEMCACHED_BEHAVIOR_TCP_NODELAY, 1);
+
+    // the connections in the pool are cloned from the master and stay connected
+    thePool=memcached_pool_create(theMaster, 1, CONNECTION_POOL_SIZE);
+    if (thePool==NULL)
+    {
+      std::cerr << "Unable to create the memcached connection pool." << std::endl;
+      exit(4);
+    }
   }
 
   AWSCache::~AWSCache(){
+    if (thePool)
+      memcached_pool_destroy(thePool);
+    if (theMaster)
+      memcached_free(theMaster);
   }
 
   memcached_st *
   AWSCache::get_Memcached_struct()
   {
-    S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::get_Memcached_struct()","create struct");
-
-    memcached_server_st *servers;
-    memcached_st * memc=memcached_create(NULL);
-    servers= memcached_servers_parse(theServers);
-
-    // tell memc where the memcached servers are
-    memcached_server_push(memc, servers);
-    memcached_server_list_free(servers);
+    S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::get_Memcached_struct()","pop struct from pool");
 
+    memcached_return rc;
+    memcached_st * memc=memcached_pool_pop(thePool, true, &rc);
+    if (memc==NULL){
+      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::get_Memcached_struct()","couldn't get struct from pool (rc=" << (int) rc << ")");
+      throw rc;
+    }
     return memc;
   }
 
 
   void AWSCache::free_Memcached_struct(memcached_st * memc)
   {
-    S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::free_Memcached_struct(...)","destroy struct");
+    S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::free_Memcached_struct(...)","push struct back to pool");
 
-    memcached_free(memc);
+    memcached_pool_push(thePool, memc);
   }
 
 /*
@@ -184,37 +211,82 @@ namespace aws {
   }
 
 
+/*
+ * a chunk generation no other process uses: host, pid, time and a counter.
+ * the host name is hashed, it may be long and contain spaces
+ */
+  static std::string new_generation()
+  {
+    static unsigned long counter=0;
+
+    char host[256];
+    if(gethostname(host,sizeof(host))!=0) host[0]='\0';
+    host[sizeof(host)-1]='\0';
+    unsigned long hash=2166136261UL;
+    for(const char* c=host; *c!='\0'; ++c) hash=((hash^(unsigned char)*c)*16777619UL)&0xffffffffUL;
+
+    std::ostringstream generation;
+    generation << std::hex << hash << std::dec << "-" << getpid() << "-" << time(0)
+               << "-" << __sync_add_and_fetch(&counter,1);
+    return generation.str();
+  }
+
+
 /*
  * saving a file to cache
+ *
+ * the chunks are written first (pipelined) and the manifest last, so a reader
+ * never sees a manifest without its chunks. The chunk keys contain a generation
+ * which is stored in the manifest; chunks of an older version are never mixed
+ * with the current one and simply get evicted.
  */
-  void AWSCache::save_file(memcached_st* memc, const std::string& key, std::fstream* fstream, size_t size)
+  void AWSCache::save_file(memcached_st* memc, const std::string& key, std::fstream* fstream, size_t size, const std::string& etag)
   {
     memcached_return rc;
-    std::auto_ptr<char> memblock(new char [size]);
+    size_t chunks=(size+FILE_CHUNK_SIZE-1)/FILE_CHUNK_SIZE;
+    std::string generation=new_generation();
+    std::vector<char> memblock(FILE_CHUNK_SIZE);
 
     ASSERT(fstream);
     fstream->seekg(0,std::ios_base::beg);
 
-    fstream->read(memblock.get(),size);
-    ASSERT((unsigned int)fstream->gcount()==size);
+    // invalidate the old version before its chunks get replaced
+    delete_key(memc,key);
 
-    if(size==0){
-      rc=memcached_set(memc, key.c_str(), strlen(key.c_str()), "", 0,(time_t)0, (uint32_t)0);
-    }else{
-      rc=memcached_set(memc, key.c_str(), strlen(key.c_str()), memblock.get(), size,(time_t)0, (uint32_t)0);
+    memcached_behavior_set(memc, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 1);
+    bool lsuccess=true;
+    for(size_t i=0; i<chunks && lsuccess; ++i){
+      size_t lsize=(i==chunks-1)?size-i*FILE_CHUNK_SIZE:FILE_CHUNK_SIZE;
+      fstream->read(&memblock[0],lsize);
+      ASSERT((size_t)fstream->gcount()==lsize);
+
+      std::string chunkkey=get_chunkkey(key,generation,i);
+      rc=memcached_set(memc, chunkkey.c_str(), chunkkey.length(), &memblock[0], lsize,(time_t)0, (uint32_t)0);
+      lsuccess=(rc==MEMCACHED_SUCCESS || rc==MEMCACHED_BUFFERED);
+    }
+    if(lsuccess){
+      rc=memcached_flush_buffers(memc);
+      lsuccess=(rc==MEMCACHED_SUCCESS);
+    }
+    memcached_behavior_set(memc, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 0);
+
+    if(lsuccess){
+      std::stringstream manifest;
+      manifest << size << " " << chunks << " " << FILE_CHUNK_SIZE << " " << generation << " " << etag;
+      rc=memcached_set(memc, key.c_str(), key.length(), manifest.str().c_str(), manifest.str().length(),(time_t)0, (uint32_t)0);
+      lsuccess=(rc==MEMCACHED_SUCCESS);
     }
 
 #ifndef NDEBUG
-    if (rc == MEMCACHED_SUCCESS){
-      std::string lvalue(memblock.get());
-      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::save_cache_key_file(...)","   successfully stored file: '" << key << "'; size: " << size);// value: '"<<lvalue<<"'");
+    if (lsuccess){
+      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::save_cache_key_file(...)","   successfully stored file: '" << key << "'; size: " << size << "; chunks: " << chunks);
     }else{
       S3CACHE_LOG(S3CACHE_INFO,"AWSCache::save_cache_key_file(...)","    [ERROR] could not store file: '" << key << "' in cache (rc=" << (int) rc << ": "<< memcached_strerror(memc,rc) <<")");
     }
 #endif
   }
 
-void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t size)
+void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t size, const std::string& etag)
   {
     memcached_st* memc=NULL;
     try{
@@ -226,26 +298,26 @@ void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t s
 #ifdef CACHE_TEXT_FILES_ONLY
       // check if file type is known
          if(key.length()>3 && key.substr(key.length()-3,key.length()).compare(".xq")==0){
-            save_file(memc, key, fstream, size);
+            save_file(memc, key, fstream, size, etag);
          }else if(key.length()>4 && key.substr(key.length()-4,key.length()).compare(".xml")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()>4 && key.substr(key.length()-4,key.length()).compare(".txt")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()>5 && key.substr(key.length()-5,key.length()).compare(".fcgi")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()>4 && key.substr(key.length()-4,key.length()).compare(".cgi")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()>5 && key.substr(key.length()-5,key.length()).compare(".html")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()>4 && key.substr(key.length()-4,key.length()).compare(".htm")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else if(key.length()==9 && key.compare(".htaccess")==0){
-           save_file(memc, key, fstream, size);
+           save_file(memc, key, fstream, size, etag);
          }else{
            S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::save_file(...)","due to an unsupported file type: not caching file: '" << key << "'");
          }
 #else
-         save_file(memc, key, fstream, size);
+         save_file(memc, key, fstream, size, etag);
 #endif
       }else{
         S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::save_file(...)","not caching file, because it is too large '" << key << "' (size: " << size << ").");
@@ -261,6 +333,7 @@ void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t s
 
 /*
  * save a complete stat
+ * all attributes are packed into one value to make it a single round trip
  */
   void AWSCache::save_stat(struct stat* stbuf, const std::string& path)
   {
@@ -270,27 +343,33 @@ void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t s
     try{
        memc=get_Memcached_struct();
 
-       std::string key=getkey(PREFIX_STAT_ATTR,path,"mode");
-       save_key(memc, key, to_string(stbuf->st_mode));
+       std::string key=getkey(PREFIX_STAT_ATTR,path,"");
+       save_key(memc, key, pack_stat(stbuf));
 
-       key=getkey(PREFIX_STAT_ATTR,path,"gid").c_str();
-       save_key(memc, key,to_string(stbuf->st_gid));
+       free_Memcached_struct(memc);
+    }catch(...){
+      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::save_stat(...)","error saving file stat for file: '" << path << "'");
+      if(memc)free_Memcached_struct(memc);
+    }
+  }
 
-       key=getkey(PREFIX_STAT_ATTR,path,"oid").c_str();
-       save_key(memc, key,to_string(stbuf->st_uid));
 
-       key=getkey(PREFIX_STAT_ATTR,path,"mtime").c_str();
-       save_key(memc, key,time_to_string(stbuf->st_mtime));
+/*
+ * save existence flag and stat
+ */
+  void AWSCache::save_attr(struct stat* stbuf, const std::string& path)
+  {
+    memcached_st* memc=NULL;
 
-       key=getkey(PREFIX_STAT_ATTR,path,"size").c_str();
-       save_key(memc, key,to_string(stbuf->st_size));
+    try{
+       memc=get_Memcached_struct();
 
-       key=getkey(PREFIX_STAT_ATTR,path,"nlink").c_str();
-       save_key(memc, key,to_string(stbuf->st_nlink));
+       save_key(memc, getkey(PREFIX_EXISTS,path,""), "1");
+       save_key(memc, getkey(PREFIX_STAT_ATTR,path,""), pack_stat(stbuf));
 
        free_Memcached_struct(memc);
     }catch(...){
-      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::save_stat(...)","error saving file stat for file: '" << path << "'");
+      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::save_attr(...)","error saving attributes for file: '" << path << "'");
       if(memc)free_Memcached_struct(memc);
     }
   }
@@ -343,42 +422,87 @@ void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t s
 
 /*
  * read a cached file
+ * the chunks are fetched with a single multi get and written to their
+ * offset in the order they arrive
  */
-  void AWSCache::read_file(memcached_st* memc, const std::string& key, std::fstream* fstream, memcached_return* rc)
+  void AWSCache::read_file(memcached_st* memc, const std::string& key, std::fstream* fstream, memcached_return* rc, std::string* etag)
   {
-    uint32_t flags;
-    size_t value_length;
-    char* value;
-
     ASSERT(fstream);
 
-    value=memcached_get(memc, key.c_str(), strlen(key.c_str()),&value_length, &flags, rc);
+    std::string lmanifest=read_key(memc, key, rc);
+    if (*rc != MEMCACHED_SUCCESS){
+      return;
+    }
 
-    std::string lkey(key);
-    if (*rc == MEMCACHED_SUCCESS){
-      if(value!=NULL){
-        S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","successfully read cached file: '" << lkey << "'; size: " << value_length);
-        fstream->seekg(0,std::ios_base::beg);
-	fstream->write(value, value_length);
-        fstream->flush();
-      }else{
-      	S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","[WARNING] value is NULL.");
+    size_t size=0, chunks=0, chunksize=0;
+    std::string generation, letag;
+    std::istringstream manifest(lmanifest);
+    manifest >> size >> chunks >> chunksize >> generation;
+    if (manifest.fail() || chunksize==0 || chunks!=(size+chunksize-1)/chunksize){
+      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","[WARNING] invalid manifest for file: '" << key << "': " << lmanifest);
+      *rc=MEMCACHED_NOTFOUND;
+      return;
+    }
+    manifest >> letag;
+
+    std::vector<std::string> keys;
+    std::vector<const char*> lkeys;
+    std::vector<size_t> lkeylengths;
+    std::map<std::string, size_t> lchunks;
+    for(size_t i=0; i<chunks; ++i){
+      keys.push_back(get_chunkkey(key,generation,i));
+      lchunks[keys.back()]=i;
+    }
+    for(size_t i=0; i<chunks; ++i){
+      lkeys.push_back(keys[i].c_str());
+      lkeylengths.push_back(keys[i].length());
+    }
+
+    size_t lreceived=0;
+    if(chunks>0){
+      *rc=memcached_mget(memc, &lkeys[0], &lkeylengths[0], chunks);
+      if(*rc!=MEMCACHED_SUCCESS){
+        return;
+      }
+
+      char lkey[MEMCACHED_MAX_KEY];
+      size_t lkeylength;
+      size_t value_length;
+      uint32_t flags;
+      char* value;
+      memcached_return lrc;
+      while((value=memcached_fetch(memc, lkey, &lkeylength, &value_length, &flags, &lrc))!=NULL){
+        std::map<std::string, size_t>::iterator lIter=lchunks.find(std::string(lkey,lkeylength));
+        if(lrc==MEMCACHED_SUCCESS && lIter!=lchunks.end()){
+          fstream->seekp(lIter->second*chunksize,std::ios_base::beg);
+          fstream->write(value, value_length);
+          lchunks.erase(lIter);
+          ++lreceived;
+        }
+        free(value);
       }
     }
-#ifndef NDEBUG
-    else{
-      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","[WARNING] could not read file: '" << lkey << "' from cache (rc=" << (int) *rc << ": "<< memcached_strerror(memc,*rc) <<")");
+
+    std::string lkey(key);
+    if(lreceived==chunks){
+      fstream->flush();
+      if(etag) *etag=letag;
+      *rc=MEMCACHED_SUCCESS;
+      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","successfully read cached file: '" << lkey << "'; size: " << size << "; chunks: " << chunks);
+    }else{
+      // a partial set of chunks is a miss
+      *rc=MEMCACHED_NOTFOUND;
+      S3CACHE_LOG(S3CACHE_INFO,"AWSCache::read_file(...)","[WARNING] only " << lreceived << " of " << chunks << " chunks cached for file: '" << lkey << "'");
     }
-#endif
   }
 
 
-  void AWSCache::read_file(const std::string& key, std::fstream* fstream, memcached_return* rc)
+  void AWSCache::read_file(const std::string& key, std::fstream* fstream, memcached_return* rc, std::string* etag)
   {
     memcached_st* memc=NULL;
     try{
       memc=get_Memcached_struct();
-      read_file(memc, key, fstream, rc);
+      read_file(memc, key, fstream, rc, etag);
       free_Memcached_struct(memc);
     }catch(...){
       S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::read_file(...)","error reading file: '" << key << "'");
@@ -398,35 +522,132 @@ void AWSCache::save_file(const std::string& key, std::fstream* fstream, size_t s
        memc=get_Memcached_struct();
        memcached_return rc;
 
-       std::string key=getkey(PREFIX_STAT_ATTR,path,"mode");
-       stbuf->st_mode=atoi(read_key(memc, key, &rc).c_str());
+       std::string key=getkey(PREFIX_STAT_ATTR,path,"");
+       if(!unpack_stat(read_key(memc, key, &rc), stbuf)){
+         S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::read_stat(...)","no valid stat cached for: '" << path << "'");
+       }
 
-       key=getkey(PREFIX_STAT_ATTR,path,"gid");
-       stbuf->st_gid=atoi(read_key(memc, key, &rc).c_str());
+       free_Memcached_struct(memc);
+    }catch(...){
+      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::read_stat(...)","error reading file stat for: '" << path << "'");
+      if(memc)free_Memcached_struct(memc);
+    }
+  }
 
-       key=getkey(PREFIX_STAT_ATTR,path,"oid");
-       stbuf->st_uid=atoi(read_key(memc, key, &rc).c_str());
+/*
+ * read multiple keys
+ */
+  void AWSCache::read_keys(memcached_st* memc, const std::vector<std::string>& keys, std::map<std::string, std::string>& values)
+  {
+    if(keys.empty()) return;
 
-       key=getkey(PREFIX_STAT_ATTR,path,"mtime");
-       stbuf->st_mtime=AWSCache::string_to_time(read_key(memc, key, &rc).c_str());
+    std::vector<const char*> lkeys(keys.size());
+    std::vector<size_t> lkeylengths(keys.size());
+    for(size_t i=0; i<keys.size(); ++i){
+      lkeys[i]=keys[i].c_str();
+      lkeylengths[i]=keys[i].length();
+    }
 
-       key=getkey(PREFIX_STAT_ATTR,path,"size");
-       stbuf->st_size=atol(read_key(memc, key, &rc).c_str());
+    memcached_return rc=memcached_mget(memc, &lkeys[0], &lkeylengths[0], keys.size());
+    if(rc!=MEMCACHED_SUCCESS){
+      S3CACHE_LOG(S3CACHE_DEBUG,"AWSCache::read_keys(...)","[WARNING] mget failed (rc=" << (int) rc << ": "<< memcached_strerror(memc,rc) <<")");
+      return;
+    }
 
-       key=getkey(PREFIX_STAT_ATTR,path,"nlink");
-       stbuf->st_nlink=atol(read_key(memc, key, &rc).c_str());
+    // fetch until the end of the result set, otherwise the connection can't be reused
+    char lkey[MEMCACHED_MAX_KEY];
+    size_t lkeylength;
+    size_t value_length;
+    uint32_t flags;
+    char* value;
+    while((value=memcached_fetch(memc, lkey, &lkeylength, &value_length, &flags, &rc))!=NULL){
+      if(rc==MEMCACHED_SUCCESS){
+        values[std::string(lkey,lkeylength)]=std::string(value,value_length);
+      }
+      free(value);
+    }
+  }
 
-       free_Memcached_struct(memc);
+  void AWSCache::read_keys(const std::vector<std::string>& keys, std::map<std::string, std::string>& values)
+  {
+    memcached_st* memc=NULL;
+    try{
+      memc=get_Memcached_struct();
+      read_keys(memc, keys, values);
+      free_Memcached_struct(memc);
     }catch(...){
-      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::read_stat(...)","error reading file stat for: '" << path << "'");
+      S3CACHE_LOG(S3CACHE_ERROR,"AWSCache::read_keys(...)","error reading " << keys.size() << " keys");
       if(memc)free_Memcached_struct(memc);
     }
   }
 
+/*
+ * read existence flag and stat of a path
+ */
+  int AWSCache::read_attr(struct stat* stbuf, const std::string& path)
+  {
+    std::vector<std::string> keys;
+    std::map<std::string, std::string> values;
+    std::string existskey=getkey(PREFIX_EXISTS,path,"");
+    std::string statkey=getkey(PREFIX_STAT_ATTR,path,"");
+    keys.push_back(existskey);
+    keys.push_back(statkey);
+
+    read_keys(keys, values);
+
+    std::map<std::string, std::string>::iterator lIter=values.find(existskey);
+    if(lIter==values.end()){
+      return -1;
+    }else if(lIter->second.compare("0")==0){
+      return 0;
+    }else if(lIter->second.compare("1")==0){
+      lIter=values.find(statkey);
+      if(lIter!=values.end() && unpack_stat(lIter->second, stbuf)){
+        return 1;
+      }
+    }
+    // existent but without a stat -> treat as unknown
+    return -1;
+  }
+
+  std::string AWSCache::pack_stat(const struct stat* stbuf)
+  {
+    std::stringstream s;
+    s << stbuf->st_mode << " " << stbuf->st_gid << " " << stbuf->st_uid << " "
+      << (long long) stbuf->st_mtime << " " << (long long) stbuf->st_size << " " << stbuf->st_nlink;
+    return s.str();
+  }
+
+  bool AWSCache::unpack_stat(const std::string& value, struct stat* stbuf)
+  {
+    unsigned long lmode, lgid, luid, lnlink;
+    long long lmtime, lsize;
+    if(sscanf(value.c_str(), "%lu %lu %lu %lld %lld %lu", &lmode, &lgid, &luid, &lmtime, &lsize, &lnlink)!=6){
+      return false;
+    }
+    stbuf->st_mode=(mode_t)lmode;
+    stbuf->st_gid=(gid_t)lgid;
+    stbuf->st_uid=(uid_t)luid;
+    stbuf->st_mtime=(time_t)lmtime;
+    stbuf->st_size=(off_t)lsize;
+    stbuf->st_nlink=(nlink_t)lnlink;
+    return true;
+  }
+
 /*******************
  * MEMCACHED HELPERS
  *******************
  */
+  std::string AWSCache::get_chunkkey(const std::string& key, const std::string& generation, size_t chunk)
+  {
+    std::string result(key);
+    result.append("#");
+    result.append(generation);
+    result.append("#");
+    result.append(to_string(chunk));
+    return result;
+  }
+
   std::string AWSCache::getkey(std::string& prefix, std::string key, std::string attr)
   {
     std::string result="";
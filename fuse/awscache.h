@@ -22,12 +22,14 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <map>
 #include <fstream>
 #include <fuse.h>
 #include <string.h>
 #include <stdio.h>
 
 #include <libmemcached/memcached.h>
+#include <libmemcached/util.h>
 
 namespace aws { 
 
@@ -39,6 +41,10 @@ private:
   char* theServers;
   std::string theBucketname;
 
+  // master struct the pooled connections are cloned from
+  memcached_st* theMaster;
+  memcached_pool_st* thePool;
+
   void free_Memcached_struct(memcached_st * memc);
 
   memcached_st* get_Memcached_struct();
@@ -47,17 +53,31 @@ private:
 
   void save_key(memcached_st* memc, const std::string& key, const std::string& value);
 
-  void save_file(memcached_st* memc, const std::string& key, std::fstream* fstream, size_t size);
+  void save_file(memcached_st* memc, const std::string& key, std::fstream* fstream, size_t size, const std::string& etag);
 
   std::string read_key(memcached_st* memc, const std::string& key, memcached_return* rc);
 
-  void read_file(memcached_st* memc, const std::string& key, std::fstream* fstream, memcached_return* rc);
+  void read_file(memcached_st* memc, const std::string& key, std::fstream* fstream, memcached_return* rc, std::string* etag);
+
+  static std::string get_chunkkey(const std::string& key, const std::string& generation, size_t chunk);
+
+  void read_keys(memcached_st* memc, const std::vector<std::string>& keys, std::map<std::string, std::string>& values);
+
+  static std::string pack_stat(const struct stat* stbuf);
+
+  static bool unpack_stat(const std::string& value, struct stat* stbuf);
 
 public:
 
   // file size limit that is cached -> bigger files are never cached
   static unsigned int FILE_CACHING_UPPER_LIMIT;
 
+  // files are stored in chunks of this size (must be below the memcached item size limit)
+  static unsigned int FILE_CHUNK_SIZE;
+
+  // maximum number of memcached connections kept in the pool
+  static unsigned int CONNECTION_POOL_SIZE;
+
   static std::string PREFIX_EXISTS;
   static std::string PREFIX_STAT_ATTR;
   static std::string PREFIX_DIR_LS;
@@ -73,16 +93,38 @@ public:
 
   void save_key(const std::string& key, const std::string& value);
 
-  void save_file(const std::string& key, std::fstream* fstream, size_t size);
+  /**
+   * save a file as a manifest under key and a set of chunks
+   * the manifest remembers size, chunk count and the etag of the file
+   */
+  void save_file(const std::string& key, std::fstream* fstream, size_t size, const std::string& etag = "");
 
   void save_stat(struct stat* stbuf, const std::string& path);
 
+  // save the existence flag and the stat of a path using one connection
+  void save_attr(struct stat* stbuf, const std::string& path);
+
   std::string read_key(const std::string& key, memcached_return* rc);
 
-  void read_file(const std::string& key, std::fstream* fstream, memcached_return* rc);
+  /**
+   * read a cached file into fstream
+   * if one of the chunks is missing rc is set to MEMCACHED_NOTFOUND and
+   * the content of fstream is undefined
+   */
+  void read_file(const std::string& key, std::fstream* fstream, memcached_return* rc, std::string* etag = NULL);
 
   void read_stat(struct stat* stbuf, const std::string& path);
 
+  // read several keys with a single round trip, missing keys are not contained in values
+  void read_keys(const std::vector<std::string>& keys, std::map<std::string, std::string>& values);
+
+  /**
+   * read the existence flag and the stat of a path with a single round trip
+   * returns 1 if the path exists (stbuf is filled), 0 if it is known
+   * not to exist and -1 if the cache doesn't know the path
+   */
+  int read_attr(struct stat* stbuf, const std::string& path);
+
 /*******************
  * MEMCACHED HELPERS
  *******************
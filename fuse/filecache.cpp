@@ -0,0 +1,115 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "filecache.h"
+
+#include <stdio.h>
+#include <vector>
+
+namespace aws {
+
+FileCache::FileCache(unsigned int aMaxFiles, long long aMaxBytes)
+  : theMaxFiles(aMaxFiles),
+    theMaxBytes(aMaxBytes),
+    theBytes(0)
+{
+}
+
+FileCache::~FileCache()
+{
+  for (ItemMap::iterator lIter = theItems.begin(); lIter != theItems.end(); ++lIter)
+    remove(lIter->second.entry.filename.c_str());
+}
+
+bool
+FileCache::accepts(long long aSize) const
+{
+  return theMaxFiles > 0 && aSize <= theMaxBytes;
+}
+
+void
+FileCache::put(const std::string& aPath, const Entry& aEntry)
+{
+  std::vector<std::string> lEvicted;
+
+  if (!accepts(aEntry.size)) {
+    remove(aEntry.filename.c_str());
+    return;
+  }
+
+  theMutex.lock();
+  ItemMap::iterator lOld = theItems.find(aPath);
+  if (lOld != theItems.end())
+    lEvicted.push_back(erase(lOld));
+
+  while (!theLRU.empty()
+      && (theItems.size() >= theMaxFiles || theBytes + aEntry.size > theMaxBytes))
+    lEvicted.push_back(erase(theItems.find(theLRU.back())));
+
+  theLRU.push_front(aPath);
+  Item& lItem = theItems[aPath];
+  lItem.entry = aEntry;
+  lItem.position = theLRU.begin();
+  theBytes += aEntry.size;
+  theMutex.unlock();
+
+  // delete the files without holding the lock
+  for (std::vector<std::string>::iterator lIter = lEvicted.begin(); lIter != lEvicted.end(); ++lIter)
+    remove(lIter->c_str());
+}
+
+bool
+FileCache::take(const std::string& aPath, Entry* aEntry)
+{
+  bool lFound = false;
+
+  theMutex.lock();
+  ItemMap::iterator lIter = theItems.find(aPath);
+  if (lIter != theItems.end()) {
+    *aEntry = lIter->second.entry;
+    erase(lIter);
+    lFound = true;
+  }
+  theMutex.unlock();
+
+  return lFound;
+}
+
+void
+FileCache::invalidate(const std::string& aPath)
+{
+  std::string lFilename;
+
+  theMutex.lock();
+  ItemMap::iterator lIter = theItems.find(aPath);
+  if (lIter != theItems.end())
+    lFilename = erase(lIter);
+  theMutex.unlock();
+
+  if (!lFilename.empty())
+    remove(lFilename.c_str());
+}
+
+std::string
+FileCache::erase(ItemMap::iterator aItem)
+{
+  std::string lFilename = aItem->second.entry.filename;
+  theBytes -= aItem->second.entry.size;
+  theLRU.erase(aItem->second.position);
+  theItems.erase(aItem);
+  return lFilename;
+}
+
+} // namespace aws
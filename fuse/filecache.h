@@ -0,0 +1,87 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_FILECACHE
+#define AWS_S3FS_FILECACHE
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <libaws/mutex.h>
+
+namespace aws {
+
+/**
+ * Temp files of recently closed files.
+ *
+ * When a file is closed, its temp file is handed to this cache together
+ * with the ETag of the content. If the file is opened again, the temp
+ * file is taken out of the cache and only has to be revalidated with a
+ * conditional request instead of being downloaded again.
+ *
+ * The cache owns the files it holds, they are removed from disk if they
+ * are evicted (least recently closed first) or invalidated.
+ */
+class FileCache
+{
+public:
+  struct Entry {
+    std::string filename;
+    std::string etag;
+    long long   size;
+  };
+
+  FileCache(unsigned int aMaxFiles, long long aMaxBytes);
+
+  // removes all files that are still in the cache
+  ~FileCache();
+
+  // true if a file of the given size can be kept
+  bool accepts(long long aSize) const;
+
+  // hand the temp file of the path to the cache
+  void put(const std::string& aPath, const Entry& aEntry);
+
+  // take the temp file of the path out of the cache, the caller owns the file afterwards
+  bool take(const std::string& aPath, Entry* aEntry);
+
+  // remove the temp file of the path
+  void invalidate(const std::string& aPath);
+
+private:
+  typedef std::list<std::string> LRUList;
+
+  struct Item {
+    Entry             entry;
+    LRUList::iterator position;
+  };
+
+  typedef std::map<std::string, Item> ItemMap;
+
+  unsigned int theMaxFiles;
+  long long    theMaxBytes;
+  long long    theBytes;
+  ItemMap      theItems;
+  LRUList      theLRU;  // most recently closed first
+  AWSMutex     theMutex;
+
+  // removes the item from the cache and returns its file name, the mutex must be locked
+  std::string erase(ItemMap::iterator aItem);
+};
+
+} // namespace aws
+
+#endif
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "invalidationbus.h"
+
+#include <sstream>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <libaws/aws.h>
+
+namespace aws {
+
+InvalidationBus::InvalidationBus(const SQSConnectionPtr& aPublisher, const SQSConnectionPtr& aConsumer,
+                                 const std::string& aQueuePrefix, Handler aHandler)
+  : thePublisher(aPublisher),
+    theConsumer(aConsumer),
+    theQueuePrefix(aQueuePrefix),
+    theHandler(aHandler),
+    thePeersRefreshed(0),
+    theRunning(false)
+{
+  pthread_mutex_init(&theMutex, NULL);
+  pthread_cond_init(&theCondition, NULL);
+}
+
+InvalidationBus::~InvalidationBus()
+{
+  stop();
+  pthread_cond_destroy(&theCondition);
+  pthread_mutex_destroy(&theMutex);
+}
+
+void
+InvalidationBus::open()
+{
+  // <prefix>-<host>-<pid>, only alphanumeric characters, - and _ are allowed
+  char lHost[256];
+  if (gethostname(lHost, sizeof(lHost)) != 0)
+    lHost[0] = '\0';
+  lHost[sizeof(lHost) - 1] = '\0';
+
+  std::string lHostName;
+  for (const char* c = lHost; *c != '\0'; ++c) {
+    bool lValid = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')
+               || (*c >= '0' && *c <= '9') || *c == '-' || *c == '_';
+    lHostName += (lValid ? *c : '_');
+  }
+  std::ostringstream lPid;
+  lPid << "-" << getpid();
+
+  // the peers are found by the prefix and told apart by the pid,
+  // only the host name may be shortened
+  size_t lLength = theQueuePrefix.length() + 1 + lPid.str().length();
+  if (lLength > MAX_QUEUE_NAME_LENGTH)
+    throw AWSInitializationException("the invalidation queue prefix " + theQueuePrefix + " is too long");
+  if (lLength + lHostName.length() > MAX_QUEUE_NAME_LENGTH)
+    lHostName.resize(MAX_QUEUE_NAME_LENGTH - lLength);
+
+  std::string lQueueName = theQueuePrefix + "-" + lHostName + lPid.str();
+
+  CreateQueueResponsePtr lRes = thePublisher->createQueue(lQueueName);
+  theQueueUrl = lRes->getQueueUrl();
+  refreshPeers();
+}
+
+void
+InvalidationBus::start()
+{
+  pthread_mutex_lock(&theMutex);
+  if (theRunning || theQueueUrl.empty()) {
+    pthread_mutex_unlock(&theMutex);
+    return;
+  }
+  theRunning = true;
+  pthread_mutex_unlock(&theMutex);
+
+  pthread_create(&thePublisherThread, NULL, runPublisher, this);
+  pthread_create(&theConsumerThread, NULL, runConsumer, this);
+}
+
+void
+InvalidationBus::stop()
+{
+  pthread_mutex_lock(&theMutex);
+  bool lWasRunning = theRunning;
+  theRunning = false;
+  pthread_cond_broadcast(&theCondition);
+  pthread_mutex_unlock(&theMutex);
+
+  if (lWasRunning) {
+    pthread_join(thePublisherThread, NULL);
+    pthread_join(theConsumerThread, NULL);
+  }
+
+  if (!theQueueUrl.empty()) {
+    try {
+      thePublisher->deleteQueue(theQueueUrl);
+    } catch (AWSException&) {
+      // the queue stays behind and is removed from the peers of the
+      // other mounts as soon as sending to it fails
+    }
+    theQueueUrl.clear();
+  }
+}
+
+void
+InvalidationBus::publish(const std::string& aPath)
+{
+  pthread_mutex_lock(&theMutex);
+  if (theRunning)
+    thePending.insert(aPath);
+  pthread_mutex_unlock(&theMutex);
+}
+
+void*
+InvalidationBus::runPublisher(void* aBus)
+{
+  static_cast<InvalidationBus*>(aBus)->publishLoop();
+  return NULL;
+}
+
+void*
+InvalidationBus::runConsumer(void* aBus)
+{
+  static_cast<InvalidationBus*>(aBus)->consumeLoop();
+  return NULL;
+}
+
+void
+InvalidationBus::publishLoop()
+{
+  bool lRunning = true;
+  while (lRunning) {
+    lRunning = waitFor(FLUSH_INTERVAL);
+
+    // paths that are changed repeatedly within the interval are sent only once
+    std::set<std::string> lPaths;
+    pthread_mutex_lock(&theMutex);
+    lPaths.swap(thePending);
+    pthread_mutex_unlock(&theMutex);
+
+    if (!lPaths.empty())
+      flush(lPaths);
+  }
+}
+
+void
+InvalidationBus::consumeLoop()
+{
+  bool lRunning = true;
+  while (lRunning) {
+    bool lFailed = false;
+    try {
+      // long polling returns as soon as a message arrives, the wait is
+      // kept short because stop() has to wait for it
+      ReceiveMessageResponsePtr lRes = theConsumer->receiveMessage(theQueueUrl, 10, -1, true, POLL_WAIT);
+      lRes->open();
+      ReceiveMessageResponse::Message lMessage;
+      while (lRes->next(lMessage)) {
+        apply(std::string(lMessage.message_body, lMessage.message_size));
+        theConsumer->deleteMessage(theQueueUrl, lMessage.receipt_handle);
+      }
+      lRes->close();
+    } catch (AWSException&) {
+      // try again after the poll interval
+      lFailed = true;
+    }
+
+    lRunning = lFailed ? waitFor(POLL_INTERVAL) : isRunning();
+  }
+}
+
+void
+InvalidationBus::flush(const std::set<std::string>& aPaths)
+{
+  // one path per line, split into messages that don't exceed the size limit
+  std::vector<std::string> lMessages;
+  std::string lMessage;
+  for (std::set<std::string>::const_iterator lIter = aPaths.begin(); lIter != aPaths.end(); ++lIter) {
+    if (!lMessage.empty() && lMessage.length() + lIter->length() + 1 > MAX_MESSAGE_SIZE) {
+      lMessages.push_back(lMessage);
+      lMessage.clear();
+    }
+    if (!lMessage.empty())
+      lMessage.append("\n");
+    lMessage.append(*lIter);
+  }
+  if (!lMessage.empty())
+    lMessages.push_back(lMessage);
+
+  if (time(0) - thePeersRefreshed >= (time_t) PEER_REFRESH_INTERVAL) {
+    try {
+      refreshPeers();
+    } catch (AWSException&) {
+      // keep the peers we know
+    }
+  }
+
+  for (std::vector<std::string>::iterator lPeer = thePeers.begin(); lPeer != thePeers.end(); ) {
+    try {
+      for (std::vector<std::string>::iterator lIter = lMessages.begin(); lIter != lMessages.end(); ++lIter)
+        thePublisher->sendMessage(*lPeer, *lIter);
+      ++lPeer;
+    } catch (AWSException&) {
+      // the mount is probably gone, the next refresh finds it again if not
+      lPeer = thePeers.erase(lPeer);
+    }
+  }
+}
+
+void
+InvalidationBus::refreshPeers()
+{
+  std::vector<std::string> lPeers;
+  std::string lMarker = "/" + theQueuePrefix + "-";
+
+  ListQueuesResponsePtr lRes = thePublisher->listQueues(theQueuePrefix);
+  lRes->open();
+  std::string lUrl;
+  while (lRes->next(lUrl)) {
+    // the prefix may also match the queues of another bucket
+    if (lUrl != theQueueUrl && lUrl.find(lMarker) != std::string::npos)
+      lPeers.push_back(lUrl);
+  }
+  lRes->close();
+
+  thePeers.swap(lPeers);
+  thePeersRefreshed = time(0);
+}
+
+void
+InvalidationBus::apply(const std::string& aMessage)
+{
+  std::string::size_type lStart = 0;
+  while (lStart < aMessage.length()) {
+    std::string::size_type lEnd = aMessage.find('\n', lStart);
+    if (lEnd == std::string::npos)
+      lEnd = aMessage.length();
+    if (lEnd > lStart)
+      theHandler(aMessage.substr(lStart, lEnd - lStart));
+    lStart = lEnd + 1;
+  }
+}
+
+bool
+InvalidationBus::isRunning()
+{
+  pthread_mutex_lock(&theMutex);
+  bool lRunning = theRunning;
+  pthread_mutex_unlock(&theMutex);
+  return lRunning;
+}
+
+bool
+InvalidationBus::waitFor(unsigned int aSeconds)
+{
+  struct timeval lNow;
+  gettimeofday(&lNow, NULL);
+  struct timespec lTimeout;
+  lTimeout.tv_sec = lNow.tv_sec + aSeconds;
+  lTimeout.tv_nsec = lNow.tv_usec * 1000;
+
+  pthread_mutex_lock(&theMutex);
+  if (theRunning)
+    pthread_cond_timedwait(&theCondition, &theMutex, &lTimeout);
+  bool lRunning = theRunning;
+  pthread_mutex_unlock(&theMutex);
+  return lRunning;
+}
+
+} // namespace aws
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_INVALIDATIONBUS
+#define AWS_S3FS_INVALIDATIONBUS
+
+#include <set>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <pthread.h>
+
+#include <libaws/common.h>
+
+namespace aws {
+
+/**
+ * Channel that tells the other mounts of a bucket which paths have changed.
+ *
+ * Every mount owns an SQS queue whose name starts with a common prefix.
+ * Changed paths are collected and sent in batches to the queues of all
+ * other mounts by a publisher thread. A consumer thread receives the
+ * paths sent to the own queue and passes them to the handler, which
+ * removes them from the local caches.
+ *
+ * Failures to send or receive are ignored, the caches then fall back
+ * to their time to live.
+ */
+class InvalidationBus
+{
+public:
+  typedef void (*Handler)(const std::string& aPath);
+
+  // the connections must not be used by anyone else
+  InvalidationBus(const SQSConnectionPtr& aPublisher, const SQSConnectionPtr& aConsumer,
+                  const std::string& aQueuePrefix, Handler aHandler);
+
+  ~InvalidationBus();
+
+  // creates the queue of this mount, throws an AWSException on failure
+  // or if the prefix leaves no room for the pid in the queue name
+  void open();
+
+  // starts the publisher and consumer threads
+  void start();
+
+  // sends the pending paths, stops the threads and deletes the queue of this mount
+  void stop();
+
+  // tell the other mounts that the path has changed
+  void publish(const std::string& aPath);
+
+  const std::string& getQueueUrl() const { return theQueueUrl; }
+
+private:
+  static const unsigned int FLUSH_INTERVAL = 1;          // seconds
+  static const unsigned int POLL_INTERVAL = 1;           // seconds, after a failed receive
+  static const int          POLL_WAIT = 5;               // seconds a receive waits for messages
+  static const unsigned int PEER_REFRESH_INTERVAL = 60;  // seconds
+  static const size_t       MAX_MESSAGE_SIZE = 6144;     // bytes before base64 encoding
+  static const size_t       MAX_QUEUE_NAME_LENGTH = 80;
+
+  SQSConnectionPtr         thePublisher;
+  SQSConnectionPtr         theConsumer;
+  std::string              theQueuePrefix;
+  std::string              theQueueUrl;
+  Handler                  theHandler;
+
+  std::set<std::string>    thePending;
+  std::vector<std::string> thePeers;
+  time_t                   thePeersRefreshed;
+
+  bool                     theRunning;
+  pthread_mutex_t          theMutex;
+  pthread_cond_t           theCondition;
+  pthread_t                thePublisherThread;
+  pthread_t                theConsumerThread;
+
+  static void* runPublisher(void* aBus);
+  static void* runConsumer(void* aBus);
+
+  void publishLoop();
+  void consumeLoop();
+
+  void flush(const std::set<std::string>& aPaths);
+  void refreshPeers();
+  void apply(const std::string& aMessage);
+
+  bool isRunning();
+
+  // waits until the time is over or the bus is stopped, returns false if stopped
+  bool waitFor(unsigned int aSeconds);
+};
+
+} // namespace aws
+
+#endif
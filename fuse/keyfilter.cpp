@@ -0,0 +1,210 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "keyfilter.h"
+
+#include <math.h>
+#include <sys/time.h>
+
+namespace aws {
+
+BloomFilter::BloomFilter(size_t aExpectedItems, double aFalsePositiveRate)
+  : theNumberOfItems(0)
+{
+  if (aExpectedItems == 0)
+    aExpectedItems = 1;
+
+  // m = -n ln(p) / ln(2)^2, k = m/n ln(2)
+  double lBits = -(double) aExpectedItems * log(aFalsePositiveRate) / (M_LN2 * M_LN2);
+  theNumberOfBits = (uint64_t) lBits < 64 ? 64 : (uint64_t) lBits;
+  theNumberOfHashes = (unsigned int) (lBits / aExpectedItems * M_LN2 + 0.5);
+  if (theNumberOfHashes < 1)
+    theNumberOfHashes = 1;
+  if (theNumberOfHashes > 16)
+    theNumberOfHashes = 16;
+
+  theBits.resize((theNumberOfBits + 63) / 64, 0);
+}
+
+void
+BloomFilter::hash(const std::string& aKey, uint64_t* aHash1, uint64_t* aHash2)
+{
+  // FNV-1a
+  uint64_t lHash = 14695981039346656037ULL;
+  for (std::string::size_type i = 0; i < aKey.length(); ++i) {
+    lHash ^= (unsigned char) aKey[i];
+    lHash *= 1099511628211ULL;
+  }
+  *aHash1 = lHash;
+
+  // derive the second hash with the splitmix64 finalizer, it must be odd
+  lHash ^= lHash >> 30;
+  lHash *= 0xbf58476d1ce4e5b9ULL;
+  lHash ^= lHash >> 27;
+  lHash *= 0x94d049bb133111ebULL;
+  lHash ^= lHash >> 31;
+  *aHash2 = lHash | 1;
+}
+
+void
+BloomFilter::add(const std::string& aKey)
+{
+  uint64_t lHash1, lHash2;
+  hash(aKey, &lHash1, &lHash2);
+  for (unsigned int i = 0; i < theNumberOfHashes; ++i) {
+    uint64_t lBit = (lHash1 + i * lHash2) % theNumberOfBits;
+    theBits[lBit / 64] |= (uint64_t) 1 << (lBit % 64);
+  }
+  ++theNumberOfItems;
+}
+
+bool
+BloomFilter::mightContain(const std::string& aKey) const
+{
+  uint64_t lHash1, lHash2;
+  hash(aKey, &lHash1, &lHash2);
+  for (unsigned int i = 0; i < theNumberOfHashes; ++i) {
+    uint64_t lBit = (lHash1 + i * lHash2) % theNumberOfBits;
+    if ((theBits[lBit / 64] & ((uint64_t) 1 << (lBit % 64))) == 0)
+      return false;
+  }
+  return true;
+}
+
+const double KeyFilter::FALSE_POSITIVE_RATE = 0.01;
+
+KeyFilter::KeyFilter(Lister aLister, unsigned int aInterval)
+  : theLister(aLister),
+    theInterval(aInterval),
+    theFilter(NULL),
+    theRebuilding(false),
+    theLastCount(0),
+    theRunning(false)
+{
+  pthread_mutex_init(&theMutex, NULL);
+  pthread_cond_init(&theCondition, NULL);
+}
+
+KeyFilter::~KeyFilter()
+{
+  stop();
+  delete theFilter;
+  pthread_cond_destroy(&theCondition);
+  pthread_mutex_destroy(&theMutex);
+}
+
+bool
+KeyFilter::mightExist(const std::string& aKey)
+{
+  pthread_mutex_lock(&theMutex);
+  bool lResult = theFilter == NULL || theFilter->mightContain(aKey);
+  pthread_mutex_unlock(&theMutex);
+  return lResult;
+}
+
+void
+KeyFilter::add(const std::string& aKey)
+{
+  pthread_mutex_lock(&theMutex);
+  if (theFilter)
+    theFilter->add(aKey);
+  if (theRebuilding)
+    theAdded.push_back(aKey);
+  pthread_mutex_unlock(&theMutex);
+}
+
+void
+KeyFilter::start()
+{
+  pthread_mutex_lock(&theMutex);
+  if (theRunning) {
+    pthread_mutex_unlock(&theMutex);
+    return;
+  }
+  theRunning = true;
+  pthread_mutex_unlock(&theMutex);
+
+  pthread_create(&theThread, NULL, run, this);
+}
+
+void
+KeyFilter::stop()
+{
+  pthread_mutex_lock(&theMutex);
+  bool lWasRunning = theRunning;
+  theRunning = false;
+  pthread_cond_broadcast(&theCondition);
+  pthread_mutex_unlock(&theMutex);
+
+  if (lWasRunning)
+    pthread_join(theThread, NULL);
+}
+
+void*
+KeyFilter::run(void* aFilter)
+{
+  KeyFilter* lFilter = static_cast<KeyFilter*>(aFilter);
+
+  pthread_mutex_lock(&lFilter->theMutex);
+  while (lFilter->theRunning) {
+    pthread_mutex_unlock(&lFilter->theMutex);
+    lFilter->rebuild();
+    pthread_mutex_lock(&lFilter->theMutex);
+
+    if (!lFilter->theRunning)
+      break;
+
+    struct timeval lNow;
+    gettimeofday(&lNow, NULL);
+    struct timespec lTimeout;
+    lTimeout.tv_sec = lNow.tv_sec + lFilter->theInterval;
+    lTimeout.tv_nsec = lNow.tv_usec * 1000;
+    pthread_cond_timedwait(&lFilter->theCondition, &lFilter->theMutex, &lTimeout);
+  }
+  pthread_mutex_unlock(&lFilter->theMutex);
+  return NULL;
+}
+
+void
+KeyFilter::rebuild()
+{
+  pthread_mutex_lock(&theMutex);
+  // leave some room for growth until the next rebuild
+  size_t lExpected = theLastCount + theLastCount / 4;
+  if (lExpected < MIN_EXPECTED_ITEMS)
+    lExpected = MIN_EXPECTED_ITEMS;
+  theRebuilding = true;
+  theAdded.clear();
+  pthread_mutex_unlock(&theMutex);
+
+  BloomFilter* lFilter = new BloomFilter(lExpected, FALSE_POSITIVE_RATE);
+  bool lSuccess = theLister(lFilter);
+
+  pthread_mutex_lock(&theMutex);
+  if (lSuccess) {
+    // keys that were created while listing might be missing
+    for (std::vector<std::string>::iterator lIter = theAdded.begin(); lIter != theAdded.end(); ++lIter)
+      lFilter->add(*lIter);
+    theLastCount = lFilter->getNumberOfItems();
+    std::swap(theFilter, lFilter);
+  }
+  theRebuilding = false;
+  theAdded.clear();
+  pthread_mutex_unlock(&theMutex);
+
+  delete lFilter;
+}
+
+} // namespace aws
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_KEYFILTER
+#define AWS_S3FS_KEYFILTER
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+namespace aws {
+
+/**
+ * Bloom filter over strings.
+ *
+ * mightContain never returns false for a string that was added, but may
+ * return true for strings that weren't (with the given probability if
+ * no more than the expected number of items are added).
+ */
+class BloomFilter
+{
+public:
+  BloomFilter(size_t aExpectedItems, double aFalsePositiveRate);
+
+  void add(const std::string& aKey);
+
+  bool mightContain(const std::string& aKey) const;
+
+  size_t getNumberOfItems() const { return theNumberOfItems; }
+
+private:
+  std::vector<uint64_t> theBits;
+  uint64_t              theNumberOfBits;
+  unsigned int          theNumberOfHashes;
+  size_t                theNumberOfItems;
+
+  static void hash(const std::string& aKey, uint64_t* aHash1, uint64_t* aHash2);
+};
+
+/**
+ * Knows which keys definitely don't exist in the bucket.
+ *
+ * A background thread lists the whole bucket every interval and builds a
+ * new bloom filter of all keys. Keys created locally (or reported by other
+ * mounts) are added to the filter right away, also while a new filter is
+ * built. Keys that are deleted stay in the filter until the next rebuild,
+ * which only costs a request.
+ *
+ * Until the first listing has finished every key might exist.
+ */
+class KeyFilter
+{
+public:
+  // adds the keys of all objects in the bucket to the filter, returns false on failure
+  typedef bool (*Lister)(BloomFilter* aFilter);
+
+  KeyFilter(Lister aLister, unsigned int aInterval);
+
+  ~KeyFilter();
+
+  // false if the key definitely doesn't exist
+  bool mightExist(const std::string& aKey);
+
+  // the key was created
+  void add(const std::string& aKey);
+
+  // starts the thread that rebuilds the filter
+  void start();
+
+  void stop();
+
+private:
+  static const double FALSE_POSITIVE_RATE;
+  static const size_t MIN_EXPECTED_ITEMS = 1024 * 1024;
+
+  Lister                   theLister;
+  unsigned int             theInterval;  // seconds
+  BloomFilter*             theFilter;
+  bool                     theRebuilding;
+  std::vector<std::string> theAdded;     // keys added during a rebuild
+  size_t                   theLastCount;
+
+  bool                     theRunning;
+  pthread_t                theThread;
+  pthread_mutex_t          theMutex;
+  pthread_cond_t           theCondition;
+
+  static void* run(void* aFilter);
+
+  void rebuild();
+};
+
+} // namespace aws
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "namespaceindex.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace aws {
+
+/*
+ * Layout of the file: the header, the records sorted by key, and the
+ * strings (the bucket name, the keys and the ETags) the records point to.
+ * All numbers are in the byte order of the host.
+ */
+struct NamespaceIndex::Header {
+  char     magic[8];
+  uint64_t numberOfRecords;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+  uint32_t bucketLength;  // the bucket name is the first string
+  uint32_t recordSize;
+};
+
+struct NamespaceIndex::Record {
+  uint64_t keyOffset;
+  uint64_t etagOffset;
+  uint32_t keyLength;
+  uint32_t etagLength;
+  int64_t  size;
+  int64_t  mtime;
+  uint32_t mode;
+  uint32_t uid;
+  uint32_t gid;
+  uint32_t nlink;
+};
+
+static const char INDEX_MAGIC[8] = { 'S', '3', 'F', 'S', 'I', 'D', 'X', '1' };
+
+// the ETags of the listing are quoted, the ones of the responses are not always
+static std::string
+unquote(const std::string& aETag)
+{
+  if (aETag.length() >= 2 && aETag[0] == '"' && aETag[aETag.length() - 1] == '"')
+    return aETag.substr(1, aETag.length() - 2);
+  return aETag;
+}
+
+NamespaceIndex::NamespaceIndex(const std::string& aFileName, const std::string& aBucketName,
+                               Lister aLister)
+  : theFileName(aFileName),
+    theBucketName(aBucketName),
+    theLister(aLister),
+    theData(NULL),
+    theSize(0),
+    theRecords(NULL),
+    theNumberOfRecords(0),
+    theStrings(NULL),
+    theValidated(false),
+    theRunning(false)
+{
+  pthread_mutex_init(&theMutex, NULL);
+}
+
+NamespaceIndex::~NamespaceIndex()
+{
+  stop();
+  close();
+  pthread_mutex_destroy(&theMutex);
+}
+
+bool
+NamespaceIndex::open()
+{
+  int lFile = ::open(theFileName.c_str(), O_RDONLY);
+  if (lFile < 0)
+    return false;
+
+  struct stat lStat;
+  if (fstat(lFile, &lStat) != 0 || (size_t) lStat.st_size < sizeof(Header)) {
+    ::close(lFile);
+    return false;
+  }
+
+  void* lData = mmap(NULL, lStat.st_size, PROT_READ, MAP_SHARED, lFile, 0);
+  ::close(lFile);
+  if (lData == MAP_FAILED)
+    return false;
+
+  theData = static_cast<char*>(lData);
+  theSize = lStat.st_size;
+
+  // check everything, the records are used without further checks
+  const Header* lHeader = reinterpret_cast<const Header*>(theData);
+  bool lValid = memcmp(lHeader->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+    && lHeader->recordSize == sizeof(Record)
+    && lHeader->numberOfRecords <= (theSize - sizeof(Header)) / sizeof(Record)
+    && lHeader->stringsOffset >= sizeof(Header) + lHeader->numberOfRecords * sizeof(Record)
+    && lHeader->stringsOffset <= theSize
+    && lHeader->stringsSize <= theSize - lHeader->stringsOffset
+    && lHeader->bucketLength <= lHeader->stringsSize;
+
+  if (lValid) {
+    theRecords = reinterpret_cast<const Record*>(theData + sizeof(Header));
+    theNumberOfRecords = lHeader->numberOfRecords;
+    theStrings = theData + lHeader->stringsOffset;
+    lValid = theBucketName == std::string(theStrings, lHeader->bucketLength);
+  }
+
+  for (size_t i = 0; lValid && i < theNumberOfRecords; ++i) {
+    const Record& lRecord = theRecords[i];
+    lValid = lRecord.keyOffset <= lHeader->stringsSize
+      && lRecord.keyLength <= lHeader->stringsSize - lRecord.keyOffset
+      && lRecord.etagOffset <= lHeader->stringsSize
+      && lRecord.etagLength <= lHeader->stringsSize - lRecord.etagOffset
+      && (i == 0 || getKey(theRecords[i - 1]) < getKey(lRecord));
+  }
+
+  if (!lValid) {
+    close();
+    return false;
+  }
+
+  theValid.assign(theNumberOfRecords, false);
+  return true;
+}
+
+void
+NamespaceIndex::close()
+{
+  if (theData)
+    munmap(theData, theSize);
+  theData = NULL;
+  theSize = 0;
+  theRecords = NULL;
+  theNumberOfRecords = 0;
+  theStrings = NULL;
+  theValid.clear();
+}
+
+void
+NamespaceIndex::start()
+{
+  pthread_mutex_lock(&theMutex);
+  if (theRunning) {
+    pthread_mutex_unlock(&theMutex);
+    return;
+  }
+  theRunning = true;
+  pthread_mutex_unlock(&theMutex);
+
+  pthread_create(&theThread, NULL, run, this);
+}
+
+void
+NamespaceIndex::stop()
+{
+  pthread_mutex_lock(&theMutex);
+  bool lWasRunning = theRunning;
+  theRunning = false;
+  pthread_mutex_unlock(&theMutex);
+
+  if (lWasRunning)
+    pthread_join(theThread, NULL);
+}
+
+void*
+NamespaceIndex::run(void* aIndex)
+{
+  NamespaceIndex* lIndex = static_cast<NamespaceIndex*>(aIndex);
+
+  // nothing mapped -> nothing to validate, the index is filled by put
+  bool lSuccess = lIndex->theNumberOfRecords == 0
+    || (lIndex->theLister(lIndex) && lIndex->isRunning());
+
+  pthread_mutex_lock(&lIndex->theMutex);
+  lIndex->theValidated = lSuccess;
+  pthread_mutex_unlock(&lIndex->theMutex);
+  return NULL;
+}
+
+std::string
+NamespaceIndex::getKey(const Record& aRecord) const
+{
+  return std::string(theStrings + aRecord.keyOffset, aRecord.keyLength);
+}
+
+std::string
+NamespaceIndex::getETag(const Record& aRecord) const
+{
+  return std::string(theStrings + aRecord.etagOffset, aRecord.etagLength);
+}
+
+long
+NamespaceIndex::find(const std::string& aKey) const
+{
+  size_t lLow = 0;
+  size_t lHigh = theNumberOfRecords;
+  while (lLow < lHigh) {
+    size_t lMiddle = lLow + (lHigh - lLow) / 2;
+    const Record& lRecord = theRecords[lMiddle];
+    size_t lLength = lRecord.keyLength < aKey.length() ? lRecord.keyLength : aKey.length();
+    int lCompare = memcmp(theStrings + lRecord.keyOffset, aKey.data(), lLength);
+    if (lCompare == 0)
+      lCompare = lRecord.keyLength < aKey.length() ? -1 : (lRecord.keyLength > aKey.length() ? 1 : 0);
+    if (lCompare == 0)
+      return lMiddle;
+    if (lCompare < 0)
+      lLow = lMiddle + 1;
+    else
+      lHigh = lMiddle;
+  }
+  return -1;
+}
+
+void
+NamespaceIndex::validate(const std::string& aKey, const std::string& aETag)
+{
+  long lPos = find(aKey);
+  if (lPos < 0 || getETag(theRecords[lPos]) != unquote(aETag))
+    return;
+
+  pthread_mutex_lock(&theMutex);
+  theValid[lPos] = true;
+  pthread_mutex_unlock(&theMutex);
+}
+
+bool
+NamespaceIndex::isRunning()
+{
+  pthread_mutex_lock(&theMutex);
+  bool lRunning = theRunning;
+  pthread_mutex_unlock(&theMutex);
+  return lRunning;
+}
+
+bool
+NamespaceIndex::lookup(const std::string& aKey, struct stat* aStat)
+{
+  bool lFound = false;
+
+  pthread_mutex_lock(&theMutex);
+  EntryMap::iterator lIter = theEntries.find(aKey);
+  if (lIter != theEntries.end()) {
+    if (!lIter->second.removed) {
+      memcpy(aStat, &lIter->second.stbuf, sizeof(struct stat));
+      lFound = true;
+    }
+  } else if (theValidated) {
+    long lPos = find(aKey);
+    if (lPos >= 0 && theValid[lPos]) {
+      const Record& lRecord = theRecords[lPos];
+      memset(aStat, 0, sizeof(struct stat));
+      aStat->st_size  = lRecord.size;
+      aStat->st_mtime = lRecord.mtime;
+      aStat->st_mode  = lRecord.mode;
+      aStat->st_uid   = lRecord.uid;
+      aStat->st_gid   = lRecord.gid;
+      aStat->st_nlink = lRecord.nlink;
+      lFound = true;
+    }
+  }
+  pthread_mutex_unlock(&theMutex);
+
+  return lFound;
+}
+
+void
+NamespaceIndex::put(const std::string& aKey, const struct stat* aStat, const std::string& aETag)
+{
+  Entry lEntry;
+  memcpy(&lEntry.stbuf, aStat, sizeof(struct stat));
+  lEntry.etag = unquote(aETag);
+  lEntry.removed = false;
+
+  pthread_mutex_lock(&theMutex);
+  theEntries[aKey] = lEntry;
+  pthread_mutex_unlock(&theMutex);
+}
+
+void
+NamespaceIndex::remove(const std::string& aKey)
+{
+  Entry lEntry;
+  memset(&lEntry.stbuf, 0, sizeof(struct stat));
+  lEntry.removed = true;
+
+  pthread_mutex_lock(&theMutex);
+  theEntries[aKey] = lEntry;
+  pthread_mutex_unlock(&theMutex);
+}
+
+bool
+NamespaceIndex::write()
+{
+  // merge the valid records with the entries of this mount,
+  // if the listing didn't complete all records are kept to be validated next time
+  EntryMap lEntries;
+  pthread_mutex_lock(&theMutex);
+  for (size_t i = 0; i < theNumberOfRecords; ++i) {
+    if (theValidated && !theValid[i])
+      continue;
+    const Record& lRecord = theRecords[i];
+    Entry& lEntry = lEntries[getKey(lRecord)];
+    memset(&lEntry.stbuf, 0, sizeof(struct stat));
+    lEntry.stbuf.st_size  = lRecord.size;
+    lEntry.stbuf.st_mtime = lRecord.mtime;
+    lEntry.stbuf.st_mode  = lRecord.mode;
+    lEntry.stbuf.st_uid   = lRecord.uid;
+    lEntry.stbuf.st_gid   = lRecord.gid;
+    lEntry.stbuf.st_nlink = lRecord.nlink;
+    lEntry.etag = getETag(lRecord);
+    lEntry.removed = false;
+  }
+  for (EntryMap::iterator lIter = theEntries.begin(); lIter != theEntries.end(); ++lIter) {
+    if (lIter->second.removed)
+      lEntries.erase(lIter->first);
+    else
+      lEntries[lIter->first] = lIter->second;
+  }
+  pthread_mutex_unlock(&theMutex);
+
+  std::vector<Record> lRecords;
+  std::string lStrings = theBucketName;
+  lRecords.reserve(lEntries.size());
+  for (EntryMap::iterator lIter = lEntries.begin(); lIter != lEntries.end(); ++lIter) {
+    Record lRecord;
+    memset(&lRecord, 0, sizeof(Record));
+    lRecord.keyOffset  = lStrings.length();
+    lRecord.keyLength  = lIter->first.length();
+    lStrings.append(lIter->first);
+    lRecord.etagOffset = lStrings.length();
+    lRecord.etagLength = lIter->second.etag.length();
+    lStrings.append(lIter->second.etag);
+    lRecord.size  = lIter->second.stbuf.st_size;
+    lRecord.mtime = lIter->second.stbuf.st_mtime;
+    lRecord.mode  = lIter->second.stbuf.st_mode;
+    lRecord.uid   = lIter->second.stbuf.st_uid;
+    lRecord.gid   = lIter->second.stbuf.st_gid;
+    lRecord.nlink = lIter->second.stbuf.st_nlink;
+    lRecords.push_back(lRecord);
+  }
+
+  Header lHeader;
+  memset(&lHeader, 0, sizeof(Header));
+  memcpy(lHeader.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  lHeader.numberOfRecords = lRecords.size();
+  lHeader.stringsOffset   = sizeof(Header) + lRecords.size() * sizeof(Record);
+  lHeader.stringsSize     = lStrings.length();
+  lHeader.bucketLength    = theBucketName.length();
+  lHeader.recordSize      = sizeof(Record);
+
+  // write a new file and replace the old one, the mapping stays valid
+  std::string lTempName = theFileName + ".tmp";
+  FILE* lFile = fopen(lTempName.c_str(), "wb");
+  if (!lFile)
+    return false;
+
+  bool lSuccess = fwrite(&lHeader, sizeof(Header), 1, lFile) == 1
+    && (lRecords.empty() || fwrite(&lRecords[0], sizeof(Record), lRecords.size(), lFile) == lRecords.size())
+    && (lStrings.empty() || fwrite(lStrings.data(), lStrings.length(), 1, lFile) == 1);
+  lSuccess = fclose(lFile) == 0 && lSuccess;
+
+  if (!lSuccess || rename(lTempName.c_str(), theFileName.c_str()) != 0) {
+    unlink(lTempName.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace aws
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_NAMESPACEINDEX
+#define AWS_S3FS_NAMESPACEINDEX
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <pthread.h>
+
+namespace aws {
+
+/**
+ * On-disk index of the attributes of all paths that were looked up, kept
+ * from one mount to the next.
+ *
+ * The index file holds the keys sorted, each with the attributes and the
+ * ETag of the object. When a mount starts the file of the previous mount
+ * is mapped into memory and a background thread lists the bucket. Only
+ * records whose ETag matches the listing are used to answer lookups, and
+ * only after the listing is complete; all other records are dropped.
+ *
+ * Attributes learned during the mount are kept in memory and merged into
+ * the file that is written by write() (e.g. at unmount).
+ */
+class NamespaceIndex
+{
+public:
+  // calls validate for all objects in the bucket, returns false on failure
+  typedef bool (*Lister)(NamespaceIndex* aIndex);
+
+  NamespaceIndex(const std::string& aFileName, const std::string& aBucketName, Lister aLister);
+
+  ~NamespaceIndex();
+
+  // maps the file written by the previous mount, false if there is none or it is invalid
+  bool open();
+
+  // starts the thread that validates the mapped records
+  void start();
+
+  void stop();
+
+  // false once stop was called, the lister should give up
+  bool isRunning();
+
+  // the object was listed, the record of the key is used if it has the same ETag
+  void validate(const std::string& aKey, const std::string& aETag);
+
+  // copies the attributes of the key into aStat if they are known
+  bool lookup(const std::string& aKey, struct stat* aStat);
+
+  // remember the attributes of a key
+  void put(const std::string& aKey, const struct stat* aStat, const std::string& aETag);
+
+  // the key was changed or deleted
+  void remove(const std::string& aKey);
+
+  // writes all valid records to the file
+  bool write();
+
+  size_t getNumberOfRecords() const { return theNumberOfRecords; }
+
+private:
+  struct Header;
+  struct Record;
+
+  struct Entry {
+    struct stat stbuf;
+    std::string etag;
+    bool        removed;
+  };
+
+  typedef std::map<std::string, Entry> EntryMap;
+
+  std::string       theFileName;
+  std::string       theBucketName;
+  Lister            theLister;
+
+  // the mapped file
+  char*             theData;
+  size_t            theSize;
+  const Record*     theRecords;
+  size_t            theNumberOfRecords;
+  const char*       theStrings;
+
+  std::vector<bool> theValid;      // records whose ETag matched the listing
+  bool              theValidated;  // the listing is complete
+  EntryMap          theEntries;    // learned during this mount, override the records
+
+  bool              theRunning;
+  pthread_t         theThread;
+  pthread_mutex_t   theMutex;
+
+  static void* run(void* aIndex);
+
+  // the position of the key in the records or -1
+  long find(const std::string& aKey) const;
+
+  std::string getKey(const Record& aRecord) const;
+
+  std::string getETag(const Record& aRecord) const;
+
+  void close();
+};
+
+} // namespace aws
+
+#endif
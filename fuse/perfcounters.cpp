@@ -0,0 +1,153 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "perfcounters.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string.h>
+#include <time.h>
+
+namespace aws {
+
+static const char* OPERATION_NAMES[PerfCounters::NUMBER_OF_OPERATIONS] = {
+  "getattr", "readlink", "mkdir", "unlink", "rmdir", "symlink", "truncate",
+  "open", "read", "write", "release", "opendir", "readdir", "create"
+};
+
+static const char* COUNTER_NAMES[PerfCounters::NUMBER_OF_COUNTERS] = {
+  "stat_cache_hits", "stat_cache_misses", "key_filter_negatives", "namespace_index_hits",
+  "memcached_hits", "memcached_misses", "file_cache_revalidated", "file_cache_stale",
+  "shared_opens", "bytes_downloaded", "bytes_uploaded", "request_errors", "pool_overflows"
+};
+
+static const char* GAUGE_NAMES[PerfCounters::NUMBER_OF_GAUGES] = {
+  "connections_in_use", "downloads_in_flight", "uploads_in_flight"
+};
+
+static const char* BUCKET_NAMES[PerfCounters::NUMBER_OF_BUCKETS] = {
+  "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"
+};
+
+static long long
+now()
+{
+  struct timespec lNow;
+  clock_gettime(CLOCK_MONOTONIC, &lNow);
+  return (long long) lNow.tv_sec * 1000000 + lNow.tv_nsec / 1000;
+}
+
+PerfCounters::PerfCounters()
+{
+  memset(theCalls, 0, sizeof(theCalls));
+  memset(theLatency, 0, sizeof(theLatency));
+  memset(theHistogram, 0, sizeof(theHistogram));
+  memset(theCounters, 0, sizeof(theCounters));
+  memset(theGauges, 0, sizeof(theGauges));
+}
+
+void
+PerfCounters::record(Operation aOperation, long long aMicroseconds)
+{
+  unsigned int lBucket = 0;
+  for (long long lLimit = 10; lBucket < NUMBER_OF_BUCKETS - 1 && aMicroseconds >= lLimit; lLimit *= 10)
+    ++lBucket;
+
+  __sync_fetch_and_add(&theCalls[aOperation], 1);
+  __sync_fetch_and_add(&theLatency[aOperation], aMicroseconds);
+  __sync_fetch_and_add(&theHistogram[aOperation][lBucket], 1);
+}
+
+void
+PerfCounters::add(Counter aCounter, long long aValue)
+{
+  __sync_fetch_and_add(&theCounters[aCounter], aValue);
+}
+
+long long
+PerfCounters::increment(Gauge aGauge)
+{
+  return __sync_add_and_fetch(&theGauges[aGauge], 1);
+}
+
+void
+PerfCounters::decrement(Gauge aGauge)
+{
+  __sync_fetch_and_sub(&theGauges[aGauge], 1);
+}
+
+// hits in percent of all lookups
+static std::string
+hitRate(long long aHits, long long aMisses)
+{
+  std::ostringstream lStream;
+  if (aHits + aMisses == 0)
+    lStream << "-";
+  else
+    lStream << std::fixed << std::setprecision(1) << 100.0 * aHits / (aHits + aMisses) << "%";
+  return lStream.str();
+}
+
+std::string
+PerfCounters::render()
+{
+  std::ostringstream lStream;
+
+  lStream << std::left << std::setw(10) << "operation" << std::right
+          << std::setw(10) << "calls" << std::setw(10) << "avg_us";
+  for (unsigned int i = 0; i < NUMBER_OF_BUCKETS; ++i)
+    lStream << std::setw(9) << BUCKET_NAMES[i];
+  lStream << "\n";
+
+  for (unsigned int lOp = 0; lOp < NUMBER_OF_OPERATIONS; ++lOp) {
+    long long lCalls = theCalls[lOp];
+    lStream << std::left << std::setw(10) << OPERATION_NAMES[lOp] << std::right
+            << std::setw(10) << lCalls
+            << std::setw(10) << (lCalls ? theLatency[lOp] / lCalls : 0);
+    for (unsigned int i = 0; i < NUMBER_OF_BUCKETS; ++i)
+      lStream << std::setw(9) << theHistogram[lOp][i];
+    lStream << "\n";
+  }
+
+  lStream << "\n";
+  for (unsigned int i = 0; i < NUMBER_OF_COUNTERS; ++i)
+    lStream << std::left << std::setw(24) << COUNTER_NAMES[i] << theCounters[i] << "\n";
+  for (unsigned int i = 0; i < NUMBER_OF_GAUGES; ++i)
+    lStream << std::left << std::setw(24) << GAUGE_NAMES[i] << theGauges[i] << "\n";
+
+  lStream << "\n"
+          << std::setw(24) << "stat_cache_hit_rate"
+          << hitRate(theCounters[STAT_CACHE_HITS], theCounters[STAT_CACHE_MISSES]) << "\n"
+          << std::setw(24) << "memcached_hit_rate"
+          << hitRate(theCounters[MEMCACHED_HITS], theCounters[MEMCACHED_MISSES]) << "\n"
+          << std::setw(24) << "file_cache_hit_rate"
+          << hitRate(theCounters[FILE_CACHE_REVALIDATED], theCounters[FILE_CACHE_STALE]) << "\n";
+
+  return lStream.str();
+}
+
+OperationTimer::OperationTimer(PerfCounters& aCounters, PerfCounters::Operation aOperation)
+  : theCounters(aCounters),
+    theOperation(aOperation),
+    theStart(now())
+{
+}
+
+OperationTimer::~OperationTimer()
+{
+  theCounters.record(theOperation, now() - theStart);
+}
+
+} // namespace aws
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_PERFCOUNTERS
+#define AWS_S3FS_PERFCOUNTERS
+
+#include <string>
+
+namespace aws {
+
+/**
+ * Counters of the running file system that are shown in /s3fs.stat.
+ *
+ * The counters are updated with atomic operations, so they can be
+ * used from all fuse threads without a lock. The rendered values of
+ * different counters are not a consistent snapshot.
+ */
+class PerfCounters
+{
+public:
+  enum Operation {
+    GETATTR = 0,
+    READLINK,
+    MKDIR,
+    UNLINK,
+    RMDIR,
+    SYMLINK,
+    TRUNCATE,
+    OPEN,
+    READ,
+    WRITE,
+    RELEASE,
+    OPENDIR,
+    READDIR,
+    CREATE,
+    NUMBER_OF_OPERATIONS
+  };
+
+  enum Counter {
+    STAT_CACHE_HITS = 0,
+    STAT_CACHE_MISSES,
+    KEY_FILTER_NEGATIVES,
+    NAMESPACE_INDEX_HITS,
+    MEMCACHED_HITS,
+    MEMCACHED_MISSES,
+    FILE_CACHE_REVALIDATED,
+    FILE_CACHE_STALE,
+    SHARED_OPENS,
+    BYTES_DOWNLOADED,
+    BYTES_UPLOADED,
+    REQUEST_ERRORS,
+    POOL_OVERFLOWS,
+    NUMBER_OF_COUNTERS
+  };
+
+  // values that go up and down
+  enum Gauge {
+    CONNECTIONS_IN_USE = 0,
+    DOWNLOADS_IN_FLIGHT,
+    UPLOADS_IN_FLIGHT,
+    NUMBER_OF_GAUGES
+  };
+
+  // the latency histogram has a bucket per power of 10 from 10us to 10s
+  static const unsigned int NUMBER_OF_BUCKETS = 8;
+
+  PerfCounters();
+
+  void record(Operation aOperation, long long aMicroseconds);
+
+  void add(Counter aCounter, long long aValue = 1);
+
+  // returns the new value
+  long long increment(Gauge aGauge);
+
+  void decrement(Gauge aGauge);
+
+  // a table of all counters for humans
+  std::string render();
+
+private:
+  long long theCalls[NUMBER_OF_OPERATIONS];
+  long long theLatency[NUMBER_OF_OPERATIONS];  // microseconds
+  long long theHistogram[NUMBER_OF_OPERATIONS][NUMBER_OF_BUCKETS];
+  long long theCounters[NUMBER_OF_COUNTERS];
+  long long theGauges[NUMBER_OF_GAUGES];
+};
+
+/**
+ * Measures the time of a fuse operation until it goes out of scope.
+ */
+class OperationTimer
+{
+public:
+  OperationTimer(PerfCounters& aCounters, PerfCounters::Operation aOperation);
+
+  ~OperationTimer();
+
+private:
+  PerfCounters&           theCounters;
+  PerfCounters::Operation theOperation;
+  long long               theStart;
+};
+
+/**
+ * Counts something as in flight while it is in scope.
+ */
+class GaugeScope
+{
+public:
+  GaugeScope(PerfCounters& aCounters, PerfCounters::Gauge aGauge)
+    : theCounters(aCounters), theGauge(aGauge) { theCounters.increment(theGauge); }
+
+  ~GaugeScope() { theCounters.decrement(theGauge); }
+
+private:
+  PerfCounters&       theCounters;
+  PerfCounters::Gauge theGauge;
+};
+
+} // namespace aws
+
+#endif
@@ -12,6 +12,15 @@ const char* Properties::AWS_SECRET_ACCESS_KEY="aws-secret-access-key";
 const char* Properties::TEMP_DIR="temp-dir";
 const char* Properties::MEMCACHED_SERVERS="memcached-servers";
 const char* Properties::CREATE_MOUNT_DIR="create-mountdir";
+const char* Properties::STAT_CACHE_TTL="stat-cache-ttl";
+const char* Properties::NEGATIVE_CACHE_TTL="negative-cache-ttl";
+const char* Properties::READDIR_STAT="readdir-stat";
+const char* Properties::INVALIDATION_QUEUE="invalidation-queue";
+const char* Properties::FILE_CACHE_SIZE="file-cache-size";
+const char* Properties::KEY_FILTER_INTERVAL="key-filter-interval";
+const char* Properties::NAMESPACE_INDEX="namespace-index";
+const char* Properties::MEMORY_FILE_SIZE="memory-file-size";
+const char* Properties::MEMORY_BUDGET="memory-budget";
 
 void PropertyUtil::read(const char *filename, PropertyMapT &map)
 {
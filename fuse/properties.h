@@ -16,6 +16,15 @@ public:
   static const char* TEMP_DIR;
   static const char* MEMCACHED_SERVERS;
   static const char* CREATE_MOUNT_DIR;
+  static const char* STAT_CACHE_TTL;
+  static const char* NEGATIVE_CACHE_TTL;
+  static const char* READDIR_STAT;
+  static const char* INVALIDATION_QUEUE;
+  static const char* FILE_CACHE_SIZE;
+  static const char* KEY_FILTER_INTERVAL;
+  static const char* NAMESPACE_INDEX;
+  static const char* MEMORY_FILE_SIZE;
+  static const char* MEMORY_BUDGET;
 };
 
 class PropertyUtil
@@ -53,12 +53,21 @@
 #include <cassert>
 #include <stdlib.h>
 #include <memory>
+#include <stdexcept>
 #include <cassert>
 #include <stdio.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
 
 #include <libaws/aws.h>
 #include "properties.h"
+#include "statcache.h"
+#include "invalidationbus.h"
+#include "filecache.h"
+#include "keyfilter.h"
+#include "namespaceindex.h"
+#include "perfcounters.h"
 
 #ifdef S3FS_USE_MEMCACHED
 #  include <libmemcached/memcached.h>
@@ -71,6 +80,47 @@ using namespace aws;
 std::auto_ptr<AWSCache> theCache;
 #endif //USE_MEMCACHED
 
+std::auto_ptr<StatCache> theStatCache;
+
+// shown in /s3fs.stat
+PerfCounters theCounters;
+
+// temp files of closed files that are revalidated if the file is opened again
+std::auto_ptr<FileCache> theFileCache;
+static unsigned int FILE_CACHE_SIZE=256; // megabytes
+static unsigned int FILE_CACHE_MAX_FILES=128;
+
+// temp files of at most MEMORY_FILE_SIZE are kept in memory instead of
+// temp-dir, every memory file counts MEMORY_FILE_SIZE against the budget
+static unsigned int MEMORY_FILE_SIZE=1024;   // kilobytes, 0=off
+static unsigned int MEMORY_FILES_BUDGET=64;  // megabytes
+static long long theMemoryFilesSize=0;
+static pthread_mutex_t theMemoryFilesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// tells the other mounts of the bucket about changed paths (optional)
+std::auto_ptr<InvalidationBus> theInvalidationBus;
+std::string theInvalidationQueue;
+
+// knows which keys don't exist in the bucket (optional)
+std::auto_ptr<KeyFilter> theKeyFilter;
+static unsigned int KEY_FILTER_INTERVAL=0; // seconds between two listings of the bucket, 0=off
+
+// attributes of the previous mount, written at unmount (optional)
+std::auto_ptr<NamespaceIndex> theNamespaceIndex;
+std::string theNamespaceIndexFile;
+static unsigned int STAT_CACHE_TTL=60;
+static unsigned int NEGATIVE_CACHE_TTL=10;
+static unsigned int STAT_CACHE_MAX_ENTRIES=100000;
+
+// how readdir fills the attributes of the entries
+// 0=not at all, 1=from the listing, 2=from the metadata of every entry
+// (HEAD requests, READDIR_HEAD_CONCURRENCY of them at a time)
+// only the metadata is exact, so only 2 fills the attribute caches
+static int READDIR_STAT=1;
+static int READDIR_HEAD_CONCURRENCY=16;
+// number of entries readdir lists with one request
+static int READDIR_PAGE_SIZE=1000;
+
 AWSConnectionFactory* theFactory;
 std::auto_ptr<ConnectionPool<S3ConnectionPtr> > theS3ConnectionPool;
 static unsigned int CONNECTION_POOL_SIZE=5;
@@ -96,6 +146,15 @@ struct s3fs_config {
   char* memcached_servers;
   int   log_level;
   int   create_mount_dir;
+  int   stat_cache_ttl;
+  int   negative_cache_ttl;
+  int   readdir_stat;
+  char* invalidation_queue;
+  int   file_cache_size;
+  int   key_filter_interval;
+  char* namespace_index;
+  int   memory_file_size;
+  int   memory_budget;
 };
 
 enum {
@@ -113,6 +172,15 @@ static struct fuse_opt s3fs_opts[] = {
    S3FS_OPT("log-level=%i",         log_level, 0),
    S3FS_OPT("memcached-servers=%s", memcached_servers, 0),
    S3FS_OPT("create-mountdir=%i", create_mount_dir, 0),
+   S3FS_OPT("stat-cache-ttl=%i",    stat_cache_ttl, 0),
+   S3FS_OPT("negative-cache-ttl=%i", negative_cache_ttl, 0),
+   S3FS_OPT("readdir-stat=%i",      readdir_stat, 0),
+   S3FS_OPT("invalidation-queue=%s", invalidation_queue, 0),
+   S3FS_OPT("file-cache-size=%i",   file_cache_size, 0),
+   S3FS_OPT("key-filter-interval=%i", key_filter_interval, 0),
+   S3FS_OPT("namespace-index=%s",   namespace_index, 0),
+   S3FS_OPT("memory-file-size=%i",  memory_file_size, 0),
+   S3FS_OPT("memory-budget=%i",     memory_budget, 0),
 
    FUSE_OPT_KEY("-h",             KEY_HELP),
    FUSE_OPT_KEY("-H",             KEY_HELP),
@@ -145,6 +213,22 @@ static int s3fs_opt_proc(void *data, const char *arg, int key, struct fuse_args
             "    -o memcached_servers=STRING memcached servers used for caching\n"
             "    -o log-level=INT            logging level (0=ERROR, 1=INFO, 2=DEBUG)\n"
             "    -o create-mountdir=INT      create mount dir if not existent? (0=no, 1=yes)\n"
+            "    -o stat-cache-ttl=INT       seconds file attributes are cached in memory (0=off)\n"
+            "    -o negative-cache-ttl=INT   seconds non existing files are cached in memory (0=off)\n"
+            "    -o readdir-stat=INT         attributes readdir returns for the entries\n"
+            "                                (0=none, 1=guessed from the listing, 2=from the metadata\n"
+            "                                of each entry, only these are cached)\n"
+            "    -o invalidation-queue=STRING prefix of the SQS queues used to tell the other\n"
+            "                                mounts of the bucket about changes (default: off)\n"
+            "    -o file-cache-size=INT      megabytes of closed files kept on disk to be\n"
+            "                                revalidated when they are opened again (0=off)\n"
+            "    -o key-filter-interval=INT  seconds between two listings of the bucket that\n"
+            "                                answer lookups of absent files (default: 0=off)\n"
+            "    -o namespace-index=STRING   file that keeps the attributes of all files from\n"
+            "                                one mount to the next (default: off)\n"
+            "    -o memory-file-size=INT     kilobytes up to which open files are kept in\n"
+            "                                memory instead of temp-dir (default: 1024, 0=off)\n"
+            "    -o memory-budget=INT        megabytes of memory for open files (default: 64)\n"
             , outargs->argv[0]);
     fuse_opt_add_arg(outargs, "-ho");
     fuse_main(outargs->argc, outargs->argv, &s3_filesystem_operations, NULL);
@@ -172,10 +256,15 @@ struct FileHandle {
    std::fstream* filestream;
    std::string filename;
    std::string s3key;
-   unsigned int size;
+   std::string etag;
+   off_t size;
    bool is_write; 
    mode_t mode;
    time_t mtime;
+   std::string path;  // key in theOpenFiles, empty if the handle isn't shared
+   int refcount;      // number of opens using the handle
+   bool in_memory;    // the temp file is a memfd
+   AWSMutex upload;   // held while the temp file is transferred to s3 or moved to disk
 };
 
 FileHandle::FileHandle()
@@ -188,17 +277,29 @@ FileHandle::FileHandle()
   is_write=false;
   mode=0;
   mtime=0;
+  refcount=1;
+  in_memory=false;
+}
+
+static void
+release_memory_file()
+{
+  pthread_mutex_lock(&theMemoryFilesMutex);
+  theMemoryFilesSize -= (long long) MEMORY_FILE_SIZE * 1024;
+  pthread_mutex_unlock(&theMemoryFilesMutex);
 }
 
 FileHandle::~FileHandle()
 {
   if(id!=-1){
-     tempfilemap.erase(id);
      close(id);
   }
   if(filestream){
      delete filestream;filestream=0;
   }
+  if(in_memory){
+     release_memory_file();
+  }
 
   // delete tempfilename if existent
   if(!filename.empty()){
@@ -206,6 +307,159 @@ FileHandle::~FileHandle()
   }
 }
 
+/**
+ * hand the temp file of a released file to the file cache, so that
+ * it doesn't need to be downloaded again if the file is reopened
+ */
+static void
+keep_local_copy(FileHandle* aHandle, const std::string& aPath, long long aSize)
+{
+  if (aHandle->in_memory || aHandle->etag.empty() || !theFileCache->accepts(aSize)) {
+    theFileCache->invalidate(aPath);
+    return;
+  }
+
+  delete aHandle->filestream;
+  aHandle->filestream = NULL;
+  close(aHandle->id);
+  aHandle->id = -1;
+
+  FileCache::Entry lEntry;
+  lEntry.filename = aHandle->filename;
+  lEntry.etag = aHandle->etag;
+  lEntry.size = aSize;
+  aHandle->filename.clear();
+  theFileCache->put(aPath, lEntry);
+}
+
+// holds the upload mutex of a file handle while it is in scope
+struct UploadGuard {
+  UploadGuard(FileHandle* aHandle) : theHandle(aHandle) { theHandle->upload.lock(); }
+  ~UploadGuard() { theHandle->upload.unlock(); }
+  FileHandle* theHandle;
+};
+
+/**
+ * All opens of a path share one file handle, so that the file is only
+ * downloaded once. The handle is counted and released with the last
+ * reference. An entry without a handle means that the file is being
+ * opened, other opens of the path wait for it.
+ * theOpenFilesMutex also protects the tempfilemap.
+ */
+static std::map<std::string, FileHandle*> theOpenFiles;
+static pthread_mutex_t theOpenFilesMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t theOpenFilesCondition = PTHREAD_COND_INITIALIZER;
+
+/**
+ * returns the handle of the open path with a new reference, or NULL if the
+ * path isn't open. In the latter case the caller has to open the file and
+ * call finish_open_file
+ */
+static FileHandle*
+acquire_open_file(const std::string& aPath)
+{
+  FileHandle* lHandle = NULL;
+  pthread_mutex_lock(&theOpenFilesMutex);
+  std::map<std::string, FileHandle*>::iterator lIter;
+  while ((lIter = theOpenFiles.find(aPath)) != theOpenFiles.end() && lIter->second == NULL)
+    pthread_cond_wait(&theOpenFilesCondition, &theOpenFilesMutex);
+
+  if (lIter != theOpenFiles.end()) {
+    lHandle = lIter->second;
+    ++lHandle->refcount;
+  } else {
+    theOpenFiles[aPath] = NULL;
+  }
+  pthread_mutex_unlock(&theOpenFilesMutex);
+  return lHandle;
+}
+
+/**
+ * share the handle of a file that was opened after acquire_open_file,
+ * NULL if opening the file failed
+ */
+static void
+finish_open_file(const std::string& aPath, FileHandle* aHandle)
+{
+  pthread_mutex_lock(&theOpenFilesMutex);
+  std::map<std::string, FileHandle*>::iterator lIter = theOpenFiles.find(aPath);
+  if (aHandle) {
+    aHandle->path = aPath;
+    tempfilemap.insert(std::pair<int,struct FileHandle*>(aHandle->id, aHandle));
+  }
+  // the entry is gone if the path was deleted meanwhile
+  if (lIter != theOpenFiles.end() && lIter->second == NULL) {
+    if (aHandle)
+      lIter->second = aHandle;
+    else
+      theOpenFiles.erase(lIter);
+  } else if (aHandle) {
+    aHandle->path.clear();
+  }
+  pthread_cond_broadcast(&theOpenFilesCondition);
+  pthread_mutex_unlock(&theOpenFilesMutex);
+}
+
+/**
+ * remember the handle of a new file, it is shared unless the path is open already
+ */
+static void
+add_file_handle(const std::string& aPath, FileHandle* aHandle)
+{
+  pthread_mutex_lock(&theOpenFilesMutex);
+  tempfilemap.insert(std::pair<int,struct FileHandle*>(aHandle->id, aHandle));
+  if (!aPath.empty() && theOpenFiles.count(aPath) == 0) {
+    aHandle->path = aPath;
+    theOpenFiles[aPath] = aHandle;
+  }
+  pthread_mutex_unlock(&theOpenFilesMutex);
+}
+
+static FileHandle*
+find_file_handle(uint64_t aId)
+{
+  pthread_mutex_lock(&theOpenFilesMutex);
+  std::map<int,struct FileHandle*>::iterator lIter = tempfilemap.find((int)aId);
+  FileHandle* lHandle = lIter != tempfilemap.end() ? lIter->second : NULL;
+  pthread_mutex_unlock(&theOpenFilesMutex);
+  return lHandle;
+}
+
+/**
+ * drops a reference to the handle, true if it was the last one.
+ * The last reference removes the handle from the tempfilemap and the caller
+ * has to delete it.
+ */
+static bool
+release_file_handle(FileHandle* aHandle)
+{
+  pthread_mutex_lock(&theOpenFilesMutex);
+  bool lLast = --aHandle->refcount == 0;
+  if (lLast) {
+    tempfilemap.erase(aHandle->id);
+    if (!aHandle->path.empty())
+      theOpenFiles.erase(aHandle->path);
+  }
+  pthread_mutex_unlock(&theOpenFilesMutex);
+  return lLast;
+}
+
+/**
+ * the path was deleted or replaced, new opens must not use the handle of the old file
+ */
+static void
+forget_open_file(const std::string& aPath)
+{
+  pthread_mutex_lock(&theOpenFilesMutex);
+  std::map<std::string, FileHandle*>::iterator lIter = theOpenFiles.find(aPath);
+  if (lIter != theOpenFiles.end()) {
+    if (lIter->second)
+      lIter->second->path.clear();
+    theOpenFiles.erase(lIter);
+  }
+  pthread_mutex_unlock(&theOpenFilesMutex);
+}
+
 /**
  * checkTempFolder()
  *
@@ -223,16 +477,19 @@ static void checkTempFolder(){
   } 
 }
 
-
 /**
  * accessor and release functions for S3 Connection objects
  */
 static S3ConnectionPtr getConnection() {
 //  return theFactory->createS3Connection(theAccessKeyId, theSecretAccessKey);
+  // the pool creates a new connection if all of its connections are in use
+  if (theCounters.increment(PerfCounters::CONNECTIONS_IN_USE) > CONNECTION_POOL_SIZE)
+    theCounters.add(PerfCounters::POOL_OVERFLOWS);
   return theS3ConnectionPool->getConnection();
 }
 
 static void releaseConnection(const S3ConnectionPtr& aConnection) {
+  theCounters.decrement(PerfCounters::CONNECTIONS_IN_USE);
   theS3ConnectionPool->release(aConnection);
 }
 
@@ -296,6 +553,7 @@ static void releaseConnection(const S3ConnectionPtr& aConnection) {
     } catch (kind ## Exception & s3Exception) { \
       S3_LOG_ERROR("S3Exception(ERRORCODE="<<((int)s3Exception.getErrorCode())<<"):"<<s3Exception.what()); \
       if (s3Exception.getErrorCode() != aws::S3Exception::NoSuchKey) { \
+         theCounters.add(PerfCounters::REQUEST_ERRORS); \
          haserror=true; \
          result=-EIO;\
       } else{ \
@@ -304,10 +562,12 @@ static void releaseConnection(const S3ConnectionPtr& aConnection) {
       } \
     } catch (AWSConnectionException & conException) { \
      S3_LOG_ERROR("AWSConnectionException: "<<conException.what()); \
+      theCounters.add(PerfCounters::REQUEST_ERRORS); \
       haserror=true; \
       result=-ECONNREFUSED; \
     }catch (AWSException & awsException) { \
       S3_LOG_ERROR("AWSException: "<<awsException.what()); \
+      theCounters.add(PerfCounters::REQUEST_ERRORS); \
       haserror=true; \
       result=-EIO;\
     }
@@ -315,6 +575,7 @@ static void releaseConnection(const S3ConnectionPtr& aConnection) {
 #  define S3FS_CATCH(kind) \
     } catch (kind ## Exception & s3Exception) { \
       if (s3Exception.getErrorCode() != aws::S3Exception::NoSuchKey) { \
+         theCounters.add(PerfCounters::REQUEST_ERRORS); \
          haserror=true; \
          result=-EIO;\
       } else{ \
@@ -322,9 +583,11 @@ static void releaseConnection(const S3ConnectionPtr& aConnection) {
          result=-ENOENT;\
       } \
     } catch (AWSConnectionException & conException) { \
+      theCounters.add(PerfCounters::REQUEST_ERRORS); \
       haserror=true; \
       result=-ECONNREFUSED; \
     }catch (AWSException & awsException) { \
+      theCounters.add(PerfCounters::REQUEST_ERRORS); \
       haserror=true; \
       result=-EIO;\
     }
@@ -416,6 +679,253 @@ fill_stat(map_t& aMap, struct stat* stbuf, long long aContentLength)
 }
 
 
+/**
+ * fill the stat of a directory entry from the bucket listing
+ * folders and empty files can't be told apart without the metadata,
+ * therefore only non empty objects are treated as regular files
+ */
+static void
+fill_stat(const ListBucketResponse::Object& aObject, struct stat* stbuf)
+{
+  if (aObject.Size <= 0)
+    return;
+
+  stbuf->st_mode = S_IFREG | 0777;
+  stbuf->st_gid = getgid();
+  stbuf->st_uid = getuid();
+  stbuf->st_mtime = aObject.LastModifiedTime.getSeconds();
+  stbuf->st_size = aObject.Size;
+  stbuf->st_nlink = 1;
+}
+
+/**
+ * creates the temp file of a handle. The descriptor becomes the id of the
+ * handle and the returned stream is used to transfer the file.
+ * Files that are expected to be small are kept in memory as long as the
+ * budget allows it, all others are created in temp-dir
+ */
+static std::fstream*
+create_temp_file(FileHandle* aHandle, off_t aExpectedSize)
+{
+  std::string lName;
+
+#ifdef MFD_CLOEXEC
+  if (MEMORY_FILE_SIZE > 0 && aExpectedSize <= (off_t) MEMORY_FILE_SIZE * 1024) {
+    pthread_mutex_lock(&theMemoryFilesMutex);
+    bool lReserved = theMemoryFilesSize + MEMORY_FILE_SIZE * 1024 <= (long long) MEMORY_FILES_BUDGET * 1024 * 1024;
+    if (lReserved)
+      theMemoryFilesSize += (long long) MEMORY_FILE_SIZE * 1024;
+    pthread_mutex_unlock(&theMemoryFilesMutex);
+
+    if (lReserved) {
+      aHandle->id = memfd_create("s3fs_file", MFD_CLOEXEC);
+      if (aHandle->id != -1) {
+        aHandle->in_memory = true;
+        lName = "/proc/self/fd/" + to_string(aHandle->id);
+      } else {
+        release_memory_file();
+      }
+    }
+  }
+#endif
+
+  if (!aHandle->in_memory) {
+    checkTempFolder();
+    std::vector<char> lTempFile(theS3FSTempFilePattern.begin(), theS3FSTempFilePattern.end());
+    lTempFile.push_back('\0');
+    aHandle->id = mkstemp(&lTempFile[0]);
+    aHandle->filename = lName = &lTempFile[0];
+  }
+  S3_LOG_DEBUG("File Descriptor # is: " << aHandle->id << " file name = " << lName);
+
+  std::auto_ptr<std::fstream> lStream(new std::fstream());
+  lStream->open(lName.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+  return lStream.release();
+}
+
+/**
+ * moves a memory file that outgrew MEMORY_FILE_SIZE to temp-dir,
+ * the upload mutex of the handle must be held
+ */
+static void
+move_temp_file_to_disk(FileHandle* aHandle)
+{
+  checkTempFolder();
+  std::vector<char> lTempFile(theS3FSTempFilePattern.begin(), theS3FSTempFilePattern.end());
+  lTempFile.push_back('\0');
+  int lFd = mkstemp(&lTempFile[0]);
+  if (lFd == -1)
+    throw std::runtime_error("couldn't create a temp file in " + theS3FSTempFolder);
+
+  char lBuffer[64 * 1024];
+  off_t lOffset = 0;
+  ssize_t lRead;
+  while ((lRead = pread(aHandle->id, lBuffer, sizeof(lBuffer), lOffset)) > 0) {
+    if (pwrite(lFd, lBuffer, lRead, lOffset) != lRead)
+      lRead = -1;
+    if (lRead < 0)
+      break;
+    lOffset += lRead;
+  }
+
+  // the descriptor is the fuse file handle, so it has to stay the same
+  if (lRead < 0 || dup2(lFd, aHandle->id) == -1) {
+    close(lFd);
+    remove(&lTempFile[0]);
+    throw std::runtime_error("couldn't move the temp file to " + theS3FSTempFolder);
+  }
+  close(lFd);
+
+  aHandle->filename = &lTempFile[0];
+  aHandle->filestream->close();
+  aHandle->filestream->open(aHandle->filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+  aHandle->in_memory = false;
+  release_memory_file();
+  S3_LOG_DEBUG("moved the temp file " << aHandle->id << " to " << aHandle->filename);
+}
+
+/**
+ * render the counters into a temp file, it is neither shared nor written to s3
+ */
+static int
+open_stat_file(struct fuse_file_info *fileinfo)
+{
+  std::string lText = theCounters.render();
+  std::auto_ptr<FileHandle> fileHandle(new FileHandle);
+  fileHandle->filestream = create_temp_file(fileHandle.get(), lText.length());
+  if (fileHandle->id == -1
+      || pwrite(fileHandle->id, lText.data(), lText.length(), 0) != (ssize_t) lText.length()) {
+    S3_LOG_ERROR("couldn't write the stat file: " << strerror(errno));
+    return -EIO;
+  }
+
+  // the size changes all the time
+  memset(fileinfo, 0, sizeof(struct fuse_file_info));
+  fileinfo->fh = (uint64_t)fileHandle->id;
+  fileinfo->direct_io = 1;
+  add_file_handle("", fileHandle.release());
+  return 0;
+}
+
+/**
+ * tell the other mounts of the bucket that the path has changed
+ */
+static void
+notify_changed(const std::string& aPath)
+{
+  if (theNamespaceIndex.get())
+    theNamespaceIndex->remove(aPath.substr(1));
+  if (theInvalidationBus.get())
+    theInvalidationBus->publish(aPath);
+}
+
+/**
+ * forget everything the caches know about a path that was changed by another mount
+ */
+static void
+invalidate_path(const std::string& aPath)
+{
+  S3_LOG_DEBUG("invalidate: " << aPath);
+  theStatCache->invalidate(aPath);
+  theFileCache->invalidate(aPath);
+  forget_open_file(aPath);
+  if (theKeyFilter.get())
+    theKeyFilter->add(aPath.substr(1));
+  if (theNamespaceIndex.get())
+    theNamespaceIndex->remove(aPath.substr(1));
+
+#ifdef S3FS_USE_MEMCACHED
+  std::string lpath = aPath.substr(1);
+  std::string parentfolder = AWSCache::getParentFolder(lpath);
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_EXISTS,lpath,""));
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_STAT_ATTR,lpath,""));
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_FILE,lpath,""));
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_SYMLINK,lpath,""));
+
+  // folder entries are cached with and without the trailing /
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_DIR_LS,lpath,""));
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_DIR_LS,lpath + "/",""));
+  theCache->delete_key(theCache->getkey(AWSCache::PREFIX_DIR_LS,parentfolder,""));
+  if (!parentfolder.empty())
+    theCache->delete_key(theCache->getkey(AWSCache::PREFIX_DIR_LS,parentfolder + "/",""));
+#endif // S3FS_USE_MEMCACHED
+}
+
+/**
+ * call aVisitor for all objects in the bucket until it returns false
+ */
+typedef bool (*ObjectVisitor)(const ListBucketResponse::Object& aObject, void* aContext);
+
+static bool
+list_all_objects(ObjectVisitor aVisitor, void* aContext)
+{
+  S3ConnectionPtr lCon = NULL;
+  try {
+    lCon = getConnection();
+    std::string lMarker;
+    bool lTruncated;
+    do {
+      // no delimiter -> the keys of all folders
+      ListBucketResponsePtr lRes = lCon->listBucket(theBucketname, "", lMarker, "", -1);
+      lRes->open();
+      ListBucketResponse::Object o;
+      bool lContinue = true;
+      while (lContinue && lRes->next(o)) {
+        lContinue = aVisitor(o, aContext);
+        lMarker = o.KeyValue;
+      }
+      lRes->close();
+      lTruncated = lContinue && lRes->isTruncated();
+    } while (lTruncated);
+    releaseConnection(lCon);
+  } catch (AWSException& e) {
+    S3_LOG_ERROR("couldn't list the keys of the bucket: " << e.what());
+    if (lCon)
+      releaseConnection(lCon);
+    return false;
+  }
+  return true;
+}
+
+static bool
+add_key(const ListBucketResponse::Object& aObject, void* aFilter)
+{
+  static_cast<BloomFilter*>(aFilter)->add(aObject.KeyValue);
+  return true;
+}
+
+/**
+ * add the keys of all objects in the bucket to the key filter
+ */
+static bool
+list_all_keys(BloomFilter* aFilter)
+{
+  if (!list_all_objects(add_key, aFilter))
+    return false;
+  S3_LOG_INFO("[KeyFilter] listed " << aFilter->getNumberOfItems() << " keys");
+  return true;
+}
+
+static bool
+validate_key(const ListBucketResponse::Object& aObject, void* aIndex)
+{
+  NamespaceIndex* lIndex = static_cast<NamespaceIndex*>(aIndex);
+  lIndex->validate(aObject.KeyValue, aObject.ETag);
+  return lIndex->isRunning();
+}
+
+/**
+ * check which records of the namespace index are still up to date
+ */
+static bool
+validate_namespace_index(NamespaceIndex* aIndex)
+{
+  if (!list_all_objects(validate_key, aIndex))
+    return false;
+  S3_LOG_INFO("[NamespaceIndex] validated " << aIndex->getNumberOfRecords() << " records");
+  return true;
+}
+
 /**
  * Predeclarations
  */
@@ -433,6 +943,7 @@ s3_release(const char *path, struct fuse_file_info *fileinfo);
 static int
 s3_getattr(const char *path, struct stat *stbuf)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::GETATTR);
   // initialize result
   int result=0;
   memset(stbuf, 0, sizeof(struct stat));
@@ -454,8 +965,8 @@ s3_getattr(const char *path, struct stat *stbuf)
       S3_LOG_DEBUG("requested getattr for root / => exit");
       return result;
     } else if (strcmp(path, "/s3fs.stat") == 0) {
-      stbuf->st_mode |= S_IFREG;
-      stbuf->st_size = 0;
+      stbuf->st_mode = S_IFREG | 0444;
+      stbuf->st_size = theCounters.render().length();
       stbuf->st_nlink = 1;
       stbuf->st_gid  = getgid();
       stbuf->st_uid  = getuid();
@@ -465,30 +976,54 @@ s3_getattr(const char *path, struct stat *stbuf)
       return result;
     } else {
 
-#ifdef S3FS_USE_MEMCACHED
-      std::string value;
+      // first ask the in-process cache
+      bool lExists;
+      if (theStatCache->lookup(lpath, stbuf, &lExists)) {
+        S3_LOG_DEBUG("[StatCache] hit for " << lpath.substr(1) << " exists: " << lExists);
+        theCounters.add(PerfCounters::STAT_CACHE_HITS);
+        return lExists ? 0 : -ENOENT;
+      }
+      theCounters.add(PerfCounters::STAT_CACHE_MISSES);
+
+      // keys that aren't in the listing of the bucket don't exist
+      if (theKeyFilter.get() && !theKeyFilter->mightExist(lpath.substr(1))) {
+        S3_LOG_DEBUG("[KeyFilter] " << lpath.substr(1) << " does not exist");
+        theCounters.add(PerfCounters::KEY_FILTER_NEGATIVES);
+        theStatCache->putNegative(lpath);
+        return -ENOENT;
+      }
 
-      memcached_return rc;
+      // then the attributes of the previous mount
+      if (theNamespaceIndex.get() && theNamespaceIndex->lookup(lpath.substr(1), stbuf)) {
+        S3_LOG_DEBUG("[NamespaceIndex] hit for " << lpath.substr(1));
+        theCounters.add(PerfCounters::NAMESPACE_INDEX_HITS);
+        theStatCache->put(lpath, stbuf);
+        return 0;
+      }
 
-      // check if the cache knows if the file/folder exists
+#ifdef S3FS_USE_MEMCACHED
+      // check if the cache knows if the file/folder exists and get its attributes in one go
       std::string key=theCache->getkey(AWSCache::PREFIX_EXISTS,lpath.substr(1),"");
-      value=theCache->read_key(key, &rc);
-      if (value.length() > 0 && value.compare("0")==0) // file does not exist
+      int lCached=theCache->read_attr(stbuf,lpath.substr(1));
+      if (lCached==0) // file does not exist
       {
         S3_LOG_DEBUG("[Memcached] file or folder: " << lpath.substr(1) << " is marked as non existent in cache.");
+        theCounters.add(PerfCounters::MEMCACHED_HITS);
+        theStatCache->putNegative(lpath);
         return -ENOENT;
-      }else if(value.length() > 0 && value.compare("1")==0) // file does exist
+      }else if(lCached==1) // file does exist
       {
         S3_LOG_DEBUG("[Memcached] file or folder: " << lpath.substr(1) << " is marked as existent in cache.");
-
-        // get attributes from cache
-        theCache->read_stat(stbuf,lpath.substr(1));
+        theCounters.add(PerfCounters::MEMCACHED_HITS);
+        theStatCache->put(lpath, stbuf);
        }
        else 
        {
+        theCounters.add(PerfCounters::MEMCACHED_MISSES);
 #endif
          bool haserror=false;
          unsigned int trycounter=0;
+         std::string lETag;
          S3ConnectionPtr lCon = getConnection();
 
          do{
@@ -516,12 +1051,21 @@ s3_getattr(const char *path, struct stat *stbuf)
 
              // set the meta data in the stat struct
              fill_stat(lMap, stbuf, lRes->getContentLength());
+             lETag = lRes->getETag();
            S3FS_CATCH(Head)
          }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
 
          releaseConnection(lCon);
          lCon=NULL;
 
+         if(result==-ENOENT && !haserror){
+           theStatCache->putNegative(lpath);
+         }else if(result==0){
+           theStatCache->put(lpath, stbuf);
+           if (theNamespaceIndex.get())
+             theNamespaceIndex->put(lpath.substr(1), stbuf, lETag);
+         }
+
 #ifdef S3FS_USE_MEMCACHED
          if(result==-ENOENT && !haserror){ 
 
@@ -551,6 +1095,7 @@ s3_getattr(const char *path, struct stat *stbuf)
 
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to get file attributes.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
 
@@ -629,6 +1174,9 @@ s3_chown(const char * path, uid_t uid, gid_t gid)
 static int 
 s3_truncate(const char * path, off_t offset)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::TRUNCATE);
+  if (strcmp(path, "/s3fs.stat") == 0)
+    return -EACCES;
   S3_LOG_DEBUG("path: " << path << " offset:" << offset);
 
 // initialize result
@@ -649,15 +1197,7 @@ s3_truncate(const char * path, off_t offset)
       std::auto_ptr<FileHandle> fileHandle(new FileHandle);
 
       // generate temp file and open it
-      checkTempFolder();
-      int ltempsize=theS3FSTempFilePattern.length();
-      char ltempfile[ltempsize];
-      strcpy(ltempfile,theS3FSTempFilePattern.c_str());
-      fileHandle->id=mkstemp(ltempfile);
-      fileHandle->filename = std::string(ltempfile);
-      S3_LOG_DEBUG("File Descriptor # is: " << fileHandle->id << " file name = " << ltempfile);
-      std::auto_ptr<std::fstream> tempfile(new std::fstream());
-      tempfile->open(ltempfile, std::fstream::in | std::fstream::out | std::fstream::binary);
+      std::auto_ptr<std::fstream> tempfile(create_temp_file(fileHandle.get(), 0));
 
       // the file is empty. thats what we want.
       fileHandle->size=0;
@@ -667,16 +1207,19 @@ s3_truncate(const char * path, off_t offset)
       fileHandle->s3key = lpath.substr(1);
       fileHandle->mtime = getCurrentTime();
 
-      //remember tempfile
+      //remember tempfile, the open handle of the old content isn't used anymore
       fileinfo.fh = (uint64_t)fileHandle->id;
-      int lTmpPointer = fileHandle->id;
-      tempfilemap.insert( std::pair<int,struct FileHandle*>(lTmpPointer,fileHandle.release()) );
-
-#ifdef S3FS_USE_MEMCACHED
+      forget_open_file(lpath);
+      add_file_handle("", fileHandle.release());
 
       // remember changes in cache
       stbuf.st_size=0;
       stbuf.st_mtime=getCurrentTime();
+      theStatCache->put(lpath, &stbuf);
+      theFileCache->invalidate(lpath);
+      notify_changed(lpath);
+
+#ifdef S3FS_USE_MEMCACHED
       theCache->save_stat(&stbuf,lpath.substr(1));
 
       // cleanup cache
@@ -694,6 +1237,7 @@ s3_truncate(const char * path, off_t offset)
     return result;
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to open a file.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
     // cleanup cache to prevent future errors
@@ -713,6 +1257,7 @@ s3_truncate(const char * path, off_t offset)
 static int
 s3_mkdir(const char *path, mode_t mode)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::MKDIR);
   S3_LOG_DEBUG("path: " << path << " mode: " << mode);
 
   int result=0;
@@ -738,7 +1283,11 @@ s3_mkdir(const char *path, mode_t mode)
         lDirMap.insert(pair_t("mtime", time_to_string(getCurrentTime())));
         PutResponsePtr lRes = lCon->put(theBucketname, lpath.substr(1), 0, "text/plain", 0, &lDirMap);
 
-        // success
+        // success -> forget a cached negative entry
+        theStatCache->invalidate(lpath);
+        if (theKeyFilter.get())
+          theKeyFilter->add(lpath.substr(1));
+        notify_changed(lpath);
 #ifdef S3FS_USE_MEMCACHED
         // delete data from cache
         std::string key=theCache->getkey(AWSCache::PREFIX_EXISTS,lpath.substr(1),"");
@@ -755,6 +1304,7 @@ s3_mkdir(const char *path, mode_t mode)
     }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying make dir.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
 
@@ -779,6 +1329,7 @@ s3_mkdir(const char *path, mode_t mode)
 static int
 s3_rmdir(const char *path)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::RMDIR);
   S3_LOG_DEBUG("path: " << path);
 
   int result=0;
@@ -887,6 +1438,13 @@ s3_rmdir(const char *path)
       S3FS_CATCH(Put)
     }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
 
+    if(result==0){
+      theStatCache->putNegative(lpath);
+    }else{
+      theStatCache->invalidate(lpath);
+    }
+    notify_changed(lpath);
+
 #ifdef S3FS_USE_MEMCACHED
     if(result==0){ // successfully deleted
 
@@ -913,6 +1471,7 @@ s3_rmdir(const char *path)
     S3FS_EXIT(result);
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to remove dir.");
+    theStatCache->invalidate(path);
 
 #ifdef S3FS_USE_MEMCACHED
 
@@ -938,152 +1497,292 @@ s3_rmdir(const char *path)
 }
 
 
-/*
- * Read directory
- * 
- * The filesystem may choose between two modes of operation:
- * 
- * 1) The readdir implementation ignores the offset parameter, and passes zero 
- * to the filler function's offset. The filler function will not return '1' 
- * (unless an error happens), so the whole directory is read in a single readdir 
- * operation. This works just like the old getdir() method.
- * 
- * 2) The readdir implementation keeps track of the offsets of the directory 
- * entries. It uses the offset parameter and always passes non-zero offset to
- * the filler function. When the buffer is full (or an error happens) the filler
- *  function will return '1'.
- * 
+/**
+ * DirHandle: state of an open directory
+ *
+ * The entries of a folder are listed page by page, each page being the
+ * result of a single list bucket request. While the kernel consumes the
+ * entries of the current page, the next page is fetched by a separate thread.
+ */
+struct DirEntry {
+  std::string name;
+  struct stat stbuf;
+};
+
+struct DirPage {
+  DirPage() : truncated(false), result(0) {}
+  std::vector<DirEntry> entries;
+  std::string nextmarker;  // marker to list the following page
+  bool truncated;          // true if there are more pages
+  int result;
+};
+
+struct DirHandle {
+  DirHandle(const std::string& aPrefix)
+    : prefix(aPrefix), pagestart(2), prefetching(false) {}
+  std::string prefix;      // key prefix of the folder, e.g. "folder/"
+  DirPage page;            // page that is currently read by the kernel
+  off_t pagestart;         // offset of the first entry of page (0 and 1 are . and ..)
+  bool prefetching;
+  pthread_t prefetcher;
+  std::string prefetchmarker;
+  DirPage prefetched;
+};
+
+/**
+ * list the page of the folder that follows aMarker
  */
 static int
-s3_readdir(const char *path,
-           void *buf,
-           fuse_fill_dir_t filler,
-           off_t offset,
-           struct fuse_file_info *fi)
+load_dir_page(const std::string& aPrefix, const std::string& aMarker, DirPage* aPage)
 {
-  S3_LOG_DEBUG("readdir: " << path);
-
   int result=0;
   S3ConnectionPtr lCon = NULL;
 
-  filler(buf, ".", NULL, 0);
-  filler(buf, "..", NULL, 0);
-
-  // TODO handle full buffer by remembering the marker
-
-  std::string lpath(path);
-  if (lpath.at(lpath.length()-1) != '/')
-    lpath += "/";
-
   try{
-#ifdef S3FS_USE_MEMCACHED
-    std::string value;
-    memcached_return rc;
+    lCon = getConnection();
+    bool haserror=false;
+    unsigned int trycounter=0;
 
-    std::string key=theCache->getkey(AWSCache::PREFIX_DIR_LS,lpath.substr(1),"");
+    do{
+      trycounter++;
+      haserror=false;
+      result=0;
+      aPage->entries.clear();
+      S3FS_TRY
+        S3_LOG_DEBUG("list bucket: "<<theBucketname<<" prefix: "<<aPrefix<<" marker: "<<aMarker);
+        ListBucketResponsePtr lRes = lCon->listBucket(theBucketname, aPrefix, aMarker, "/", READDIR_PAGE_SIZE);
+        std::vector<std::string> lKeys;
+        std::map<std::string, size_t> lPositions;
+        std::string lLastKey;
+
+        lRes->open();
+        ListBucketResponse::Object o;
+        while (lRes->next(o)) {
+          S3_LOG_DEBUG("  result: " << o.KeyValue);
+          DirEntry lEntry;
+          memset(&lEntry.stbuf, 0, sizeof(struct stat));
+          lEntry.name = o.KeyValue.substr(aPrefix.length());
+          lLastKey = o.KeyValue;
+
+          // the listing doesn't know type, mode and owner (e.g. of symlinks),
+          // its guess is only passed to readdir and never cached
+          if (READDIR_STAT == 1) {
+            fill_stat(o, &lEntry.stbuf);
+          } else if (READDIR_STAT == 2) {
+            lKeys.push_back(o.KeyValue);
+            lPositions[o.KeyValue] = aPage->entries.size();
+          }
+          aPage->entries.push_back(lEntry);
+        }
+        lRes->close();
+
+        // the metadata of the whole page is fetched at once
+        if (!lKeys.empty()) {
+          HeadManyResponsePtr lHeads = lCon->headMany(theBucketname, lKeys, READDIR_HEAD_CONCURRENCY);
+          lHeads->open();
+          HeadManyResponse::Object h;
+          while (lHeads->next(h)) {
+            if (!h.IsSuccessful) {
+              S3_LOG_INFO("couldn't get metadata for " << h.KeyValue << ": " << h.ErrorMessage);
+              continue;
+            }
+            struct stat* lStat = &aPage->entries[lPositions[h.KeyValue]].stbuf;
+            fill_stat(h.MetaData, lStat, h.ContentLength);
+            theStatCache->put("/" + h.KeyValue, lStat);
+#ifdef S3FS_USE_MEMCACHED
+            theCache->save_attr(lStat, h.KeyValue);
+#endif //S3FS_USE_MEMCACHED
+          }
+          lHeads->close();
+        }
 
-    value=theCache->read_key(key, &rc);
-    if (rc==MEMCACHED_SUCCESS) // there are entries in the cache for this folder
-    {
-      S3_LOG_DEBUG("[Memcached] found entries for folder '" << lpath.substr(1) << "': " << value);
-      std::vector<std::string> items;
-      std::vector<std::string>::iterator iter;
+        // because of the delimiter the page may end with a common prefix
+        const std::vector<std::string>& lPrefixes = lRes->getCommonPrefixes();
+        if (!lPrefixes.empty() && lPrefixes.back() > lLastKey)
+          lLastKey = lPrefixes.back();
+        aPage->nextmarker = lLastKey;
+        aPage->truncated = lRes->isTruncated() && !lLastKey.empty();
+      S3FS_CATCH(ListBucket);
+    }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
 
-      AWSCache::to_vector(items,value,AWSCache::DELIMITER_FOLDER_ENTRIES);
-      iter=items.begin();
-      while(iter!=items.end()){
-        struct stat lStat;
-        memset(&lStat, 0, sizeof(struct stat));
+    aPage->result = result;
+    S3FS_EXIT(result);
+  }catch(...){
+    S3_LOG_ERROR("An Error occured while trying to read dir contents.");
 
-        filler(buf, (*iter).c_str(), &lStat, 0);
+#ifdef S3FS_USE_MEMCACHED
+    // delete cached folder entries to prevent future errors
+    std::string key=theCache->getkey(AWSCache::PREFIX_DIR_LS,aPrefix,"");
+    theCache->delete_key(key);
+#endif // S3FS_USE_MEMCACHED
 
-        iter++;
-      }
-    }
-    else 
-    {
-      std::string lentries="";
-#endif
+    if(lCon) releaseConnection(lCon);
+    lCon=NULL;
+    aPage->result = -EIO;
+    return -EIO; // I/O Error
+  }
+}
 
-      lCon = getConnection();
-      bool haserror=false;
-      unsigned int trycounter=0;
+static void*
+prefetch_dir_page(void* aDirHandle)
+{
+  DirHandle* lDir = static_cast<DirHandle*>(aDirHandle);
+  load_dir_page(lDir->prefix, lDir->prefetchmarker, &lDir->prefetched);
+  return NULL;
+}
 
-      do{
-        trycounter++;
-        haserror=false;
-        ListBucketResponsePtr lRes;
-        S3FS_TRY
-          std::string lMarker;
-          do {
-            // get object without first /
-            S3_LOG_DEBUG("list bucket: "<<theBucketname<<" prefix: "<<lpath.substr(1));
-            lRes = lCon->listBucket(theBucketname, lpath.substr(1), lMarker, "/", -1);
-            lRes->open();
-            ListBucketResponse::Object o;
-            while (lRes->next(o)) {
-              struct stat lStat;
-              memset(&lStat, 0, sizeof(struct stat));
-
-              S3_LOG_DEBUG("  result: " << o.KeyValue);
-              std::string lTmp = o.KeyValue.replace(0, lpath.length()-1, "");
+// start listing the page that follows the current one in the background
+static void
+start_prefetch(DirHandle* aDir)
+{
+  if (!aDir->page.truncated || aDir->prefetching)
+    return;
 
-#ifdef S3FS_USE_MEMCACHED
-              // remember entries to store in cache
-              if(lentries.length()>0) lentries.append(AWSCache::DELIMITER_FOLDER_ENTRIES);
-              lentries.append(lTmp);
-#endif //S3FS_USE_MEMCACHED
+  aDir->prefetchmarker = aDir->page.nextmarker;
+  aDir->prefetched = DirPage();
+  aDir->prefetching = (pthread_create(&aDir->prefetcher, NULL, prefetch_dir_page, aDir) == 0);
+}
 
-              filler(buf, lTmp.c_str(), &lStat, 0);
-              lMarker = o.KeyValue;
-            }
-            lRes->close();
-          } while (lRes->isTruncated());
+static void
+finish_prefetch(DirHandle* aDir)
+{
+  if (aDir->prefetching) {
+    pthread_join(aDir->prefetcher, NULL);
+    aDir->prefetching = false;
+  }
+}
 
-         S3FS_CATCH(ListBucket);
-       }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
+static int
+load_first_dir_page(DirHandle* aDir)
+{
+  finish_prefetch(aDir);
+  aDir->pagestart = 2;
+  aDir->page = DirPage();
 
 #ifdef S3FS_USE_MEMCACHED
-       if(result==-ENOENT && !haserror){ 
-
-         // remember in cache that no entries exist in folder
-         theCache->save_key(key, "");
-       }else if (!haserror){
-
-         //remember successfully retrieved entries in cache
-         theCache->save_key(key, lentries);
-       }
+  memcached_return rc;
+  std::string key=theCache->getkey(AWSCache::PREFIX_DIR_LS,aDir->prefix,"");
+  std::string value=theCache->read_key(key, &rc);
+  if (rc==MEMCACHED_SUCCESS) // there are entries in the cache for this folder
+  {
+    S3_LOG_DEBUG("[Memcached] found entries for folder '" << aDir->prefix << "': " << value);
+    std::vector<std::string> items;
+    AWSCache::to_vector(items,value,AWSCache::DELIMITER_FOLDER_ENTRIES);
+    for (std::vector<std::string>::iterator iter=items.begin(); iter!=items.end(); ++iter) {
+      DirEntry lEntry;
+      lEntry.name = *iter;
+      memset(&lEntry.stbuf, 0, sizeof(struct stat));
+      aDir->page.entries.push_back(lEntry);
+    }
+    return 0;
+  }
 #endif
 
-       S3FS_EXIT(result);
+  int result = load_dir_page(aDir->prefix, "", &aDir->page);
 
 #ifdef S3FS_USE_MEMCACHED
+  // only folders that fit into a single page are remembered in the cache
+  if (result==0 && !aDir->page.truncated) {
+    std::string lentries="";
+    for (std::vector<DirEntry>::iterator iter=aDir->page.entries.begin();
+         iter!=aDir->page.entries.end(); ++iter) {
+      if(lentries.length()>0) lentries.append(AWSCache::DELIMITER_FOLDER_ENTRIES);
+      lentries.append(iter->name);
     }
+    theCache->save_key(key, lentries);
+  }
 #endif
-  }catch(...){
-    S3_LOG_ERROR("An Error occured while trying to read dir contents.");
 
-#ifdef S3FS_USE_MEMCACHED
+  if (result==0)
+    start_prefetch(aDir);
+  return result;
+}
 
-    // cleanup cache to prevent future errors
-    std::string key=theCache->getkey(AWSCache::PREFIX_EXISTS,lpath.substr(1),"");
-    theCache->delete_key(key);
+static int
+next_dir_page(DirHandle* aDir)
+{
+  aDir->pagestart += aDir->page.entries.size();
+
+  if (aDir->prefetching) {
+    finish_prefetch(aDir);
+    aDir->page = aDir->prefetched;
+    aDir->prefetched = DirPage();
+  } else {
+    DirPage lPage;
+    load_dir_page(aDir->prefix, aDir->page.nextmarker, &lPage);
+    aDir->page = lPage;
+  }
 
-    // delete cached folder entries
-    key=theCache->getkey(AWSCache::PREFIX_DIR_LS,lpath.substr(1),"");
-    theCache->delete_key(key);
+  if (aDir->page.result==0)
+    start_prefetch(aDir);
+  return aDir->page.result;
+}
 
-    // delete cached dir entries of parent folder
-    std::string parentfolder=AWSCache::getParentFolder(lpath.substr(1));
-    key=theCache->getkey(AWSCache::PREFIX_DIR_LS,parentfolder,"");
-    theCache->delete_key(key);
-#endif // S3FS_USE_MEMCACHED
+/*
+ * Read directory
+ * 
+ * The filesystem may choose between two modes of operation:
+ * 
+ * 1) The readdir implementation ignores the offset parameter, and passes zero 
+ * to the filler function's offset. The filler function will not return '1' 
+ * (unless an error happens), so the whole directory is read in a single readdir 
+ * operation. This works just like the old getdir() method.
+ * 
+ * 2) The readdir implementation keeps track of the offsets of the directory 
+ * entries. It uses the offset parameter and always passes non-zero offset to
+ * the filler function. When the buffer is full (or an error happens) the filler
+ *  function will return '1'.
+ * 
+ * s3fs uses the second mode. The listing is kept in the DirHandle that was
+ * created by s3_opendir.
+ */
+static int
+s3_readdir(const char *path,
+           void *buf,
+           fuse_fill_dir_t filler,
+           off_t offset,
+           struct fuse_file_info *fi)
+{
+  OperationTimer lTimer(theCounters, PerfCounters::READDIR);
+  S3_LOG_DEBUG("readdir: " << path << " offset: " << offset);
 
-    if(lCon) releaseConnection(lCon);
-    lCon=NULL;
-    return -EIO; // I/O Error
+  DirHandle* lDir = (DirHandle*) (uintptr_t) fi->fh;
+  if (lDir == NULL)
+    return -EBADF;
+
+  off_t lPos = offset;
+  if (lPos == 0) {
+    if (filler(buf, ".", NULL, 1)) return 0;
+    lPos = 1;
+  }
+  if (lPos == 1) {
+    if (filler(buf, "..", NULL, 2)) return 0;
+    lPos = 2;
+  }
+
+  // the directory was rewound
+  if (lPos < lDir->pagestart) {
+    int result = load_first_dir_page(lDir);
+    if (result != 0)
+      return result;
+  }
+
+  while (true) {
+    while ((size_t) (lPos - lDir->pagestart) < lDir->page.entries.size()) {
+      DirEntry& lEntry = lDir->page.entries[lPos - lDir->pagestart];
+      // buffer is full, the kernel will call again with the offset of this entry
+      if (filler(buf, lEntry.name.c_str(), &lEntry.stbuf, lPos + 1))
+        return 0;
+      ++lPos;
+    }
+
+    if (!lDir->page.truncated)
+      return 0;
+
+    int result = next_dir_page(lDir);
+    if (result != 0)
+      return result;
   }
-  return result;
 }
 
 
@@ -1101,6 +1800,7 @@ s3_readdir(const char *path,
 static int
 s3_create(const char *path, mode_t mode, struct fuse_file_info *fileinfo)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::CREATE);
   S3_LOG_DEBUG("path: " << path << " mode: " << mode);
 
   std::string lpath(path);
@@ -1123,16 +1823,8 @@ s3_create(const char *path, mode_t mode, struct fuse_file_info *fileinfo)
   try{
 
     // generate temp file and open it
-    checkTempFolder();
-    int ltempsize=theS3FSTempFilePattern.length();
-    char ltempfile[ltempsize];
-    strcpy(ltempfile,theS3FSTempFilePattern.c_str());
-    fileHandle->id=mkstemp(ltempfile);
-    S3_LOG_DEBUG("File Descriptor # is: " << fileHandle->id << " file name = " << ltempfile);
-    std::auto_ptr<std::fstream> tempfile(new std::fstream());
-    tempfile->open(ltempfile);
-
-    fileHandle->filename = std::string(ltempfile);
+    std::auto_ptr<std::fstream> tempfile(create_temp_file(fileHandle.get(), 0));
+
     fileHandle->size = 0;
     fileHandle->s3key = lpath.substr(1);// cut off the first slash
     fileHandle->mode = lmode;
@@ -1140,22 +1832,26 @@ s3_create(const char *path, mode_t mode, struct fuse_file_info *fileinfo)
     fileHandle->is_write = true;
     fileHandle->mtime = getCurrentTime();
 
-    //remember filehandle
+    //remember filehandle, opens of the new file share it
     fileinfo->fh = (uint64_t)fileHandle->id;
-    int lTmpPointer = fileHandle->id;
-    tempfilemap.insert( std::pair<int,struct FileHandle*>(lTmpPointer,fileHandle.release()) );
-
-#ifdef S3FS_USE_MEMCACHED
+    forget_open_file(lpath);
+    add_file_handle(lpath, fileHandle.release());
 
     // init stat
     struct stat stbuf;
+    memset(&stbuf, 0, sizeof(struct stat));
     stbuf.st_mode = lmode;
     stbuf.st_gid = getgid();
     stbuf.st_uid = getuid();
     stbuf.st_mtime = getCurrentTime();
     stbuf.st_size = 0;
     stbuf.st_nlink = 1;
+    theStatCache->put(lpath, &stbuf);
+    if (theKeyFilter.get())
+      theKeyFilter->add(lpath.substr(1));
+    notify_changed(lpath);
 
+#ifdef S3FS_USE_MEMCACHED
     // store data for newly created file to cache
     std::string key=theCache->getkey(AWSCache::PREFIX_EXISTS,lpath.substr(1),"").c_str();
     theCache->save_key(key, "1");
@@ -1168,6 +1864,7 @@ s3_create(const char *path, mode_t mode, struct fuse_file_info *fileinfo)
 #endif // S3FS_USE_MEMCACHED
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to create a new file.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
 
@@ -1194,6 +1891,7 @@ s3_create(const char *path, mode_t mode, struct fuse_file_info *fileinfo)
 static int
 s3_unlink(const char * path)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::UNLINK);
 #ifndef NDEBUG
   std::string location="s3_unlink";
 #endif
@@ -1221,6 +1919,15 @@ s3_unlink(const char * path)
       S3FS_CATCH(Put)
     }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
 
+    if(result==0 || (result==-ENOENT && !haserror)){
+      theStatCache->putNegative(lpath);
+    }else{
+      theStatCache->invalidate(lpath);
+    }
+    theFileCache->invalidate(lpath);
+    forget_open_file(lpath);
+    notify_changed(lpath);
+
 #ifdef S3FS_USE_MEMCACHED
     if(result!=-ENOENT){
       // delete data from cache
@@ -1241,6 +1948,7 @@ s3_unlink(const char * path)
     S3FS_EXIT(result);
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to delete a file.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
     // cleanup cache to prevent future errors
@@ -1275,6 +1983,10 @@ static int
 s3_open(const char *path, 
 	struct fuse_file_info *fileinfo)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::OPEN);
+
+  if (strcmp(path, "/s3fs.stat") == 0)
+    return open_stat_file(fileinfo);
 #ifndef NDEBUG
   std::string location="s3_open";
 #endif
@@ -1288,41 +2000,51 @@ s3_open(const char *path,
 #ifdef S3FS_USE_MEMCACHED
   std::string key;
 #endif // S3FS_USE_MEMCACHED
+  FileCache::Entry lLocalCopy;
+  bool lHasLocalCopy = false;
+  FileHandle* lOpened = NULL;
+
+  // the file is open already -> share its handle
+  FileHandle* lShared = acquire_open_file(lpath);
+  if (lShared) {
+    theCounters.add(PerfCounters::SHARED_OPENS);
+    S3_LOG_DEBUG("sharing the open handle " << lShared->id);
+    memset(fileinfo, 0, sizeof(struct fuse_file_info));
+    fileinfo->fh = (uint64_t)lShared->id;
+    fileinfo->keep_cache = 1;
+    return 0;
+  }
 
   try{
     //get file stat
     struct stat stbuf;
     s3_getattr(path,&stbuf);
 
+    // a recently closed copy of the file only needs to be revalidated
+    lHasLocalCopy = theFileCache->take(lpath, &lLocalCopy);
+
     std::auto_ptr<FileHandle> fileHandle(new FileHandle);
 
     memset(fileinfo, 0, sizeof(struct fuse_file_info));
 
     // generate temp file and open it
-    checkTempFolder();
-    int ltempsize=theS3FSTempFilePattern.length();
-    char ltempfile[ltempsize];
-    strcpy(ltempfile,theS3FSTempFilePattern.c_str());
-    fileHandle->id=mkstemp(ltempfile);
-    fileHandle->filename = std::string(ltempfile);
-    S3_LOG_DEBUG("File Descriptor # is: " << fileHandle->id << " file name = " << ltempfile);
-    std::auto_ptr<std::fstream> tempfile(new std::fstream());
-    tempfile->open(ltempfile, std::fstream::in | std::fstream::out | std::fstream::binary);
+    std::auto_ptr<std::fstream> tempfile(create_temp_file(fileHandle.get(), stbuf.st_size));
 
 #ifdef S3FS_USE_MEMCACHED
     //init
     bool got_file_cont_from_cache=false;
     memcached_return rc;
-    unsigned int filesize=(unsigned int)stbuf.st_size;
+    off_t filesize=stbuf.st_size;
     
     // file can only be in cach if content is not too big
-    if(filesize<AWSCache::FILE_CACHING_UPPER_LIMIT){
+    if(!lHasLocalCopy && filesize<AWSCache::FILE_CACHING_UPPER_LIMIT){
       S3_LOG_DEBUG("trying to get File of size " << filesize << " from cache");
       key=theCache->getkey(AWSCache::PREFIX_FILE,lpath.substr(1),"").c_str();
-      theCache->read_file(key,dynamic_cast<std::fstream*>(tempfile.get()),&rc);
+      theCache->read_file(key,dynamic_cast<std::fstream*>(tempfile.get()),&rc,&fileHandle->etag);
 
       if (rc==MEMCACHED_SUCCESS){
         got_file_cont_from_cache=true;
+        tempfile->flush(); // read and write use the file descriptor
         fileHandle->size=stbuf.st_size;
         fileHandle->filestream = tempfile.release();
         fileHandle->is_write = false;
@@ -1331,8 +2053,13 @@ s3_open(const char *path,
 
         //remember tempfile
         fileinfo->fh = (uint64_t)fileHandle->id;
-        int lTmpPointer = fileHandle->id;
-        tempfilemap.insert( std::pair<int,struct FileHandle*>(lTmpPointer,fileHandle.release()) );
+        lOpened = fileHandle.release();
+      }else{
+        // the cache might have written a partial set of chunks -> start over
+        tempfile->clear();
+        tempfile->seekp(0, std::ios_base::beg);
+        if (ftruncate(fileHandle->id, 0) != 0)
+          throw std::runtime_error("couldn't truncate the temp file");
       }
     }
 
@@ -1340,6 +2067,7 @@ s3_open(const char *path,
 #endif // S3FS_USE_MEMCACHED
 
       // now lets get the data and save it into the temp file
+      GaugeScope lDownload(theCounters, PerfCounters::DOWNLOADS_IN_FLIGHT);
       lCon = getConnection();
       bool haserror=false;
       unsigned int trycounter=0;
@@ -1349,23 +2077,55 @@ s3_open(const char *path,
         haserror=false;
         S3_LOG_DEBUG("going to make get call to s3 for " << lpath.substr(1) << "; trycounter " << trycounter);
         S3FS_TRY
-          GetResponsePtr lGet = lCon->get(theBucketname, lpath.substr(1));
+          GetResponsePtr lGet = lHasLocalCopy
+              ? lCon->get(theBucketname, lpath.substr(1), lLocalCopy.etag)
+              : lCon->get(theBucketname, lpath.substr(1));
           S3_LOG_DEBUG("successfully made get request");
-          std::istream& lInStream = lGet->getInputStream();
-          S3_LOG_DEBUG("received content with length: " << lGet->getContentLength());
-          fileHandle->size=lGet->getContentLength();
-
-          S3_LOG_DEBUG("going to write data to tempfile");
-          // write data to temp file
-          char data[1024];
-          while (lInStream.good())     // loop while extraction from file is possible
-          {
-            lInStream.read(data, 1024);       // get character from file
-            tempfile->write(data, lInStream.gcount());
-            S3_LOG_DEBUG("wrote " << lInStream.gcount() << "bytes to tempfile");
+
+          if (lHasLocalCopy && !lGet->isModified()) {
+            // the local copy is up to date -> use it instead of the new temp file
+            S3_LOG_DEBUG("reusing local copy " << lLocalCopy.filename << " with etag " << lLocalCopy.etag);
+            theCounters.add(PerfCounters::FILE_CACHE_REVALIDATED);
+            tempfile->close();
+            close(fileHandle->id);
+            if (fileHandle->in_memory) {
+              fileHandle->in_memory = false;
+              release_memory_file();
+            } else {
+              remove(fileHandle->filename.c_str());
+            }
+            fileHandle->filename = lLocalCopy.filename;
+            fileHandle->id = ::open(lLocalCopy.filename.c_str(), O_RDWR);
+            lHasLocalCopy = false;
+            if (fileHandle->id == -1)
+              throw std::runtime_error("couldn't open local copy " + lLocalCopy.filename);
+            tempfile->open(lLocalCopy.filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+            fileHandle->size=lLocalCopy.size;
+            fileHandle->etag=lLocalCopy.etag;
+
+            // the content didn't change, so the kernel may keep its pages
+            fileinfo->keep_cache = 1;
+          } else {
+            if (lHasLocalCopy)
+              theCounters.add(PerfCounters::FILE_CACHE_STALE);
+            std::istream& lInStream = lGet->getInputStream();
+            S3_LOG_DEBUG("received content with length: " << lGet->getContentLength());
+            fileHandle->size=lGet->getContentLength();
+            fileHandle->etag=lGet->getETag();
+
+            S3_LOG_DEBUG("going to write data to tempfile");
+            // write data to temp file
+            char data[1024];
+            while (lInStream.good())     // loop while extraction from file is possible
+            {
+              lInStream.read(data, 1024);       // get character from file
+              tempfile->write(data, lInStream.gcount());
+              theCounters.add(PerfCounters::BYTES_DOWNLOADED, lInStream.gcount());
+              S3_LOG_DEBUG("wrote " << lInStream.gcount() << "bytes to tempfile");
+            }
+            tempfile->flush();
+            S3_LOG_DEBUG("finished writing to tempfile");
           }
-          tempfile->flush();
-          S3_LOG_DEBUG("finished writing to tempfile");
 
           fileHandle->filestream = tempfile.release();
           fileHandle->is_write = false;
@@ -1375,24 +2135,35 @@ s3_open(const char *path,
 
           //remember tempfile
           fileinfo->fh = (uint64_t)fileHandle->id;
-          int lTmpPointer = fileHandle->id;
-          tempfilemap.insert( std::pair<int,struct FileHandle*>(lTmpPointer,fileHandle.release()) );
+          lOpened = fileHandle.release();
           S3_LOG_DEBUG("put tempfile into map");
 
         S3FS_CATCH(Get)
       }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
+      releaseConnection(lCon);
+      lCon=NULL;
 
 #ifdef S3FS_USE_MEMCACHED
     }
 #endif // S3FS_USE_MEMCACHED
+    finish_open_file(lpath, lOpened);
     if (result!=0){
       S3_LOG_DEBUG("setting the fileinfo filehandle to NULL");
       fileinfo->fh = NULL;
     }
+
+    // the local copy is outdated
+    if (lHasLocalCopy)
+      remove(lLocalCopy.filename.c_str());
+
     S3_LOG_DEBUG("returning with result " << result);
     return result;
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to open a file.");
+    finish_open_file(lpath, lOpened);
+    theStatCache->invalidate(lpath);
+    if (lHasLocalCopy)
+      remove(lLocalCopy.filename.c_str());
 
 #ifdef S3FS_USE_MEMCACHED
     // cleanup cache to prevent future errors
@@ -1421,6 +2192,9 @@ s3_open(const char *path,
 static int
 s3_write(const char * path, const char * data, size_t size, off_t offset, struct fuse_file_info * fileinfo)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::WRITE);
+  if (strcmp(path, "/s3fs.stat") == 0)
+    return -EACCES;
   S3_LOG_DEBUG("path: " << path << " data: " << data << " size: " << size << " offset: " << offset);
 
   S3_LOG_DEBUG("data size: " << strlen(data));
@@ -1433,17 +2207,34 @@ s3_write(const char * path, const char * data, size_t size, off_t offset, struct
 #endif // S3FS_USE_MEMCACHED
 
   try{
+    FileHandle* fileHandle=NULL;
     if( 
        (((int)fileinfo->fh)!=0) && 
-       (tempfilemap.find((int)fileinfo->fh)!=tempfilemap.end())
+       (fileHandle=find_file_handle(fileinfo->fh))!=NULL
       ){
-      FileHandle* fileHandle=tempfilemap.find((int)fileinfo->fh)->second;
-      std::string tempfilename=fileHandle->filename;
-      std::fstream* tempfile=fileHandle->filestream;
+
+      // memory files move to disk when they outgrow MEMORY_FILE_SIZE
+      std::auto_ptr<UploadGuard> lGuard;
+      if(fileHandle->in_memory){
+        lGuard.reset(new UploadGuard(fileHandle));
+        if(fileHandle->in_memory && offset+(off_t)size>(off_t)MEMORY_FILE_SIZE*1024)
+          move_temp_file_to_disk(fileHandle);
+      }
 
       // write data to temp file
-      tempfile->seekp(offset,std::ios_base::beg);
-      tempfile->write(data,size);
+      size_t written=0;
+      while(written<size){
+        ssize_t lResult=pwrite(fileHandle->id, data+written, size-written, offset+written);
+        if(lResult<0){
+          // the logging may change errno
+          int lErr=errno;
+          if(lErr==EINTR)
+            continue;
+          S3_LOG_ERROR("writing to the temp file failed: " << strerror(lErr));
+          return -lErr;
+        }
+        written+=lResult;
+      }
 
       // flag to update file on s3
       fileHandle->is_write = true;
@@ -1456,6 +2247,7 @@ s3_write(const char * path, const char * data, size_t size, off_t offset, struct
     return result;
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying write data to a file.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
     // cleanup cache to prevent future errors
@@ -1487,6 +2279,15 @@ s3_write(const char * path, const char * data, size_t size, off_t offset, struct
 static int
 s3_release(const char *path, struct fuse_file_info *fileinfo)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::RELEASE);
+
+  // the stat file only has to be deleted
+  if (strcmp(path, "/s3fs.stat") == 0) {
+    FileHandle* lHandle = find_file_handle(fileinfo->fh);
+    if (lHandle && release_file_handle(lHandle))
+      delete lHandle;
+    return 0;
+  }
 #ifndef NDEBUG
   std::string location="s3_release";
 #endif
@@ -1506,17 +2307,30 @@ s3_release(const char *path, struct fuse_file_info *fileinfo)
         && (int)fileinfo->fh!=0){
 
       // get filehandle struct
-      std::map<int,struct FileHandle*>::iterator foundtempfile=tempfilemap.find((int)fileinfo->fh);
-      if(foundtempfile!=tempfilemap.end()){
-         std::auto_ptr<FileHandle> fileHandle(foundtempfile->second);
+      FileHandle* fileHandle=find_file_handle(fileinfo->fh);
+      if(fileHandle!=NULL){
+
+        // the handle is shared by all opens of the file. The reference is
+        // dropped while the upload lock is held, so the last release (which
+        // deletes the handle) can't run before this one is done with it.
+        // lOwner is declared first so that the lock is released before the delete.
+        std::auto_ptr<FileHandle> lOwner;
+        UploadGuard lGuard(fileHandle);
+        bool lWritten=fileHandle->is_write;
+        bool lUploaded=false;
+        off_t lSize=0;
 
         // check if we have to send changes to s3
-        if(fileHandle->is_write){
+        if(lWritten){
+          fileHandle->is_write=false;
 
-          // reset filestream
+          // determine the size of the written data and reset filestream
+          fileHandle->filestream->seekg(0,std::ios_base::end);
+          lSize = fileHandle->filestream->tellg();
           fileHandle->filestream->seekg(0,std::ios_base::beg);
 
           // transfer temp file to s3
+          GaugeScope lUpload(theCounters, PerfCounters::UPLOADS_IN_FLIGHT);
           lCon = getConnection();
           bool haserror=false;
           unsigned int trycounter=0;
@@ -1532,6 +2346,7 @@ s3_release(const char *path, struct fuse_file_info *fileinfo)
               lDirMap.insert(pair_t("mode", to_string(fileHandle->mode)));
               lDirMap.insert(pair_t("mtime", time_to_string(fileHandle->mtime)));
               PutResponsePtr lRes = lCon->put(theBucketname, fileHandle->s3key, *(fileHandle->filestream), "text/plain", &lDirMap);
+              fileHandle->etag = lRes->getETag();
 
 #ifdef S3FS_USE_MEMCACHED
               // invalidate cached data of file
@@ -1543,18 +2358,48 @@ s3_release(const char *path, struct fuse_file_info *fileinfo)
 
             S3FS_CATCH(Put)
           }while(haserror && trycounter<AWS_TRIES_ON_ERROR);
+          releaseConnection(lCon);
+          lCon=NULL;
 
           if(result!=0){ 
             S3_LOG_ERROR("saving file on s3 failed");
+            theStatCache->invalidate(lpath);
+            fileHandle->is_write=true;
+          }else{
+            fileHandle->size=lSize;
+            theCounters.add(PerfCounters::BYTES_UPLOADED, lSize);
+
+            // remember the attributes of the new version
+            struct stat stbuf;
+            memset(&stbuf, 0, sizeof(struct stat));
+            stbuf.st_mode = fileHandle->mode | S_IFREG;
+            stbuf.st_gid = getgid();
+            stbuf.st_uid = getuid();
+            stbuf.st_mtime = fileHandle->mtime;
+            stbuf.st_size = lSize;
+            stbuf.st_nlink = 1;
+            theStatCache->put(lpath, &stbuf);
+            lUploaded=true;
           }
+          notify_changed(lpath);
+        }
 
-        }else{ 
-          // we have to send no changes to s3 -> readonly
+        // only the last release owns and deletes the handle
+        if(release_file_handle(fileHandle)){
+          lOwner.reset(fileHandle);
+          if(lUploaded){
+            // the temp file has the content of the new version
+            keep_local_copy(fileHandle, lpath, lSize);
+          }else if(!lWritten){
+            // we have to send no changes to s3 -> readonly
 
 #ifdef S3FS_USE_MEMCACHED
-          key=theCache->getkey(AWSCache::PREFIX_FILE,lpath.substr(1),"").c_str();
-          theCache->save_file(key,dynamic_cast<std::fstream*>(fileHandle->filestream),fileHandle->size); 
+            key=theCache->getkey(AWSCache::PREFIX_FILE,lpath.substr(1),"").c_str();
+            theCache->save_file(key,dynamic_cast<std::fstream*>(fileHandle->filestream),fileHandle->size,fileHandle->etag);
 #endif // S3FS_USE_MEMCACHED
+
+            keep_local_copy(fileHandle, lpath, fileHandle->size);
+          }
         }
 
       }else{
@@ -1566,6 +2411,7 @@ s3_release(const char *path, struct fuse_file_info *fileinfo)
     return result;
   }catch(...){
     S3_LOG_ERROR("An Error occured while trying to release a file.");
+    theStatCache->invalidate(lpath);
 
 #ifdef S3FS_USE_MEMCACHED
     // cleanup cache to prevent future errors
@@ -1600,50 +2446,59 @@ s3_read(const char *path,
         off_t offset,
         struct fuse_file_info *fileinfo)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::READ);
   S3_LOG_DEBUG("path: " << path << " offset: " << offset << " size: " << size);
-  S3_LOG_DEBUG("size of the tempfilemap " << tempfilemap.size());
-
-  std::string lpath(path);
-#ifdef S3FS_USE_MEMCACHED
-  std::string key;
-#endif // S3FS_USE_MEMCACHED
-
-  try{
-    FileHandle* fileHandle=tempfilemap.find((int)fileinfo->fh)->second;
-    std::string tempfilename=fileHandle->filename;
-    std::fstream* tempfile=fileHandle->filestream;
-
-    // get length of file:
-    unsigned int filelength = (unsigned int) fileHandle->size;
 
-    int readsize = 0;
-    if(size>(filelength-offset)){
-      readsize=filelength-offset;
-    }else{
-      readsize=size;
+  // the file handle is the descriptor of the temp file
+  int fd=(int)fileinfo->fh;
+  size_t readsize=0;
+  while(readsize<size){
+    ssize_t lResult=pread(fd, buf+readsize, size-readsize, offset+readsize);
+    if(lResult<0){
+      if(errno==EINTR)
+        continue;
+      S3_LOG_ERROR("reading the temp file of " << path << " failed: " << strerror(errno));
+      return -EIO;
     }
-
-    tempfile->seekg(offset,std::ios_base::beg);
-    memset(buf, 0, readsize); 
-    tempfile->read(buf,readsize);
-    S3_LOG_DEBUG("readsize: " << readsize << " tempfile->gcount(): " << tempfile->gcount());
-    assert(readsize == tempfile->gcount());
-    return readsize;
-  }catch(...){
-    S3_LOG_ERROR("An Error occured while trying to read a file.");
-
-#ifdef S3FS_USE_MEMCACHED
-    // cleanup cache to prevent future errors
-    key=theCache->getkey(AWSCache::PREFIX_EXISTS,lpath.substr(1),"");
-    theCache->delete_key(key);
-    key=theCache->getkey(AWSCache::PREFIX_FILE,lpath.substr(1),"");
-    theCache->delete_key(key);
-#endif // S3FS_USE_MEMCACHED
-
-    return -EIO; // I/O Error
+    if(lResult==0)
+      break; // end of file
+    readsize+=lResult;
   }
+  S3_LOG_DEBUG("readsize: " << readsize);
+  return readsize;
+}
 
+#if FUSE_VERSION >= 29
+/*
+ * Read data from an open file without copying it
+ *
+ * fuse gets the descriptor of the temp file and moves the data to the
+ * kernel itself (with splice if possible). The buffer is freed by fuse.
+ */
+static int
+s3_read_buf(const char *path,
+            struct fuse_bufvec **bufp,
+            size_t size,
+            off_t offset,
+            struct fuse_file_info *fileinfo)
+{
+  OperationTimer lTimer(theCounters, PerfCounters::READ);
+  S3_LOG_DEBUG("path: " << path << " offset: " << offset << " size: " << size);
+
+  struct fuse_bufvec* lBuf=(struct fuse_bufvec*)malloc(sizeof(struct fuse_bufvec));
+  if(lBuf==NULL)
+    return -ENOMEM;
+
+  memset(lBuf, 0, sizeof(struct fuse_bufvec));
+  lBuf->count=1;
+  lBuf->buf[0].size=size;
+  lBuf->buf[0].flags=(enum fuse_buf_flags)(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+  lBuf->buf[0].fd=(int)fileinfo->fh;
+  lBuf->buf[0].pos=offset;
+  *bufp=lBuf;
+  return 0;
 }
+#endif
 
 
 /*
@@ -1651,18 +2506,84 @@ s3_read(const char *path,
  * 
  * This method should check if the open operation is permitted for this directory
  * 
- * it is called before readdir
+ * it is called before readdir and lists the first page of the entries
  */
 
 static int
 s3_opendir(const char *path, struct fuse_file_info *fi)
+{
+  OperationTimer lTimer(theCounters, PerfCounters::OPENDIR);
+  S3_LOG_DEBUG("path: " << path);
+
+  std::string lpath(path);
+  if (lpath.at(lpath.length()-1) != '/')
+    lpath += "/";
+
+  // get object without first /
+  std::auto_ptr<DirHandle> lDir(new DirHandle(lpath.substr(1)));
+  int result = load_first_dir_page(lDir.get());
+  if (result != 0)
+    return result;
+
+  fi->fh = (uint64_t) (uintptr_t) lDir.release();
+  return 0;
+}
+
+/*
+ * Release directory
+ */
+static int
+s3_releasedir(const char *path, struct fuse_file_info *fi)
 {
   S3_LOG_DEBUG("path: " << path);
 
-  // by default allow access
+  DirHandle* lDir = (DirHandle*) (uintptr_t) fi->fh;
+  if (lDir) {
+    finish_prefetch(lDir);
+    delete lDir;
+    fi->fh = 0;
+  }
   return 0;
 }
 
+/*
+ * Initialize filesystem
+ *
+ * called after fuse went to the background, therefore threads must
+ * not be started before
+ */
+static void*
+s3_init(struct fuse_conn_info *conn)
+{
+  if (theInvalidationBus.get()) {
+    S3_LOG_INFO("receiving invalidations on " << theInvalidationBus->getQueueUrl());
+    theInvalidationBus->start();
+  }
+  if (theKeyFilter.get())
+    theKeyFilter->start();
+  if (theNamespaceIndex.get())
+    theNamespaceIndex->start();
+  return NULL;
+}
+
+/*
+ * Clean up filesystem
+ */
+static void
+s3_destroy(void *userdata)
+{
+  if (theInvalidationBus.get())
+    theInvalidationBus->stop();
+  if (theKeyFilter.get())
+    theKeyFilter->stop();
+  if (theNamespaceIndex.get()) {
+    theNamespaceIndex->stop();
+    if (!theNamespaceIndex->write()) {
+      S3_LOG_ERROR("couldn't write the namespace index " << theNamespaceIndexFile);
+    }
+  }
+}
+
 /*
  * Create a symbolic link
  *
@@ -1670,6 +2591,7 @@ s3_opendir(const char *path, struct fuse_file_info *fi)
 static int
 s3_symlink(const char * oldpath, const char * newpath) 
 {
+  OperationTimer lTimer(theCounters, PerfCounters::SYMLINK);
   S3_LOG_DEBUG("oldpath: " << oldpath << " newpath: " << newpath);
   std::string lpath(newpath);
   int result=0;
@@ -1734,6 +2656,7 @@ s3_symlink(const char * oldpath, const char * newpath)
 static int
 s3_readlink(const char * path, char * link, size_t size)
 {
+  OperationTimer lTimer(theCounters, PerfCounters::READLINK);
   S3_LOG_DEBUG("path: " << path << " buffer size: " << sizeof(link));
   std::string lpath(path);
   int result=0;
@@ -1844,7 +2767,13 @@ main(int argc, char **argv)
   s3_filesystem_operations.create     = s3_create;
   s3_filesystem_operations.unlink     = s3_unlink;
   s3_filesystem_operations.opendir    = s3_opendir;
+  s3_filesystem_operations.releasedir = s3_releasedir;
+  s3_filesystem_operations.init       = s3_init;
+  s3_filesystem_operations.destroy    = s3_destroy;
   s3_filesystem_operations.read       = s3_read;
+#if FUSE_VERSION >= 29
+  s3_filesystem_operations.read_buf   = s3_read_buf;
+#endif
   s3_filesystem_operations.write      = s3_write;
   s3_filesystem_operations.open       = s3_open;
   s3_filesystem_operations.release    = s3_release;
@@ -1855,6 +2784,13 @@ main(int argc, char **argv)
   struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
   struct s3fs_config conf;
   memset(&conf, 0, sizeof(conf));
+  conf.stat_cache_ttl = -1;
+  conf.negative_cache_ttl = -1;
+  conf.readdir_stat = -1;
+  conf.file_cache_size = -1;
+  conf.key_filter_interval = -1;
+  conf.memory_file_size = -1;
+  conf.memory_budget = -1;
   fuse_opt_parse(&args, &conf, s3fs_opts, s3fs_opt_proc);
   bool create_mount_dir=false;
 
@@ -1880,6 +2816,31 @@ main(int argc, char **argv)
     }else{
       create_mount_dir=true;
     }
+    if (conf.stat_cache_ttl < 0
+        && lProperties.count(s3fs::utils::Properties::STAT_CACHE_TTL) != 0)
+      STAT_CACHE_TTL = atoi(lProperties[s3fs::utils::Properties::STAT_CACHE_TTL].c_str());
+    if (conf.negative_cache_ttl < 0
+        && lProperties.count(s3fs::utils::Properties::NEGATIVE_CACHE_TTL) != 0)
+      NEGATIVE_CACHE_TTL = atoi(lProperties[s3fs::utils::Properties::NEGATIVE_CACHE_TTL].c_str());
+    if (conf.readdir_stat < 0
+        && lProperties.count(s3fs::utils::Properties::READDIR_STAT) != 0)
+      READDIR_STAT = atoi(lProperties[s3fs::utils::Properties::READDIR_STAT].c_str());
+    if (conf.file_cache_size < 0
+        && lProperties.count(s3fs::utils::Properties::FILE_CACHE_SIZE) != 0)
+      FILE_CACHE_SIZE = atoi(lProperties[s3fs::utils::Properties::FILE_CACHE_SIZE].c_str());
+    if (conf.key_filter_interval < 0
+        && lProperties.count(s3fs::utils::Properties::KEY_FILTER_INTERVAL) != 0)
+      KEY_FILTER_INTERVAL = atoi(lProperties[s3fs::utils::Properties::KEY_FILTER_INTERVAL].c_str());
+    if (!conf.namespace_index)
+      theNamespaceIndexFile = lProperties[s3fs::utils::Properties::NAMESPACE_INDEX];
+    if (conf.memory_file_size < 0
+        && lProperties.count(s3fs::utils::Properties::MEMORY_FILE_SIZE) != 0)
+      MEMORY_FILE_SIZE = atoi(lProperties[s3fs::utils::Properties::MEMORY_FILE_SIZE].c_str());
+    if (conf.memory_budget < 0
+        && lProperties.count(s3fs::utils::Properties::MEMORY_BUDGET) != 0)
+      MEMORY_FILES_BUDGET = atoi(lProperties[s3fs::utils::Properties::MEMORY_BUDGET].c_str());
+    if (!conf.invalidation_queue)
+      theInvalidationQueue = lProperties[s3fs::utils::Properties::INVALIDATION_QUEUE];
 #ifdef S3FS_USE_MEMCACHED
     if (!conf.memcached_servers)
       theMemcachedServers = lProperties[s3fs::utils::Properties::MEMCACHED_SERVERS];
@@ -1900,6 +2861,24 @@ main(int argc, char **argv)
     theS3FSTempFolder = conf.temp_dir;
   if (conf.bucket)
     theBucketname = conf.bucket;
+  if (conf.stat_cache_ttl >= 0)
+    STAT_CACHE_TTL = conf.stat_cache_ttl;
+  if (conf.negative_cache_ttl >= 0)
+    NEGATIVE_CACHE_TTL = conf.negative_cache_ttl;
+  if (conf.readdir_stat >= 0)
+    READDIR_STAT = conf.readdir_stat;
+  if (conf.invalidation_queue)
+    theInvalidationQueue = conf.invalidation_queue;
+  if (conf.file_cache_size >= 0)
+    FILE_CACHE_SIZE = conf.file_cache_size;
+  if (conf.key_filter_interval >= 0)
+    KEY_FILTER_INTERVAL = conf.key_filter_interval;
+  if (conf.namespace_index)
+    theNamespaceIndexFile = conf.namespace_index;
+  if (conf.memory_file_size >= 0)
+    MEMORY_FILE_SIZE = conf.memory_file_size;
+  if (conf.memory_budget >= 0)
+    MEMORY_FILES_BUDGET = conf.memory_budget;
 #ifdef S3FS_USE_MEMCACHED
   if (conf.memcached_servers)
     theMemcachedServers = conf.memcached_servers;
@@ -1950,6 +2929,21 @@ main(int argc, char **argv)
     theS3FSTempFilePattern.append("/");
   theS3FSTempFilePattern.append("s3fs_file_XXXXXX");
 
+  theStatCache.reset(new StatCache(STAT_CACHE_TTL, NEGATIVE_CACHE_TTL, STAT_CACHE_MAX_ENTRIES));
+  theFileCache.reset(new FileCache(FILE_CACHE_SIZE > 0 ? FILE_CACHE_MAX_FILES : 0,
+                                   (long long) FILE_CACHE_SIZE * 1024 * 1024));
+  if (KEY_FILTER_INTERVAL > 0)
+    theKeyFilter.reset(new KeyFilter(list_all_keys, KEY_FILTER_INTERVAL));
+  if (theNamespaceIndexFile.length() != 0) {
+    theNamespaceIndex.reset(new NamespaceIndex(theNamespaceIndexFile, theBucketname,
+                                               validate_namespace_index));
+    if (theNamespaceIndex->open()) {
+      S3_LOG_INFO("mapped " << theNamespaceIndex->getNumberOfRecords() << " records of " << theNamespaceIndexFile);
+    } else {
+      S3_LOG_INFO("starting with an empty namespace index " << theNamespaceIndexFile);
+    }
+  }
+
 #ifdef S3FS_USE_MEMCACHED
   theCache.reset(new AWSCache(theBucketname));
 #endif //S3FS_USE_MEMCACHED
@@ -1998,7 +2992,27 @@ main(int argc, char **argv)
        }
     } 
   }
+  // create the queue on which the other mounts send their invalidations
+  if (theInvalidationQueue.length() != 0) {
+    try {
+      theInvalidationBus.reset(new InvalidationBus(
+          theFactory->createSQSConnection(theAccessKeyId, theSecretAccessKey),
+          theFactory->createSQSConnection(theAccessKeyId, theSecretAccessKey),
+          theInvalidationQueue, invalidate_path));
+      theInvalidationBus->open();
+    } catch (aws::AWSException& e) {
+      S3_LOG_ERROR("couldn't create the invalidation queue " << e.what());
+      std::cerr << e.what() << std::endl;
+      return 9;
+    }
+  }
+
   S3_LOG_INFO("mounting bucket " << theBucketname << " to " << argv[1]);
 
-  return fuse_main(args.argc, args.argv, &s3_filesystem_operations, NULL);
+  int lResult = fuse_main(args.argc, args.argv, &s3_filesystem_operations, NULL);
+
+  // removes the queue if the filesystem couldn't be mounted
+  if (theInvalidationBus.get())
+    theInvalidationBus->stop();
+  return lResult;
 }
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "statcache.h"
+
+#include <string.h>
+
+namespace aws {
+
+StatCache::StatCache(unsigned int aTTL, unsigned int aNegativeTTL, unsigned int aMaxEntries)
+  : theTTL(aTTL),
+    theNegativeTTL(aNegativeTTL),
+    theMaxEntriesPerShard(aMaxEntries / NUMBER_OF_SHARDS + 1)
+{
+}
+
+StatCache::~StatCache()
+{
+}
+
+StatCache::Shard&
+StatCache::getShard(const std::string& aPath)
+{
+  // FNV-1a
+  unsigned int lHash = 2166136261U;
+  for (std::string::size_type i = 0; i < aPath.length(); ++i) {
+    lHash ^= (unsigned char) aPath[i];
+    lHash *= 16777619U;
+  }
+  return theShards[lHash % NUMBER_OF_SHARDS];
+}
+
+bool
+StatCache::lookup(const std::string& aPath, struct stat* aStat, bool* aExists)
+{
+  Shard& lShard = getShard(aPath);
+  bool lFound = false;
+
+  lShard.mutex.lock();
+  EntryMap::iterator lIter = lShard.entries.find(aPath);
+  if (lIter != lShard.entries.end()) {
+    if (lIter->second.expires > time(0)) {
+      *aExists = lIter->second.exists;
+      if (lIter->second.exists)
+        memcpy(aStat, &lIter->second.stbuf, sizeof(struct stat));
+      lFound = true;
+    } else {
+      lShard.entries.erase(lIter);
+    }
+  }
+  lShard.mutex.unlock();
+
+  return lFound;
+}
+
+void
+StatCache::put(const std::string& aPath, const struct stat* aStat)
+{
+  if (theTTL == 0) {
+    invalidate(aPath);
+    return;
+  }
+  Entry lEntry;
+  memcpy(&lEntry.stbuf, aStat, sizeof(struct stat));
+  lEntry.exists = true;
+  lEntry.expires = time(0) + theTTL;
+  insert(aPath, lEntry);
+}
+
+void
+StatCache::putNegative(const std::string& aPath)
+{
+  if (theNegativeTTL == 0) {
+    invalidate(aPath);
+    return;
+  }
+  Entry lEntry;
+  memset(&lEntry.stbuf, 0, sizeof(struct stat));
+  lEntry.exists = false;
+  lEntry.expires = time(0) + theNegativeTTL;
+  insert(aPath, lEntry);
+}
+
+void
+StatCache::invalidate(const std::string& aPath)
+{
+  Shard& lShard = getShard(aPath);
+  lShard.mutex.lock();
+  lShard.entries.erase(aPath);
+  lShard.mutex.unlock();
+}
+
+void
+StatCache::clear()
+{
+  for (unsigned int i = 0; i < NUMBER_OF_SHARDS; ++i) {
+    theShards[i].mutex.lock();
+    theShards[i].entries.clear();
+    theShards[i].mutex.unlock();
+  }
+}
+
+void
+StatCache::insert(const std::string& aPath, const Entry& aEntry)
+{
+  Shard& lShard = getShard(aPath);
+  lShard.mutex.lock();
+  if (lShard.entries.size() >= theMaxEntriesPerShard) {
+    expire(lShard, time(0));
+    // still full -> start over, the entries will be fetched again
+    if (lShard.entries.size() >= theMaxEntriesPerShard)
+      lShard.entries.clear();
+  }
+  lShard.entries[aPath] = aEntry;
+  lShard.mutex.unlock();
+}
+
+void
+StatCache::expire(Shard& aShard, time_t aNow)
+{
+  EntryMap::iterator lIter = aShard.entries.begin();
+  while (lIter != aShard.entries.end()) {
+    if (lIter->second.expires <= aNow)
+      aShard.entries.erase(lIter++);
+    else
+      ++lIter;
+  }
+}
+
+} // namespace aws
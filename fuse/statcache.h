@@ -0,0 +1,98 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3FS_STATCACHE
+#define AWS_S3FS_STATCACHE
+
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <libaws/mutex.h>
+
+namespace aws {
+
+/**
+ * In-process cache for the attributes of files and folders.
+ *
+ * The cache remembers the struct stat of every path that was looked up
+ * and also remembers paths that do not exist (negative entries), so that
+ * repeated getattr calls do not result in a HEAD request to s3.
+ * Every entry expires after a configurable time to live. A ttl of 0
+ * disables the respective kind of entries.
+ *
+ * The entries are spread over a fixed number of shards, each protected
+ * by its own mutex, to keep the lock contention low if fuse runs
+ * multi-threaded.
+ */
+class StatCache
+{
+public:
+  StatCache(unsigned int aTTL, unsigned int aNegativeTTL, unsigned int aMaxEntries);
+
+  ~StatCache();
+
+  /**
+   * Lookup the attributes of the given path.
+   * Returns false if the cache doesn't know anything about the path.
+   * Otherwise aExists tells if the path exists and if it does
+   * the attributes are copied into aStat.
+   */
+  bool lookup(const std::string& aPath, struct stat* aStat, bool* aExists);
+
+  // remember the attributes of an existing path
+  void put(const std::string& aPath, const struct stat* aStat);
+
+  // remember that the path does not exist
+  void putNegative(const std::string& aPath);
+
+  // forget everything about the path
+  void invalidate(const std::string& aPath);
+
+  void clear();
+
+private:
+  struct Entry {
+    struct stat stbuf;
+    bool        exists;
+    time_t      expires;
+  };
+
+  typedef std::map<std::string, Entry> EntryMap;
+
+  struct Shard {
+    AWSMutex mutex;
+    EntryMap entries;
+  };
+
+  static const unsigned int NUMBER_OF_SHARDS = 16;
+
+  Shard        theShards[NUMBER_OF_SHARDS];
+  unsigned int theTTL;
+  unsigned int theNegativeTTL;
+  unsigned int theMaxEntriesPerShard;
+
+  Shard& getShard(const std::string& aPath);
+
+  void insert(const std::string& aPath, const Entry& aEntry);
+
+  // removes expired entries, the shard must be locked
+  static void expire(Shard& aShard, time_t aNow);
+};
+
+} // namespace aws
+
+#endif
@@ -22,9 +22,13 @@
 #include <libaws/connectionpool.h>
 #include <libaws/s3response.h>
 #include <libaws/s3exception.h>
+#include <libaws/s3packstore.h>
 #include <libaws/sqsconnection.h>
 #include <libaws/sqsresponse.h>
 #include <libaws/sqsexception.h>
+#include <libaws/sqsproducer.h>
+#include <libaws/sqsconsumer.h>
+#include <libaws/sqsextendedclient.h>
 #include <libaws/sdbconnection.h>
 #include <libaws/sdbresponse.h>
 #include <libaws/sdbexception.h>
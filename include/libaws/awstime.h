@@ -55,6 +55,7 @@ namespace aws {
        * @param aTime 
        */
       Time ( const Time& aTime);
+      Time& operator=( const Time& aTime );
       
       Time& operator+=( time_t aTime );
       time_t operator-(const Time& aTime) const;
@@ -68,6 +69,34 @@ namespace aws {
       
       time_t getSeconds() const { return theTime ; }
       struct tm getStruct () const;
+
+      // length of the formatted dates, without the terminating null
+      static const size_t RFC1123_LENGTH = 29;  // Fri, 09 Nov 2007 13:05:49 GMT
+      static const size_t ISO8601_LENGTH = 20;  // 2007-11-09T13:05:49Z
+
+      /**
+       * Parses an HTTP date like "Fri, 09 Nov 2007 13:05:49 GMT".
+       * The weekday is optional, the zone may be GMT or UTC with an
+       * optional offset in hours (e.g. GMT+1). Locale and TZ independent.
+       * @param aDateTime the date, trailing whitespace is ignored
+       * @param aSize length of aDateTime
+       * @param aTime the result in seconds since the epoch (UTC)
+       * @return false if the date is malformed, aTime is unchanged then
+       */
+      static bool parseRFC1123 ( const char* aDateTime, size_t aSize, time_t& aTime );
+      /**
+       * Parses an ISO 8601 date like "2009-03-26T12:00:00.000Z" as used in
+       * listings. Fractions of seconds are ignored, a missing zone means UTC.
+       */
+      static bool parseISO8601 ( const char* aDateTime, size_t aSize, time_t& aTime );
+      /**
+       * Writes RFC1123_LENGTH characters and a terminating null to aBuffer.
+       */
+      static void formatRFC1123 ( time_t aTime, char* aBuffer );
+      /**
+       * Writes ISO8601_LENGTH characters and a terminating null to aBuffer.
+       */
+      static void formatISO8601 ( time_t aTime, char* aBuffer );
   };
 } /* namespace aws */
 
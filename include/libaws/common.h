@@ -69,6 +69,9 @@ namespace aws {
   class HeadResponse;
   typedef SmartPtr<HeadResponse> HeadResponsePtr;
 
+  class HeadManyResponse;
+  typedef SmartPtr<HeadManyResponse> HeadManyResponsePtr;
+
   class BucketLoggingStatusResponse;
   typedef SmartPtr<BucketLoggingStatusResponse> BucketLoggingStatusResponsePtr;
 
@@ -105,6 +108,15 @@ namespace aws {
   class DeleteMessageResponse;
   typedef SmartPtr<DeleteMessageResponse> DeleteMessageResponsePtr;
 
+  class SendMessageBatchResponse;
+  typedef SmartPtr<SendMessageBatchResponse> SendMessageBatchResponsePtr;
+
+  class DeleteMessageBatchResponse;
+  typedef SmartPtr<DeleteMessageBatchResponse> DeleteMessageBatchResponsePtr;
+
+  class ChangeMessageVisibilityBatchResponse;
+  typedef SmartPtr<ChangeMessageVisibilityBatchResponse> ChangeMessageVisibilityBatchResponsePtr;
+
   /**
    * SDB stuff
    */
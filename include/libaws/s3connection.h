@@ -18,6 +18,7 @@
 
 #include <istream>
 #include <map>
+#include <vector>
 #include <libaws/common.h>
 
 namespace aws {
@@ -204,6 +205,25 @@ namespace aws {
           const std::string& aKey,
           const std::string& aOldEtag) = 0;
 
+      /*! \brief Receive a part of an object from S3.
+       *
+       * This function receives aLength bytes of the object starting at aOffset.
+       * A negative length receives everything up to the end of the object.
+       *
+       * @param aBucketName The name of the bucket in which the object is stored.
+       * @param aKey The key for which the object should be retrieved.
+       * @param aOffset The offset of the first byte that should be retrieved.
+       * @param aLength The number of bytes that should be retrieved.
+       *
+       * \throws aws::s3::GetException if the object coldn't be received.
+       * \throws aws::AWSConnectionException if a connection error occured.
+       */
+      virtual GetResponsePtr
+      getRange(const std::string& aBucketName,
+               const std::string& aKey,
+               long long aOffset,
+               long long aLength = -1) = 0;
+
       /*! \brief Delete an object from S3. 
        *
        * This function delete an object in the given bucket with the given key from S3.
@@ -236,6 +256,24 @@ namespace aws {
       head(const std::string& aBucketName,
           const std::string& aKey) = 0;
 
+      /*! \brief Retrieve the metadata of many objects concurrently.
+       *
+       * This function sends a HEAD request for every key in aKeys. At most
+       * aConcurrency requests are running at the same time. The requests
+       * are started when the response is opened and the results can be
+       * retrieved in the order they complete. Errors are reported per key
+       * and don't abort the other requests.
+       * The returned response must not outlive this connection.
+       *
+       * @param aBucketName The name of the bucket the objects are stored in.
+       * @param aKeys The keys of the objects.
+       * @param aConcurrency The maximum number of concurrent requests.
+       */
+      virtual HeadManyResponsePtr
+      headMany(const std::string& aBucketName,
+               const std::vector<std::string>& aKeys,
+               int aConcurrency = 10) = 0;
+
       /*! \brief Retrieve the logging status of the bucket.
        *
        * This function retrieves the logging status of the bucket. It returns
@@ -77,7 +77,9 @@ namespace aws {
         TooManyBuckets,
         UnexpectedContent,
         UnresolvableGrantByEmailAddress,
-        NoError
+        NoError,
+        // the request didn't reach S3 or got no response (dns, connect, tls, ...)
+        ConnectionError
       };
 
       ErrorCode getErrorCode()             { return theErrorCode;    }
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_S3PACKSTORE_API_H
+#define AWS_S3PACKSTORE_API_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <libaws/common.h>
+#include <libaws/exception.h>
+#include <libaws/mutex.h>
+
+namespace aws {
+
+  class S3PackStoreException : public AWSException
+  {
+    public:
+      S3PackStoreException(const std::string& aErrorString);
+
+      virtual ~S3PackStoreException() throw();
+
+      virtual const char*
+      what() const throw();
+
+    protected:
+      std::string theErrorString;
+  };
+
+  /*! \brief Stores many small objects in a few large S3 objects.
+   *
+   * Every request to S3 has a fixed cost, which dominates if the objects
+   * are small. The pack store appends small objects to an in-memory pack
+   * that is stored as one S3 object once it reaches the pack size (or
+   * flush() is called). An index object maps every key to the pack, offset
+   * and length of its data. Objects are read with ranged GET requests.
+   *
+   * Deleting or overwriting an object only updates the index. The space
+   * is reclaimed by compact(), which copies the live objects of packs that
+   * consist mostly of garbage into a new pack.
+   *
+   * All objects are stored below the given prefix:
+   *   <prefix>index        the index
+   *   <prefix>pack-N       the packs
+   *
+   * There must be only one store writing to a prefix at a time.
+   * A store may be used by several threads, but all requests go through
+   * its one connection and are serialized.
+   * Objects that are put but not flushed yet are lost if the process dies.
+   */
+  class S3PackStore
+  {
+    public:
+      static const size_t DEFAULT_PACK_SIZE = 8 * 1024 * 1024;
+
+      S3PackStore(const S3ConnectionPtr& aConnection,
+                  const std::string& aBucketName,
+                  const std::string& aPrefix,
+                  size_t aPackSize = DEFAULT_PACK_SIZE);
+
+      //! flushes the pending objects, errors are ignored
+      ~S3PackStore();
+
+      /*! \brief Read the index from S3.
+       *
+       * A store without an index object is empty.
+       *
+       * \throws aws::S3PackStoreException if the index is corrupt.
+       * \throws aws::AWSConnectionException if a connection error occured.
+       */
+      void
+      load();
+
+      /*! \brief Add an object to the current pack.
+       *
+       * The pack is written to S3 once it reaches the pack size.
+       * Keys must not contain a newline.
+       */
+      void
+      put(const std::string& aKey, const char* aData, size_t aSize);
+
+      //! \brief Receive an object, returns false if there is no object with the key.
+      bool
+      get(const std::string& aKey, std::string& aData);
+
+      //! \brief Returns false if there is no object with the key.
+      bool
+      size(const std::string& aKey, long long* aSize);
+
+      //! \brief Delete an object, returns false if there is no object with the key.
+      bool
+      del(const std::string& aKey);
+
+      //! \brief The keys of all objects that start with the given prefix.
+      void
+      keys(const std::string& aPrefix, std::vector<std::string>& aKeys);
+
+      /*! \brief Write the current pack and the index to S3.
+       *
+       * Packs without live objects are deleted afterwards.
+       */
+      void
+      flush();
+
+      /*! \brief Reclaim the space of deleted and overwritten objects.
+       *
+       * Every pack whose garbage ratio is at least aMinGarbageRatio is
+       * rewritten.
+       */
+      void
+      compact(double aMinGarbageRatio = 0.5);
+
+    private:
+      struct Location {
+        std::string Pack;
+        long long   Offset;
+        long long   Length;
+      };
+
+      struct Pack {
+        long long Size;
+        long long LiveBytes;
+      };
+
+      typedef std::map<std::string, Location> LocationMap;
+      typedef std::map<std::string, Pack>     PackMap;
+
+      S3ConnectionPtr theConnection;
+      std::string     theBucketName;
+      std::string     thePrefix;
+      size_t          thePackSize;
+
+      LocationMap     theLocations;    // objects that are stored in a pack on S3
+      LocationMap     thePending;      // objects in theCurrentPack
+      PackMap         thePacks;
+      std::string     theCurrentPack;  // data of the objects that are not flushed yet
+      long long       theNextPack;
+      bool            theIndexModified;
+      AWSMutex        theMutex;
+
+      // the following functions expect the mutex to be locked
+      void
+      release(const Location& aLocation);
+
+      void
+      flushLocked();
+
+      std::string
+      getIndexKey() const { return thePrefix + "index"; }
+
+      std::string
+      getPackKey(long long aNumber) const;
+  };
+
+} /* namespace aws */
+
+#endif /* AWS_S3PACKSTORE_API_H */
@@ -21,6 +21,7 @@
 #include <string>
 #include <libaws/common.h>
 #include <libaws/awstime.h>
+#include <libaws/s3exception.h>
 
 namespace aws {
 
@@ -33,6 +34,7 @@ namespace aws {
       class PutResponse;
       class GetResponse;
       class HeadResponse;
+      class HeadManyResponse;
       class DeleteResponse;
       class DeleteAllResponse;
       class BucketLoggingStatusResponse;
@@ -137,6 +139,7 @@ namespace aws {
       struct Object {
         std::string KeyValue;
         std::string LastModified;
+        Time        LastModifiedTime;  // LastModified parsed
         std::string ETag;
         intmax_t    Size;
       };
@@ -250,6 +253,48 @@ namespace aws {
       HeadResponse(s3::HeadResponse*);
   }; /* class HeadResponse */
 
+  class HeadManyResponse  : public S3Response<s3::HeadManyResponse>
+  {
+    public:
+      struct Object {
+        std::string                         KeyValue;
+        bool                                IsSuccessful;
+        S3Exception::ErrorCode              ErrorCode;
+        std::string                         ErrorMessage;
+        long long                           ContentLength;
+        std::string                         ContentType;
+        std::string                         ETag;
+        std::map<std::string, std::string>  MetaData;
+      };
+
+      virtual ~HeadManyResponse() {}
+
+      virtual const std::string&
+      getBucketName() const;
+
+      /** \brief Start sending the HEAD requests.
+       */
+      virtual void
+      open();
+
+      /** \brief Wait for the next completed HEAD request.
+       *
+       * The results are returned in the order the requests complete.
+       * Returns false if all keys have been returned.
+       */
+      virtual bool
+      next(Object&);
+
+      /** \brief Abort all requests that are still running.
+       */
+      virtual void
+      close();
+
+    private:
+      friend class S3ConnectionImpl;
+      HeadManyResponse(s3::HeadManyResponse*);
+  }; /* class HeadManyResponse */
+
   class DeleteResponse  : public S3Response<s3::DeleteResponse>
   {
     public:
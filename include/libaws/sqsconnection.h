@@ -18,6 +18,7 @@
 
 #include <istream>
 #include <map>
+#include <vector>
 #include <libaws/common.h>
 
 namespace aws {
@@ -25,6 +26,8 @@ namespace aws {
   class SQSConnection : public SmartObject
   {
     public:
+      static const unsigned int MAX_BATCH_ENTRIES = 10;
+
       virtual ~SQSConnection() {}
 
       virtual CreateQueueResponsePtr
@@ -41,15 +44,46 @@ namespace aws {
                   const std::string &aMessageBody,
                   bool aEncodeToBase64 = true) = 0;
 
+      /**
+       * With aWaitTimeSeconds > 0 (at most 20) the request waits until a
+       * message arrives or the time is over (long polling). The connection
+       * is busy for that time, so consumers should use a connection of
+       * their own.
+       */
       virtual ReceiveMessageResponsePtr
       receiveMessage(const std::string &aQueueUrl,
                      int aNumberOfMessages = 0,
                      int aVisibilityTimeout = -1,
-                     bool aDecodeFromBase64 = true) = 0;
+                     bool aDecodeFromBase64 = true,
+                     int aWaitTimeSeconds = 0) = 0;
 
       virtual DeleteMessageResponsePtr
       deleteMessage(const std::string &aQueueUrl, const std::string &aReceiptHandle) = 0;
 
+      /**
+       * The batch actions take between 1 and 10 entries. The entries
+       * of the response refer to the request entries by their index.
+       */
+      virtual SendMessageBatchResponsePtr
+      sendMessageBatch(const std::string &aQueueUrl,
+                       const std::vector<std::string> &aMessageBodies,
+                       bool aEncodeToBase64 = true) = 0;
+
+      virtual DeleteMessageBatchResponsePtr
+      deleteMessageBatch(const std::string &aQueueUrl,
+                         const std::vector<std::string> &aReceiptHandles) = 0;
+
+      virtual ChangeMessageVisibilityBatchResponsePtr
+      changeMessageVisibilityBatch(const std::string &aQueueUrl,
+                                   const std::vector<std::string> &aReceiptHandles,
+                                   int aVisibilityTimeout) = 0;
+
+
+      // limits the duration of a request, 0 (the default) means no limit;
+      // long polling requests are always allowed to finish their wait
+      virtual void
+      setTimeout(long aSeconds) = 0;
+
   }; /* class SQSConnection */
 
 } /* namespace aws */
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_SQSCONSUMER_API_H
+#define AWS_SQSCONSUMER_API_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <libaws/common.h>
+
+namespace aws {
+
+  template <class T> class ConnectionPool;
+
+  /*! \brief Receives and processes the messages of a queue with many threads.
+   *
+   * Receiver threads long-poll the queue and put the messages into a
+   * bounded local buffer. Worker threads take them out of the buffer and
+   * pass them to the handler. The messages that were handled successfully
+   * are deleted in batches. The messages that failed are made visible
+   * again at once, so they are retried.
+   *
+   * Messages that are still buffered or processed when their visibility
+   * timeout is about to end get more time, so slow handlers don't cause
+   * duplicate deliveries.
+   *
+   * Every receiver takes a connection from the pool for the duration of
+   * a long poll. stop() waits for the polls, which take up to POLL_WAIT
+   * seconds.
+   */
+  class SQSConsumer
+  {
+    public:
+      struct Message
+      {
+        std::string body;
+        std::string message_id;
+        std::string receipt_handle;
+      };
+
+      //! returns true if the message can be deleted, it is received again otherwise
+      typedef bool (*Handler)(const Message& aMessage, void* aUserData);
+
+      struct Statistics
+      {
+        unsigned long long received;
+        unsigned long long processed;     // handled successfully
+        unsigned long long failed;        // handler returned false or threw
+        unsigned long long deleted;
+        unsigned long long extended;      // visibility timeouts extended
+        unsigned long long errors;        // failed requests
+        size_t             buffered;
+        size_t             in_progress;
+        double             throughput;    // processed messages per second since start
+        double             lag;           // seconds the oldest buffered message waits
+      };
+
+      static const unsigned int DEFAULT_RECEIVERS = 2;
+      static const unsigned int DEFAULT_WORKERS = 8;
+      static const size_t       DEFAULT_BUFFER_SIZE = 100;
+      static const int          DEFAULT_VISIBILITY_TIMEOUT = 30;  // seconds
+      static const int          POLL_WAIT = 10;                   // seconds
+
+      /*! \brief aVisibilityTimeout is in seconds, the queue default can't be used.
+       *
+       * \throws aws::AWSInitializationException if aVisibilityTimeout isn't positive.
+       */
+      SQSConsumer(ConnectionPool<SQSConnectionPtr>* aPool,
+                  const std::string& aQueueUrl,
+                  Handler aHandler,
+                  void* aUserData = 0,
+                  unsigned int aNumberOfReceivers = DEFAULT_RECEIVERS,
+                  unsigned int aNumberOfWorkers = DEFAULT_WORKERS,
+                  size_t aBufferSize = DEFAULT_BUFFER_SIZE,
+                  int aVisibilityTimeout = DEFAULT_VISIBILITY_TIMEOUT,
+                  bool aDecodeFromBase64 = true);
+
+      ~SQSConsumer();
+
+      void
+      start();
+
+      /*! \brief Stops all threads.
+       *
+       * The messages that are processed at that time are finished, the
+       * buffered ones are made visible again for other consumers.
+       */
+      void
+      stop();
+
+      Statistics
+      getStatistics();
+
+    private:
+      struct Entry
+      {
+        Message   message;
+        long long received;   // milliseconds
+      };
+
+      static const unsigned int MAINTENANCE_INTERVAL = 200;  // milliseconds
+
+      ConnectionPool<SQSConnectionPtr>* thePool;
+      std::string                       theQueueUrl;
+      Handler                           theHandler;
+      void*                             theUserData;
+      unsigned int                      theNumberOfReceivers;
+      unsigned int                      theNumberOfWorkers;
+      size_t                            theBufferSize;
+      int                               theVisibilityTimeout;
+      bool                              theDecode;
+
+      // the following members are protected by the mutex
+      std::deque<Entry>                 theBuffer;
+      std::map<std::string, long long>  theDeadlines;  // receipt handle -> end of the visibility timeout
+      std::vector<std::string>          theAcks;       // to be deleted
+      std::vector<std::string>          theReleases;   // to be made visible again
+      size_t                            theInProgress;
+      Statistics                        theStatistics;
+      long long                         theStarted;
+      bool                              theRunning;
+      bool                              theWorkersRunning;
+      bool                              theMaintenanceRunning;
+
+      pthread_mutex_t                   theMutex;
+      pthread_cond_t                    theReceiversCondition;
+      pthread_cond_t                    theWorkersCondition;
+      pthread_cond_t                    theMaintenanceCondition;
+      std::vector<pthread_t>            theReceivers;
+      std::vector<pthread_t>            theWorkers;
+      pthread_t                         theMaintenance;
+
+      static void* runReceiver(void* aConsumer);
+      static void* runWorker(void* aConsumer);
+      static void* runMaintenance(void* aConsumer);
+
+      void receiveLoop();
+      void workLoop();
+      void maintenanceLoop();
+
+      // sends the pending deletes, releases and extensions, expects the mutex to be locked
+      void maintain(bool aFinal);
+
+      static long long now();
+  };
+
+} /* namespace aws */
+
+#endif /* AWS_SQSCONSUMER_API_H */
@@ -175,6 +175,33 @@ namespace aws {
 		friend class sqs::SQSConnection;
 		
 	};
+
+	class SendMessageBatchException : public SQSException
+	{
+	public:
+		virtual ~SendMessageBatchException() throw();
+	private:
+		friend class sqs::SQSConnection;
+		SendMessageBatchException(const QueryErrorResponse&);
+	};
+
+	class DeleteMessageBatchException : public SQSException
+	{
+	public:
+		virtual ~DeleteMessageBatchException() throw();
+	private:
+		friend class sqs::SQSConnection;
+		DeleteMessageBatchException(const QueryErrorResponse&);
+	};
+
+	class ChangeMessageVisibilityBatchException : public SQSException
+	{
+	public:
+		virtual ~ChangeMessageVisibilityBatchException() throw();
+	private:
+		friend class sqs::SQSConnection;
+		ChangeMessageVisibilityBatchException(const QueryErrorResponse&);
+	};
 } /* namespace aws */
 
 #endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_SQSEXTENDEDCLIENT_API_H
+#define AWS_SQSEXTENDEDCLIENT_API_H
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <libaws/common.h>
+
+namespace aws {
+
+  /*! \brief Sends messages of any size through SQS.
+   *
+   * Message bodies that are larger than the threshold are stored as an
+   * S3 object below the given prefix. Only a small pointer message that
+   * names the object is sent through SQS. Received pointer messages are
+   * recognized and their body is read from S3 on demand.
+   * deleteMessage() also deletes the object.
+   * Pointers to objects outside of the bucket and prefix of the client
+   * are never followed, such messages are received as plain bodies.
+   *
+   * Messages sent with this client can be received with a plain
+   * SQSConnection, but pointer messages then show up as such, as do
+   * the escaped plain bodies that start like a pointer.
+   */
+  class SQSExtendedClient
+  {
+    public:
+      // base64 of this many bytes is exactly the 32 kB limit of SQS
+      static const size_t DEFAULT_THRESHOLD = 24576;
+
+      struct Message
+      {
+        std::string message_id;
+        std::string receipt_handle;
+        std::string body;            // empty if the body is stored on S3
+        bool        offloaded;
+        std::string payload_bucket;  // where the body is stored if it is offloaded
+        std::string payload_key;
+        long long   payload_size;
+      };
+
+      SQSExtendedClient(const SQSConnectionPtr& aSQSConnection,
+                        const S3ConnectionPtr& aS3Connection,
+                        const std::string& aBucketName,
+                        const std::string& aPrefix = "sqs-payloads/",
+                        size_t aThreshold = DEFAULT_THRESHOLD);
+
+      /*! \brief Send a message, returns its message id.
+       *
+       * \throws aws::PutException if the body couldn't be stored on S3.
+       * \throws aws::SendMessageException if the message couldn't be sent.
+       * \throws aws::AWSConnectionException if a connection error occured.
+       */
+      std::string
+      sendMessage(const std::string& aQueueUrl, const std::string& aBody);
+
+      /*! \brief Send a message whose body is read from a stream.
+       *
+       * Bodies of more than the threshold are streamed to S3 and never
+       * held in memory completely.
+       */
+      std::string
+      sendMessage(const std::string& aQueueUrl, std::istream& aBody, long long aSize);
+
+      /*! \brief Receive messages.
+       *
+       * The bodies of offloaded messages are not fetched, use
+       * getPayload() or getBody() for them.
+       */
+      void
+      receiveMessage(const std::string& aQueueUrl,
+                     std::vector<Message>& aMessages,
+                     int aNumberOfMessages = 0,
+                     int aVisibilityTimeout = -1,
+                     int aWaitTimeSeconds = 0);
+
+      /*! \brief Stream the body of an offloaded message.
+       *
+       * The S3 connection is busy until the stream of the response has
+       * been read completely.
+       *
+       * \throws aws::S3Exception if the object isn't below the bucket and
+       *         prefix of this client.
+       */
+      GetResponsePtr
+      getPayload(const Message& aMessage);
+
+      //! \brief The complete body of a message, offloaded or not.
+      void
+      getBody(const Message& aMessage, std::string& aBody);
+
+      /*! \brief Delete the message and the S3 object of its body.
+       *
+       * \throws aws::S3Exception if the object isn't below the bucket and
+       *         prefix of this client, nothing is deleted then.
+       */
+      void
+      deleteMessage(const std::string& aQueueUrl, const Message& aMessage);
+
+    private:
+      SQSConnectionPtr theSQSConnection;
+      S3ConnectionPtr  theS3Connection;
+      std::string      theBucketName;
+      std::string      thePrefix;
+      size_t           theThreshold;
+
+      std::string
+      sendPointer(const std::string& aQueueUrl, const std::string& aKey, long long aSize);
+
+      std::string
+      createKey();
+
+      bool
+      isPayload(const std::string& aBucket, const std::string& aKey) const;
+
+      void
+      checkPayload(const Message& aMessage) const;
+
+      bool
+      parsePointer(const std::string& aBody, Message& aMessage) const;
+  };
+
+} /* namespace aws */
+
+#endif /* AWS_SQSEXTENDEDCLIENT_API_H */
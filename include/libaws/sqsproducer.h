@@ -0,0 +1,158 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_SQSPRODUCER_API_H
+#define AWS_SQSPRODUCER_API_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <libaws/common.h>
+
+namespace aws {
+
+  template <class T> class ConnectionPool;
+
+  /*! \brief Sends messages asynchronously in batches.
+   *
+   * send() only hands the message over, it never waits for SQS. Sender
+   * threads group the messages of each queue into SendMessageBatch
+   * requests. A batch is sent as soon as it has 10 messages, reaches the
+   * byte limit or its oldest message has waited for the linger time.
+   * The batches are sent concurrently on connections taken from the pool.
+   *
+   * The outcome of every message is reported to its callback, which is
+   * called from a sender thread. Callbacks must not call flush() or stop(),
+   * and send() must not be called concurrently with stop().
+   *
+   * send() pushes onto a lock-free stack. The mutex is only taken by the
+   * first message after the senders drained the stack, to wake them up.
+   */
+  class SQSProducer
+  {
+    public:
+      struct Result
+      {
+        bool        successful;
+        std::string message_id;
+        std::string error_code;
+        std::string error_message;
+      };
+
+      typedef void (*Callback)(const Result& aResult, void* aUserData);
+
+      static const unsigned int DEFAULT_SENDERS = 4;
+      static const unsigned int DEFAULT_LINGER = 20;             // milliseconds
+      static const size_t       DEFAULT_MAX_BATCH_BYTES = 32768; // after base64 encoding
+      static const size_t       DEFAULT_MAX_PENDING = 10000;
+
+      SQSProducer(ConnectionPool<SQSConnectionPtr>* aPool,
+                  unsigned int aNumberOfSenders = DEFAULT_SENDERS,
+                  unsigned int aLinger = DEFAULT_LINGER,
+                  size_t aMaxBatchBytes = DEFAULT_MAX_BATCH_BYTES,
+                  bool aEncodeToBase64 = true);
+
+      //! sends the pending messages and stops the sender threads
+      ~SQSProducer();
+
+      void
+      start();
+
+      //! sends the pending messages and stops the sender threads
+      void
+      stop();
+
+      /*! \brief Queue a message for sending.
+       *
+       * Blocks only if DEFAULT_MAX_PENDING messages are waiting already.
+       * Returns false (without calling the callback) if the producer
+       * isn't running.
+       */
+      bool
+      send(const std::string& aQueueUrl, const std::string& aMessageBody,
+           Callback aCallback = 0, void* aUserData = 0);
+
+      //! \brief Waits until no message is pending anymore.
+      void
+      flush();
+
+    private:
+      struct Message
+      {
+        std::string queue_url;
+        std::string body;
+        Callback    callback;
+        void*       user_data;
+        long long   arrival;    // milliseconds
+        Message*    next;       // in the intake stack
+      };
+
+      struct Queue
+      {
+        std::deque<Message*> messages;
+        size_t               bytes;
+      };
+
+      typedef std::map<std::string, Queue> QueueMap;
+
+      ConnectionPool<SQSConnectionPtr>* thePool;
+      unsigned int                      theNumberOfSenders;
+      long long                         theLinger;
+      size_t                            theMaxBatchBytes;
+      bool                              theEncode;
+
+      Message* volatile                 theIntake;     // lock-free stack of new messages
+      volatile size_t                   thePending;    // sent, but not completed yet
+
+      // the following members are protected by the mutex
+      QueueMap                          theQueues;
+      unsigned int                      theFlushes;    // threads waiting in flush()
+      bool                              theRunning;
+      pthread_mutex_t                   theMutex;
+      pthread_cond_t                    theSendersCondition;
+      pthread_cond_t                    theProducersCondition;
+      std::vector<pthread_t>            theSenders;
+
+      static void*
+      runSender(void* aProducer);
+
+      void
+      sendLoop();
+
+      // moves the intake into the queues, expects the mutex to be locked
+      void
+      drainIntake();
+
+      /* takes the next batch that is due, expects the mutex to be locked
+       * otherwise aWakeup is set to the time when the next batch is due
+       */
+      bool
+      takeBatch(std::vector<Message*>& aBatch, long long aNow, long long& aWakeup);
+
+      void
+      sendBatch(const std::vector<Message*>& aBatch);
+
+      size_t
+      encodedSize(const Message* aMessage) const;
+
+      static long long
+      now();
+  };
+
+} /* namespace aws */
+
+#endif /* AWS_SQSPRODUCER_API_H */
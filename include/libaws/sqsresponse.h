@@ -31,6 +31,9 @@ namespace aws {
       class SendMessageResponse;
       class ReceiveMessageResponse;
       class DeleteMessageResponse;
+      class SendMessageBatchResponse;
+      class DeleteMessageBatchResponse;
+      class ChangeMessageVisibilityBatchResponse;
   } /* namespace sqs */
 
   template <class T>
@@ -150,5 +153,78 @@ namespace aws {
       DeleteMessageResponse(sqs::DeleteMessageResponse*);
   };
 
+  /**
+   * Base class of the responses of the batch actions.
+   * next() returns one entry for each entry of the request.
+   * The entries that failed carry the error code and message
+   * that SQS returned for them.
+   */
+  template <class T>
+  class SQSBatchResponse : public SQSResponse<T>
+  {
+    public:
+      virtual ~SQSBatchResponse() {}
+
+      struct Entry
+      {
+        unsigned int index;         // position of the entry in the request
+        bool         successful;
+        std::string  message_id;    // sendMessageBatch only
+        std::string  message_md5;   // sendMessageBatch only
+        std::string  error_code;
+        std::string  error_message;
+        bool         sender_fault;
+      };
+
+      virtual void
+      open();
+
+      virtual bool
+      next(Entry& aEntry);
+
+      virtual void
+      close();
+
+      virtual int
+      getNumberOfEntries() const;
+
+      virtual int
+      getNumberOfFailedEntries() const;
+
+    protected:
+      SQSBatchResponse(T*);
+  };
+
+  class SendMessageBatchResponse : public SQSBatchResponse<sqs::SendMessageBatchResponse>
+  {
+    public:
+      ~SendMessageBatchResponse() {}
+
+    protected:
+      friend class SQSConnectionImpl;
+      SendMessageBatchResponse(sqs::SendMessageBatchResponse*);
+  };
+
+  class DeleteMessageBatchResponse : public SQSBatchResponse<sqs::DeleteMessageBatchResponse>
+  {
+    public:
+      ~DeleteMessageBatchResponse() {}
+
+    protected:
+      friend class SQSConnectionImpl;
+      DeleteMessageBatchResponse(sqs::DeleteMessageBatchResponse*);
+  };
+
+  class ChangeMessageVisibilityBatchResponse
+    : public SQSBatchResponse<sqs::ChangeMessageVisibilityBatchResponse>
+  {
+    public:
+      ~ChangeMessageVisibilityBatchResponse() {}
+
+    protected:
+      friend class SQSConnectionImpl;
+      ChangeMessageVisibilityBatchResponse(sqs::ChangeMessageVisibilityBatchResponse*);
+  };
+
 } /* namespace aws */
 #endif
@@ -96,6 +96,13 @@ namespace aws {
     return new GetResponse(theConnection->get(aBucketName, aKey, aOldEtag));
   }
 
+  GetResponsePtr
+  S3ConnectionImpl::getRange(const std::string& aBucketName, const std::string& aKey,
+                             long long aOffset, long long aLength)
+  {
+    return new GetResponse(theConnection->getRange(aBucketName, aKey, aOffset, aLength));
+  }
+
   DeleteResponsePtr
   S3ConnectionImpl::del(const std::string& aBucketName, const std::string& aKey)
   {
@@ -114,6 +121,13 @@ namespace aws {
     return new HeadResponse(theConnection->head(aBucketName, aKey));
   }
 
+  HeadManyResponsePtr
+  S3ConnectionImpl::headMany(const std::string& aBucketName, const std::vector<std::string>& aKeys,
+                             int aConcurrency)
+  {
+    return new HeadManyResponse(theConnection->headMany(aBucketName, aKeys, aConcurrency));
+  }
+
   BucketLoggingStatusResponsePtr
   S3ConnectionImpl::bucketLoggingStatus(const std::string& aBucketName)
   {
@@ -74,6 +74,10 @@ namespace aws {
       GetResponsePtr
       get(const std::string& aBucketName, const std::string& aKey, const std::string& aOldEtag);
 
+      GetResponsePtr
+      getRange(const std::string& aBucketName, const std::string& aKey,
+               long long aOffset, long long aLength = -1);
+
       DeleteResponsePtr
       del(const std::string& aBucketName, const std::string& aKey);
 
@@ -83,6 +87,10 @@ namespace aws {
       HeadResponsePtr
       head(const std::string& aBucketName, const std::string& aKey);
 
+      HeadManyResponsePtr
+      headMany(const std::string& aBucketName, const std::vector<std::string>& aKeys,
+               int aConcurrency);
+
       BucketLoggingStatusResponsePtr
       bucketLoggingStatus(const std::string& aBucketName);
 
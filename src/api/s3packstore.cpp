@@ -0,0 +1,409 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libaws/s3packstore.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libaws/s3connection.h>
+#include <libaws/s3response.h>
+#include <libaws/s3exception.h>
+
+namespace aws {
+
+  namespace {
+
+    const char* INDEX_HEADER = "libaws-packstore 1";
+
+    class ScopedLock
+    {
+      public:
+        ScopedLock(AWSMutex& aMutex) : theMutex(aMutex) { theMutex.lock(); }
+        ~ScopedLock() { theMutex.unlock(); }
+      private:
+        AWSMutex& theMutex;
+    };
+
+    void
+    readAll(const GetResponsePtr& aResponse, std::string& aData)
+    {
+      std::istream& lStream = aResponse->getInputStream();
+      char lBuffer[4096];
+      aData.clear();
+      while (lStream.good()) {
+        lStream.read(lBuffer, sizeof(lBuffer));
+        aData.append(lBuffer, lStream.gcount());
+      }
+    }
+
+    // splits "a\tb\tc..." into aCount fields, the last field takes the rest of the line
+    bool
+    split(const std::string& aLine, std::string::size_type aStart,
+          std::vector<std::string>& aFields, unsigned int aCount)
+    {
+      aFields.clear();
+      for (unsigned int i = 0; i < aCount - 1; ++i) {
+        std::string::size_type lEnd = aLine.find('\t', aStart);
+        if (lEnd == std::string::npos)
+          return false;
+        aFields.push_back(aLine.substr(aStart, lEnd - aStart));
+        aStart = lEnd + 1;
+      }
+      aFields.push_back(aLine.substr(aStart));
+      return true;
+    }
+
+  } /* namespace */
+
+  S3PackStoreException::S3PackStoreException(const std::string& aErrorString)
+    : theErrorString(aErrorString) {}
+
+  S3PackStoreException::~S3PackStoreException() throw() {}
+
+  const char*
+  S3PackStoreException::what() const throw()
+  {
+    return theErrorString.c_str();
+  }
+
+  S3PackStore::S3PackStore(const S3ConnectionPtr& aConnection,
+                           const std::string& aBucketName,
+                           const std::string& aPrefix,
+                           size_t aPackSize)
+    : theConnection(aConnection),
+      theBucketName(aBucketName),
+      thePrefix(aPrefix),
+      thePackSize(aPackSize),
+      theNextPack(0),
+      theIndexModified(false)
+  {
+  }
+
+  S3PackStore::~S3PackStore()
+  {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  void
+  S3PackStore::load()
+  {
+    ScopedLock lLock(theMutex);
+
+    std::string lIndex;
+    try {
+      GetResponsePtr lRes = theConnection->get(theBucketName, getIndexKey());
+      readAll(lRes, lIndex);
+    } catch (GetException& e) {
+      if (e.getErrorCode() != S3Exception::NoSuchKey)
+        throw;
+      // no index -> empty store
+    }
+
+    theLocations.clear();
+    thePending.clear();
+    thePacks.clear();
+    theCurrentPack.clear();
+    theNextPack = 0;
+    theIndexModified = false;
+
+    if (lIndex.empty())
+      return;
+
+    std::istringstream lStream(lIndex);
+    std::string lLine;
+    std::getline(lStream, lLine);
+    if (lLine != INDEX_HEADER)
+      throw S3PackStoreException("unknown index format in " + getIndexKey());
+
+    std::vector<std::string> lFields;
+    while (std::getline(lStream, lLine)) {
+      if (lLine.length() < 2)
+        continue;
+
+      if (lLine[0] == 'P' && split(lLine, 2, lFields, 2)) {
+        // P <pack> <size>
+        Pack& lPack = thePacks[lFields[0]];
+        lPack.Size = atoll(lFields[1].c_str());
+        lPack.LiveBytes = 0;
+
+        std::string::size_type lPos = lFields[0].rfind('-');
+        if (lPos != std::string::npos) {
+          long long lNumber = atoll(lFields[0].c_str() + lPos + 1);
+          if (lNumber >= theNextPack)
+            theNextPack = lNumber + 1;
+        }
+      } else if (lLine[0] == 'K' && split(lLine, 2, lFields, 4)) {
+        // K <pack> <offset> <length> <key>
+        Location& lLocation = theLocations[lFields[3]];
+        lLocation.Pack = lFields[0];
+        lLocation.Offset = atoll(lFields[1].c_str());
+        lLocation.Length = atoll(lFields[2].c_str());
+        if (!lLocation.Pack.empty())
+          thePacks[lLocation.Pack].LiveBytes += lLocation.Length;
+      } else {
+        throw S3PackStoreException("corrupt line in " + getIndexKey() + ": " + lLine);
+      }
+    }
+  }
+
+  void
+  S3PackStore::put(const std::string& aKey, const char* aData, size_t aSize)
+  {
+    if (aKey.find('\n') != std::string::npos)
+      throw S3PackStoreException("keys must not contain a newline");
+
+    ScopedLock lLock(theMutex);
+
+    LocationMap::iterator lOld = theLocations.find(aKey);
+    if (lOld != theLocations.end()) {
+      release(lOld->second);
+      theLocations.erase(lOld);
+    }
+
+    // an object that is overwritten before the flush remains as garbage in the pack
+    Location& lLocation = thePending[aKey];
+    lLocation.Offset = theCurrentPack.size();
+    lLocation.Length = aSize;
+    theCurrentPack.append(aData, aSize);
+    theIndexModified = true;
+
+    if (theCurrentPack.size() >= thePackSize)
+      flushLocked();
+  }
+
+  bool
+  S3PackStore::get(const std::string& aKey, std::string& aData)
+  {
+    // the connection is used by the writes as well, curl handles can't be shared
+    ScopedLock lLock(theMutex);
+
+    LocationMap::iterator lIter = thePending.find(aKey);
+    if (lIter != thePending.end()) {
+      aData = theCurrentPack.substr(lIter->second.Offset, lIter->second.Length);
+      return true;
+    }
+
+    lIter = theLocations.find(aKey);
+    if (lIter == theLocations.end())
+      return false;
+    const Location& lLocation = lIter->second;
+
+    if (lLocation.Length == 0) {
+      aData.clear();
+      return true;
+    }
+
+    GetResponsePtr lRes = theConnection->getRange(theBucketName, lLocation.Pack,
+                                                  lLocation.Offset, lLocation.Length);
+    readAll(lRes, aData);
+    if ((long long) aData.size() != lLocation.Length)
+      throw S3PackStoreException("short read of " + aKey + " from " + lLocation.Pack);
+    return true;
+  }
+
+  bool
+  S3PackStore::size(const std::string& aKey, long long* aSize)
+  {
+    ScopedLock lLock(theMutex);
+
+    LocationMap::iterator lIter = thePending.find(aKey);
+    if (lIter == thePending.end()) {
+      lIter = theLocations.find(aKey);
+      if (lIter == theLocations.end())
+        return false;
+    }
+    *aSize = lIter->second.Length;
+    return true;
+  }
+
+  bool
+  S3PackStore::del(const std::string& aKey)
+  {
+    ScopedLock lLock(theMutex);
+
+    if (thePending.erase(aKey) != 0)
+      return true;
+
+    LocationMap::iterator lIter = theLocations.find(aKey);
+    if (lIter == theLocations.end())
+      return false;
+
+    release(lIter->second);
+    theLocations.erase(lIter);
+    theIndexModified = true;
+    return true;
+  }
+
+  void
+  S3PackStore::keys(const std::string& aPrefix, std::vector<std::string>& aKeys)
+  {
+    ScopedLock lLock(theMutex);
+
+    aKeys.clear();
+    LocationMap* lMaps[] = { &theLocations, &thePending };
+    for (unsigned int i = 0; i < 2; ++i) {
+      for (LocationMap::iterator lIter = lMaps[i]->lower_bound(aPrefix);
+           lIter != lMaps[i]->end() && lIter->first.compare(0, aPrefix.length(), aPrefix) == 0;
+           ++lIter)
+        aKeys.push_back(lIter->first);
+    }
+    std::sort(aKeys.begin(), aKeys.end());
+  }
+
+  void
+  S3PackStore::flush()
+  {
+    ScopedLock lLock(theMutex);
+    flushLocked();
+  }
+
+  void
+  S3PackStore::compact(double aMinGarbageRatio)
+  {
+    ScopedLock lLock(theMutex);
+
+    std::map<std::string, std::vector<LocationMap::iterator> > lCandidates;
+    for (PackMap::iterator lIter = thePacks.begin(); lIter != thePacks.end(); ++lIter) {
+      const Pack& lPack = lIter->second;
+      if (lPack.Size > 0
+          && (double) (lPack.Size - lPack.LiveBytes) / lPack.Size >= aMinGarbageRatio)
+        lCandidates[lIter->first];
+    }
+    if (lCandidates.empty())
+      return;
+
+    for (LocationMap::iterator lIter = theLocations.begin(); lIter != theLocations.end(); ++lIter) {
+      std::map<std::string, std::vector<LocationMap::iterator> >::iterator lCandidate
+        = lCandidates.find(lIter->second.Pack);
+      if (lCandidate != lCandidates.end())
+        lCandidate->second.push_back(lIter);
+    }
+
+    // copy the live objects into the current pack
+    for (std::map<std::string, std::vector<LocationMap::iterator> >::iterator lCandidate
+           = lCandidates.begin(); lCandidate != lCandidates.end(); ++lCandidate) {
+      std::vector<LocationMap::iterator>& lObjects = lCandidate->second;
+      if (!lObjects.empty()) {
+        std::string lData;
+        readAll(theConnection->get(theBucketName, lCandidate->first), lData);
+
+        for (std::vector<LocationMap::iterator>::iterator lObject = lObjects.begin();
+             lObject != lObjects.end(); ++lObject) {
+          const Location& lOld = (*lObject)->second;
+          if (lOld.Offset + lOld.Length > (long long) lData.size())
+            throw S3PackStoreException("pack " + lCandidate->first + " is shorter than the index says");
+
+          Location& lLocation = thePending[(*lObject)->first];
+          lLocation.Offset = theCurrentPack.size();
+          lLocation.Length = lOld.Length;
+          theCurrentPack.append(lData, lOld.Offset, lOld.Length);
+
+          release(lOld);
+          theLocations.erase(*lObject);
+        }
+      }
+      theIndexModified = true;
+
+      if (theCurrentPack.size() >= thePackSize)
+        flushLocked();
+    }
+
+    // writes the last pack and deletes the old ones
+    flushLocked();
+  }
+
+  void
+  S3PackStore::release(const Location& aLocation)
+  {
+    PackMap::iterator lPack = thePacks.find(aLocation.Pack);
+    if (lPack != thePacks.end())
+      lPack->second.LiveBytes -= aLocation.Length;
+  }
+
+  void
+  S3PackStore::flushLocked()
+  {
+    if (!thePending.empty()) {
+      long long lLiveBytes = 0;
+      for (LocationMap::iterator lIter = thePending.begin(); lIter != thePending.end(); ++lIter)
+        lLiveBytes += lIter->second.Length;
+
+      // empty objects are only in the index, their pack is ""
+      std::string lPackKey;
+      if (lLiveBytes > 0) {
+        lPackKey = getPackKey(theNextPack);
+        theConnection->put(theBucketName, lPackKey, theCurrentPack.data(),
+                           "application/octet-stream", (long) theCurrentPack.size());
+        ++theNextPack;
+
+        Pack& lPack = thePacks[lPackKey];
+        lPack.Size = theCurrentPack.size();
+        lPack.LiveBytes = lLiveBytes;
+      }
+      for (LocationMap::iterator lIter = thePending.begin(); lIter != thePending.end(); ++lIter) {
+        Location& lLocation = theLocations[lIter->first];
+        lLocation = lIter->second;
+        if (lLocation.Length > 0)
+          lLocation.Pack = lPackKey;
+      }
+      thePending.clear();
+      theIndexModified = true;
+    }
+    // only garbage is left if the pending objects were deleted
+    theCurrentPack.clear();
+
+    if (!theIndexModified)
+      return;
+
+    // packs without live objects are left out and deleted after the index is written
+    std::vector<std::string> lDeadPacks;
+    std::ostringstream lIndex;
+    lIndex << INDEX_HEADER << "\n";
+    for (PackMap::iterator lIter = thePacks.begin(); lIter != thePacks.end(); ++lIter) {
+      if (lIter->second.LiveBytes <= 0)
+        lDeadPacks.push_back(lIter->first);
+      else
+        lIndex << "P\t" << lIter->first << "\t" << lIter->second.Size << "\n";
+    }
+    for (LocationMap::iterator lIter = theLocations.begin(); lIter != theLocations.end(); ++lIter) {
+      lIndex << "K\t" << lIter->second.Pack << "\t" << lIter->second.Offset
+             << "\t" << lIter->second.Length << "\t" << lIter->first << "\n";
+    }
+
+    std::string lData = lIndex.str();
+    theConnection->put(theBucketName, getIndexKey(), lData.data(), "text/plain", (long) lData.size());
+    theIndexModified = false;
+
+    for (std::vector<std::string>::iterator lIter = lDeadPacks.begin(); lIter != lDeadPacks.end(); ++lIter) {
+      theConnection->del(theBucketName, *lIter);
+      thePacks.erase(*lIter);
+    }
+  }
+
+  std::string
+  S3PackStore::getPackKey(long long aNumber) const
+  {
+    char lNumber[32];
+    sprintf(lNumber, "%010lld", aNumber);
+    return thePrefix + "pack-" + lNumber;
+  }
+
+} /* namespace aws */
@@ -150,6 +150,7 @@ namespace aws {
     if (theS3Response->next(lKey)) {
       aObject.KeyValue     = lKey.KeyValue;
       aObject.LastModified = lKey.LastModified;
+      aObject.LastModifiedTime = lKey.LastModifiedTime;
       aObject.ETag         = lKey.ETag;
       aObject.Size         = lKey.Length;
       return true;
@@ -307,6 +308,48 @@ namespace aws {
     return theS3Response->getContentType();
   }
 
+  /**
+   * HeadManyResponse
+   */
+  HeadManyResponse::HeadManyResponse(s3::HeadManyResponse* r)
+    : S3Response<s3::HeadManyResponse>(r) {}
+
+  const std::string&
+  HeadManyResponse::getBucketName() const
+  {
+    return theS3Response->getBucketName();
+  }
+
+  void
+  HeadManyResponse::open()
+  {
+    theS3Response->open();
+  }
+
+  bool
+  HeadManyResponse::next(Object& aObject)
+  {
+    s3::HeadManyResponse::Key lKey;
+    if (theS3Response->next(lKey)) {
+      aObject.KeyValue      = lKey.KeyValue;
+      aObject.IsSuccessful  = lKey.IsSuccessful;
+      aObject.ErrorCode     = lKey.ErrorCode;
+      aObject.ErrorMessage  = lKey.ErrorMessage;
+      aObject.ContentLength = lKey.ContentLength;
+      aObject.ContentType   = lKey.ContentType;
+      aObject.ETag          = lKey.ETag;
+      aObject.MetaData      = lKey.MetaData;
+      return true;
+    }
+    return false;
+  }
+
+  void
+  HeadManyResponse::close()
+  {
+    theS3Response->close();
+  }
+
   /**
    * DeleteResponse
    */
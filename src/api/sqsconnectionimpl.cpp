@@ -50,12 +50,14 @@ namespace aws {
   SQSConnectionImpl::receiveMessage(const std::string &aQueueUrl,
                 int aNumberOfMessages,
                 int aVisibilityTimeout,
-                bool aDecode)
+                bool aDecode,
+                int aWaitTimeSeconds)
   {
     return new ReceiveMessageResponse(theConnection->receiveMessage(aQueueUrl,
                                                                     aNumberOfMessages,
                                                                     aVisibilityTimeout,
-                                                                    aDecode));
+                                                                    aDecode,
+                                                                    aWaitTimeSeconds));
   }
 
   DeleteMessageResponsePtr
@@ -65,6 +67,39 @@ namespace aws {
     return new DeleteMessageResponse(theConnection->deleteMessage(aQueueUrl, aReceiptHandle));
   }
 
+  SendMessageBatchResponsePtr
+  SQSConnectionImpl::sendMessageBatch(const std::string &aQueueUrl,
+                                      const std::vector<std::string> &aMessageBodies,
+                                      bool aEncode)
+  {
+    return new SendMessageBatchResponse(theConnection->sendMessageBatch(aQueueUrl,
+                                                                        aMessageBodies,
+                                                                        aEncode));
+  }
+
+  DeleteMessageBatchResponsePtr
+  SQSConnectionImpl::deleteMessageBatch(const std::string &aQueueUrl,
+                                        const std::vector<std::string> &aReceiptHandles)
+  {
+    return new DeleteMessageBatchResponse(theConnection->deleteMessageBatch(aQueueUrl,
+                                                                            aReceiptHandles));
+  }
+
+  ChangeMessageVisibilityBatchResponsePtr
+  SQSConnectionImpl::changeMessageVisibilityBatch(const std::string &aQueueUrl,
+                                                  const std::vector<std::string> &aReceiptHandles,
+                                                  int aVisibilityTimeout)
+  {
+    return new ChangeMessageVisibilityBatchResponse(
+        theConnection->changeMessageVisibilityBatch(aQueueUrl, aReceiptHandles, aVisibilityTimeout));
+  }
+
+  void
+  SQSConnectionImpl::setTimeout(long aSeconds)
+  {
+    theConnection->setTimeout(aSeconds);
+  }
+
   SQSConnectionImpl::SQSConnectionImpl(const std::string& aAccessKeyId,
                                        const std::string& aSecretAccessKey,
                                        const std::string& aCustomHost)
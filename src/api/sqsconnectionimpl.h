@@ -48,11 +48,29 @@ namespace aws {
       receiveMessage(const std::string &aQueueUrl,
                     int aNumberOfMessages = 0,
                     int aVisibilityTimeout = -1,
-                    bool aDecodeFromBase64 = true);
+                    bool aDecodeFromBase64 = true,
+                    int aWaitTimeSeconds = 0);
 
       virtual DeleteMessageResponsePtr
       deleteMessage(const std::string &aQueueUrl, const std::string &aReceiptHandle);
 
+      virtual SendMessageBatchResponsePtr
+      sendMessageBatch(const std::string &aQueueUrl,
+                       const std::vector<std::string> &aMessageBodies,
+                       bool aEncodeToBase64 = true);
+
+      virtual DeleteMessageBatchResponsePtr
+      deleteMessageBatch(const std::string &aQueueUrl,
+                         const std::vector<std::string> &aReceiptHandles);
+
+      virtual ChangeMessageVisibilityBatchResponsePtr
+      changeMessageVisibilityBatch(const std::string &aQueueUrl,
+                                   const std::vector<std::string> &aReceiptHandles,
+                                   int aVisibilityTimeout);
+
+      virtual void
+      setTimeout(long aSeconds);
+
     protected:
       // only the factory can create us
       friend class AWSConnectionFactoryImpl;
@@ -0,0 +1,379 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libaws/sqsconsumer.h>
+
+#include <string.h>
+#include <sys/time.h>
+
+#include <libaws/connectionpool.h>
+#include <libaws/sqsconnection.h>
+#include <libaws/sqsresponse.h>
+#include <libaws/sqsexception.h>
+
+namespace aws {
+
+  namespace {
+
+    enum BatchAction {
+      DELETE_MESSAGES,
+      CHANGE_VISIBILITY
+    };
+
+    // sends the receipt handles in batches, returns the number of successful entries
+    unsigned long long
+    sendInBatches(const SQSConnectionPtr& aConnection, const std::string& aQueueUrl,
+                  BatchAction aAction, const std::vector<std::string>& aReceiptHandles,
+                  int aVisibilityTimeout, unsigned long long& aErrors)
+    {
+      unsigned long long lSuccessful = 0;
+      for (size_t lStart = 0; lStart < aReceiptHandles.size(); lStart += SQSConnection::MAX_BATCH_ENTRIES) {
+        size_t lEnd = lStart + SQSConnection::MAX_BATCH_ENTRIES;
+        if (lEnd > aReceiptHandles.size())
+          lEnd = aReceiptHandles.size();
+        std::vector<std::string> lBatch(aReceiptHandles.begin() + lStart, aReceiptHandles.begin() + lEnd);
+        try {
+          if (aAction == DELETE_MESSAGES) {
+            DeleteMessageBatchResponsePtr lRes = aConnection->deleteMessageBatch(aQueueUrl, lBatch);
+            lSuccessful += lRes->getNumberOfEntries() - lRes->getNumberOfFailedEntries();
+          } else {
+            ChangeMessageVisibilityBatchResponsePtr lRes =
+                aConnection->changeMessageVisibilityBatch(aQueueUrl, lBatch, aVisibilityTimeout);
+            lSuccessful += lRes->getNumberOfEntries() - lRes->getNumberOfFailedEntries();
+          }
+        } catch (AWSException&) {
+          // the messages become visible again once their timeout is over
+          ++aErrors;
+        }
+      }
+      return lSuccessful;
+    }
+
+    struct timespec
+    toTimespec(long long aMilliseconds)
+    {
+      struct timespec lTime;
+      lTime.tv_sec = aMilliseconds / 1000;
+      lTime.tv_nsec = (aMilliseconds % 1000) * 1000000;
+      return lTime;
+    }
+
+  } /* namespace */
+
+  SQSConsumer::SQSConsumer(ConnectionPool<SQSConnectionPtr>* aPool,
+                           const std::string& aQueueUrl,
+                           Handler aHandler,
+                           void* aUserData,
+                           unsigned int aNumberOfReceivers,
+                           unsigned int aNumberOfWorkers,
+                           size_t aBufferSize,
+                           int aVisibilityTimeout,
+                           bool aDecodeFromBase64)
+    : thePool(aPool),
+      theQueueUrl(aQueueUrl),
+      theHandler(aHandler),
+      theUserData(aUserData),
+      theNumberOfReceivers(aNumberOfReceivers == 0 ? 1 : aNumberOfReceivers),
+      theNumberOfWorkers(aNumberOfWorkers == 0 ? 1 : aNumberOfWorkers),
+      theBufferSize(aBufferSize == 0 ? 1 : aBufferSize),
+      theVisibilityTimeout(aVisibilityTimeout),
+      theDecode(aDecodeFromBase64),
+      theInProgress(0),
+      theStarted(0),
+      theRunning(false),
+      theWorkersRunning(false),
+      theMaintenanceRunning(false)
+  {
+    // the deadlines of the messages are computed from it, the queue
+    // default (-1 for receiveMessage) isn't known here
+    if (aVisibilityTimeout <= 0)
+      throw AWSInitializationException("the visibility timeout of a consumer must be positive");
+
+    memset(&theStatistics, 0, sizeof(theStatistics));
+    pthread_mutex_init(&theMutex, NULL);
+    pthread_cond_init(&theReceiversCondition, NULL);
+    pthread_cond_init(&theWorkersCondition, NULL);
+    pthread_cond_init(&theMaintenanceCondition, NULL);
+  }
+
+  SQSConsumer::~SQSConsumer()
+  {
+    stop();
+    pthread_cond_destroy(&theMaintenanceCondition);
+    pthread_cond_destroy(&theWorkersCondition);
+    pthread_cond_destroy(&theReceiversCondition);
+    pthread_mutex_destroy(&theMutex);
+  }
+
+  void
+  SQSConsumer::start()
+  {
+    pthread_mutex_lock(&theMutex);
+    if (theRunning || theWorkersRunning || theMaintenanceRunning) {
+      pthread_mutex_unlock(&theMutex);
+      return;
+    }
+    theRunning = theWorkersRunning = theMaintenanceRunning = true;
+    theStarted = now();
+    pthread_mutex_unlock(&theMutex);
+
+    theReceivers.resize(theNumberOfReceivers);
+    for (unsigned int i = 0; i < theNumberOfReceivers; ++i)
+      pthread_create(&theReceivers[i], NULL, runReceiver, this);
+    theWorkers.resize(theNumberOfWorkers);
+    for (unsigned int i = 0; i < theNumberOfWorkers; ++i)
+      pthread_create(&theWorkers[i], NULL, runWorker, this);
+    pthread_create(&theMaintenance, NULL, runMaintenance, this);
+  }
+
+  void
+  SQSConsumer::stop()
+  {
+    pthread_mutex_lock(&theMutex);
+    bool lWasRunning = theMaintenanceRunning;
+    theRunning = false;
+    pthread_cond_broadcast(&theReceiversCondition);
+    pthread_mutex_unlock(&theMutex);
+
+    if (!lWasRunning)
+      return;
+
+    for (size_t i = 0; i < theReceivers.size(); ++i)
+      pthread_join(theReceivers[i], NULL);
+    theReceivers.clear();
+
+    pthread_mutex_lock(&theMutex);
+    theWorkersRunning = false;
+    pthread_cond_broadcast(&theWorkersCondition);
+    pthread_mutex_unlock(&theMutex);
+
+    for (size_t i = 0; i < theWorkers.size(); ++i)
+      pthread_join(theWorkers[i], NULL);
+    theWorkers.clear();
+
+    // hand the buffered messages to other consumers
+    pthread_mutex_lock(&theMutex);
+    for (std::deque<Entry>::iterator lIter = theBuffer.begin(); lIter != theBuffer.end(); ++lIter) {
+      theReleases.push_back(lIter->message.receipt_handle);
+      theDeadlines.erase(lIter->message.receipt_handle);
+    }
+    theBuffer.clear();
+    theMaintenanceRunning = false;
+    pthread_cond_signal(&theMaintenanceCondition);
+    pthread_mutex_unlock(&theMutex);
+
+    pthread_join(theMaintenance, NULL);
+  }
+
+  SQSConsumer::Statistics
+  SQSConsumer::getStatistics()
+  {
+    long long lNow = now();
+    pthread_mutex_lock(&theMutex);
+    Statistics lStatistics = theStatistics;
+    lStatistics.buffered = theBuffer.size();
+    lStatistics.in_progress = theInProgress;
+    if (theStarted > 0 && lNow > theStarted)
+      lStatistics.throughput = lStatistics.processed * 1000.0 / (lNow - theStarted);
+    if (!theBuffer.empty())
+      lStatistics.lag = (lNow - theBuffer.front().received) / 1000.0;
+    pthread_mutex_unlock(&theMutex);
+    return lStatistics;
+  }
+
+  void*
+  SQSConsumer::runReceiver(void* aConsumer)
+  {
+    static_cast<SQSConsumer*>(aConsumer)->receiveLoop();
+    return NULL;
+  }
+
+  void*
+  SQSConsumer::runWorker(void* aConsumer)
+  {
+    static_cast<SQSConsumer*>(aConsumer)->workLoop();
+    return NULL;
+  }
+
+  void*
+  SQSConsumer::runMaintenance(void* aConsumer)
+  {
+    static_cast<SQSConsumer*>(aConsumer)->maintenanceLoop();
+    return NULL;
+  }
+
+  void
+  SQSConsumer::receiveLoop()
+  {
+    pthread_mutex_lock(&theMutex);
+    while (theRunning) {
+      // the messages in progress count as well, their visibility timeout is running
+      while (theRunning && theBuffer.size() + theInProgress >= theBufferSize)
+        pthread_cond_wait(&theReceiversCondition, &theMutex);
+      if (!theRunning)
+        break;
+
+      size_t lNumber = theBufferSize - theBuffer.size() - theInProgress;
+      if (lNumber > SQSConnection::MAX_BATCH_ENTRIES)
+        lNumber = SQSConnection::MAX_BATCH_ENTRIES;
+      pthread_mutex_unlock(&theMutex);
+
+      std::vector<Entry> lEntries;
+      bool lFailed = false;
+      SQSConnectionPtr lConnection = thePool->getConnection();
+      try {
+        ReceiveMessageResponsePtr lRes = lConnection->receiveMessage(theQueueUrl, lNumber,
+                                                                     theVisibilityTimeout,
+                                                                     theDecode, POLL_WAIT);
+        long long lNow = now();
+        ReceiveMessageResponse::Message lMessage;
+        lRes->open();
+        while (lRes->next(lMessage)) {
+          Entry lEntry;
+          lEntry.message.body.assign(lMessage.message_body, lMessage.message_size);
+          lEntry.message.message_id = lMessage.message_id;
+          lEntry.message.receipt_handle = lMessage.receipt_handle;
+          lEntry.received = lNow;
+          lEntries.push_back(lEntry);
+        }
+        lRes->close();
+      } catch (AWSException&) {
+        lFailed = true;
+      }
+      thePool->release(lConnection);
+
+      pthread_mutex_lock(&theMutex);
+      long long lDeadline = now() + theVisibilityTimeout * 1000LL;
+      for (size_t i = 0; i < lEntries.size(); ++i) {
+        theBuffer.push_back(lEntries[i]);
+        theDeadlines[lEntries[i].message.receipt_handle] = lDeadline;
+      }
+      theStatistics.received += lEntries.size();
+      if (!lEntries.empty())
+        pthread_cond_broadcast(&theWorkersCondition);
+      if (lFailed) {
+        ++theStatistics.errors;
+        // don't hammer a queue that fails
+        struct timespec lTimeout = toTimespec(now() + 1000);
+        if (theRunning)
+          pthread_cond_timedwait(&theReceiversCondition, &theMutex, &lTimeout);
+      }
+    }
+    pthread_mutex_unlock(&theMutex);
+  }
+
+  void
+  SQSConsumer::workLoop()
+  {
+    pthread_mutex_lock(&theMutex);
+    while (true) {
+      while (theWorkersRunning && theBuffer.empty())
+        pthread_cond_wait(&theWorkersCondition, &theMutex);
+      if (!theWorkersRunning)
+        break;
+
+      Entry lEntry = theBuffer.front();
+      theBuffer.pop_front();
+      ++theInProgress;
+      pthread_mutex_unlock(&theMutex);
+
+      bool lSuccessful = false;
+      try {
+        lSuccessful = theHandler(lEntry.message, theUserData);
+      } catch (...) {
+        lSuccessful = false;
+      }
+
+      pthread_mutex_lock(&theMutex);
+      --theInProgress;
+      theDeadlines.erase(lEntry.message.receipt_handle);
+      if (lSuccessful) {
+        ++theStatistics.processed;
+        theAcks.push_back(lEntry.message.receipt_handle);
+        if (theAcks.size() >= SQSConnection::MAX_BATCH_ENTRIES)
+          pthread_cond_signal(&theMaintenanceCondition);
+      } else {
+        ++theStatistics.failed;
+        theReleases.push_back(lEntry.message.receipt_handle);
+      }
+      pthread_cond_signal(&theReceiversCondition);
+    }
+    pthread_mutex_unlock(&theMutex);
+  }
+
+  void
+  SQSConsumer::maintenanceLoop()
+  {
+    pthread_mutex_lock(&theMutex);
+    while (theMaintenanceRunning) {
+      struct timespec lTimeout = toTimespec(now() + MAINTENANCE_INTERVAL);
+      pthread_cond_timedwait(&theMaintenanceCondition, &theMutex, &lTimeout);
+      maintain(!theMaintenanceRunning);
+    }
+    pthread_mutex_unlock(&theMutex);
+  }
+
+  void
+  SQSConsumer::maintain(bool aFinal)
+  {
+    std::vector<std::string> lAcks;
+    std::vector<std::string> lReleases;
+    std::vector<std::string> lExtensions;
+    lAcks.swap(theAcks);
+    lReleases.swap(theReleases);
+
+    // extend the timeout of the messages we still own once two thirds are over
+    if (!aFinal) {
+      long long lNow = now();
+      long long lMargin = theVisibilityTimeout * 1000LL / 3;
+      for (std::map<std::string, long long>::iterator lIter = theDeadlines.begin();
+           lIter != theDeadlines.end(); ++lIter) {
+        if (lIter->second - lNow < lMargin) {
+          lExtensions.push_back(lIter->first);
+          lIter->second = lNow + theVisibilityTimeout * 1000LL;
+        }
+      }
+    }
+
+    if (lAcks.empty() && lReleases.empty() && lExtensions.empty())
+      return;
+
+    pthread_mutex_unlock(&theMutex);
+    unsigned long long lErrors = 0;
+    SQSConnectionPtr lConnection = thePool->getConnection();
+    unsigned long long lDeleted =
+        sendInBatches(lConnection, theQueueUrl, DELETE_MESSAGES, lAcks, 0, lErrors);
+    sendInBatches(lConnection, theQueueUrl, CHANGE_VISIBILITY, lReleases, 0, lErrors);
+    unsigned long long lExtended =
+        sendInBatches(lConnection, theQueueUrl, CHANGE_VISIBILITY, lExtensions,
+                      theVisibilityTimeout, lErrors);
+    thePool->release(lConnection);
+    pthread_mutex_lock(&theMutex);
+
+    theStatistics.deleted += lDeleted;
+    theStatistics.extended += lExtended;
+    theStatistics.errors += lErrors;
+  }
+
+  long long
+  SQSConsumer::now()
+  {
+    // the clock of pthread_cond_timedwait
+    struct timeval lNow;
+    gettimeofday(&lNow, NULL);
+    return (long long) lNow.tv_sec * 1000 + lNow.tv_usec / 1000;
+  }
+
+} /* namespace aws */
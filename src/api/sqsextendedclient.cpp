@@ -0,0 +1,253 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libaws/sqsextendedclient.h>
+
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <libaws/s3connection.h>
+#include <libaws/s3response.h>
+#include <libaws/s3exception.h>
+#include <libaws/sqsconnection.h>
+#include <libaws/sqsresponse.h>
+#include <libaws/sqsexception.h>
+
+namespace aws {
+
+  namespace {
+
+    // <header><bucket>\t<key>\t<size>
+    const std::string POINTER_HEADER = "libaws-sqs-pointer 1\t";
+
+    // put in front of plain bodies that start with one of the headers,
+    // so that they aren't taken for a pointer
+    const std::string ESCAPE_HEADER = "libaws-sqs-plain 1\t";
+
+    const char* PAYLOAD_CONTENT_TYPE = "application/octet-stream";
+
+    unsigned long theKeyCounter = 0;
+
+    bool
+    startsWith(const std::string& aBody, const std::string& aHeader)
+    {
+      return aBody.compare(0, aHeader.size(), aHeader) == 0;
+    }
+
+  } /* namespace */
+
+  SQSExtendedClient::SQSExtendedClient(const SQSConnectionPtr& aSQSConnection,
+                                       const S3ConnectionPtr& aS3Connection,
+                                       const std::string& aBucketName,
+                                       const std::string& aPrefix,
+                                       size_t aThreshold)
+    : theSQSConnection(aSQSConnection),
+      theS3Connection(aS3Connection),
+      theBucketName(aBucketName),
+      thePrefix(aPrefix),
+      theThreshold(aThreshold)
+  {
+  }
+
+  std::string
+  SQSExtendedClient::sendMessage(const std::string& aQueueUrl, const std::string& aBody)
+  {
+    if (startsWith(aBody, POINTER_HEADER) || startsWith(aBody, ESCAPE_HEADER)) {
+      std::string lEscaped = ESCAPE_HEADER + aBody;
+      if (lEscaped.size() <= theThreshold) {
+        SendMessageResponsePtr lRes = theSQSConnection->sendMessage(aQueueUrl, lEscaped);
+        return lRes->getMessageId();
+      }
+    } else if (aBody.size() <= theThreshold) {
+      SendMessageResponsePtr lRes = theSQSConnection->sendMessage(aQueueUrl, aBody);
+      return lRes->getMessageId();
+    }
+
+    std::string lKey = createKey();
+    theS3Connection->put(theBucketName, lKey, aBody.data(), PAYLOAD_CONTENT_TYPE, aBody.size());
+    return sendPointer(aQueueUrl, lKey, aBody.size());
+  }
+
+  std::string
+  SQSExtendedClient::sendMessage(const std::string& aQueueUrl, std::istream& aBody, long long aSize)
+  {
+    if (aSize <= (long long) theThreshold) {
+      std::string lBody;
+      if (aSize > 0) {
+        lBody.resize((size_t) aSize);
+        aBody.read(&lBody[0], aSize);
+        lBody.resize(aBody.gcount());
+      }
+      return sendMessage(aQueueUrl, lBody);
+    }
+
+    std::string lKey = createKey();
+    theS3Connection->put(theBucketName, lKey, aBody, PAYLOAD_CONTENT_TYPE, 0, aSize);
+    return sendPointer(aQueueUrl, lKey, aSize);
+  }
+
+  void
+  SQSExtendedClient::receiveMessage(const std::string& aQueueUrl,
+                                    std::vector<Message>& aMessages,
+                                    int aNumberOfMessages,
+                                    int aVisibilityTimeout,
+                                    int aWaitTimeSeconds)
+  {
+    aMessages.clear();
+    ReceiveMessageResponsePtr lRes = theSQSConnection->receiveMessage(aQueueUrl, aNumberOfMessages,
+                                                                      aVisibilityTimeout, true,
+                                                                      aWaitTimeSeconds);
+    ReceiveMessageResponse::Message lReceived;
+    lRes->open();
+    while (lRes->next(lReceived)) {
+      Message lMessage;
+      lMessage.message_id = lReceived.message_id;
+      lMessage.receipt_handle = lReceived.receipt_handle;
+      std::string lBody(lReceived.message_body, lReceived.message_size);
+      if (startsWith(lBody, ESCAPE_HEADER)) {
+        lMessage.body.assign(lBody, ESCAPE_HEADER.size(), std::string::npos);
+        lMessage.offloaded = false;
+        lMessage.payload_size = lMessage.body.size();
+      } else if (!parsePointer(lBody, lMessage)) {
+        lMessage.body.swap(lBody);
+        lMessage.offloaded = false;
+        lMessage.payload_size = lMessage.body.size();
+      }
+      aMessages.push_back(lMessage);
+    }
+    lRes->close();
+  }
+
+  GetResponsePtr
+  SQSExtendedClient::getPayload(const Message& aMessage)
+  {
+    checkPayload(aMessage);
+    return theS3Connection->get(aMessage.payload_bucket, aMessage.payload_key);
+  }
+
+  void
+  SQSExtendedClient::getBody(const Message& aMessage, std::string& aBody)
+  {
+    if (!aMessage.offloaded) {
+      aBody = aMessage.body;
+      return;
+    }
+
+    GetResponsePtr lRes = getPayload(aMessage);
+    std::istream& lStream = lRes->getInputStream();
+    char lBuffer[4096];
+    aBody.clear();
+    aBody.reserve(aMessage.payload_size);
+    while (lStream.good()) {
+      lStream.read(lBuffer, sizeof(lBuffer));
+      aBody.append(lBuffer, lStream.gcount());
+    }
+  }
+
+  void
+  SQSExtendedClient::deleteMessage(const std::string& aQueueUrl, const Message& aMessage)
+  {
+    if (aMessage.offloaded)
+      checkPayload(aMessage);
+    theSQSConnection->deleteMessage(aQueueUrl, aMessage.receipt_handle);
+    if (aMessage.offloaded)
+      theS3Connection->del(aMessage.payload_bucket, aMessage.payload_key);
+  }
+
+  std::string
+  SQSExtendedClient::sendPointer(const std::string& aQueueUrl, const std::string& aKey, long long aSize)
+  {
+    std::ostringstream lPointer;
+    lPointer << POINTER_HEADER << theBucketName << "\t" << aKey << "\t" << aSize;
+    try {
+      SendMessageResponsePtr lRes = theSQSConnection->sendMessage(aQueueUrl, lPointer.str());
+      return lRes->getMessageId();
+    } catch (AWSException&) {
+      // nobody will ever delete the object otherwise
+      try {
+        theS3Connection->del(theBucketName, aKey);
+      } catch (AWSException&) {
+      }
+      throw;
+    }
+  }
+
+  std::string
+  SQSExtendedClient::createKey()
+  {
+    // unique across processes: host, pid, time and a counter
+    char lHost[256];
+    if (gethostname(lHost, sizeof(lHost)) != 0)
+      lHost[0] = '\0';
+    lHost[sizeof(lHost) - 1] = '\0';
+
+    struct timeval lNow;
+    gettimeofday(&lNow, NULL);
+
+    std::ostringstream lKey;
+    lKey << thePrefix << lHost << "-" << getpid() << "-" << lNow.tv_sec << lNow.tv_usec
+         << "-" << __sync_add_and_fetch(&theKeyCounter, 1);
+    return lKey.str();
+  }
+
+  bool
+  SQSExtendedClient::isPayload(const std::string& aBucket, const std::string& aKey) const
+  {
+    return aBucket == theBucketName && aKey.size() > thePrefix.size() && startsWith(aKey, thePrefix);
+  }
+
+  void
+  SQSExtendedClient::checkPayload(const Message& aMessage) const
+  {
+    // anybody who can send to the queue could otherwise make us read or
+    // delete any object the credentials give access to
+    if (!isPayload(aMessage.payload_bucket, aMessage.payload_key)) {
+      throw S3Exception(S3Exception::AccessDenied,
+                        aMessage.payload_bucket + "/" + aMessage.payload_key
+                        + " is not below " + theBucketName + "/" + thePrefix, "", "");
+    }
+  }
+
+  bool
+  SQSExtendedClient::parsePointer(const std::string& aBody, Message& aMessage) const
+  {
+    if (!startsWith(aBody, POINTER_HEADER))
+      return false;
+
+    std::string::size_type lBucket = POINTER_HEADER.size();
+    std::string::size_type lKey = aBody.find('\t', lBucket);
+    if (lKey == std::string::npos)
+      return false;
+    std::string::size_type lSize = aBody.rfind('\t');
+    if (lSize <= lKey)
+      return false;
+
+    std::string lPayloadBucket = aBody.substr(lBucket, lKey - lBucket);
+    std::string lPayloadKey = aBody.substr(lKey + 1, lSize - lKey - 1);
+    // a pointer that wasn't sent by a client like this one is a plain body
+    if (!isPayload(lPayloadBucket, lPayloadKey))
+      return false;
+
+    aMessage.offloaded = true;
+    aMessage.payload_bucket.swap(lPayloadBucket);
+    aMessage.payload_key.swap(lPayloadKey);
+    aMessage.payload_size = strtoll(aBody.c_str() + lSize + 1, NULL, 10);
+    aMessage.body.clear();
+    return true;
+  }
+
+} /* namespace aws */
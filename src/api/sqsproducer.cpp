@@ -0,0 +1,314 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libaws/sqsproducer.h>
+
+#include <sys/time.h>
+
+#include <libaws/connectionpool.h>
+#include <libaws/sqsconnection.h>
+#include <libaws/sqsresponse.h>
+#include <libaws/sqsexception.h>
+
+namespace aws {
+
+  SQSProducer::SQSProducer(ConnectionPool<SQSConnectionPtr>* aPool,
+                           unsigned int aNumberOfSenders,
+                           unsigned int aLinger,
+                           size_t aMaxBatchBytes,
+                           bool aEncodeToBase64)
+    : thePool(aPool),
+      theNumberOfSenders(aNumberOfSenders == 0 ? 1 : aNumberOfSenders),
+      theLinger(aLinger),
+      theMaxBatchBytes(aMaxBatchBytes),
+      theEncode(aEncodeToBase64),
+      theIntake(0),
+      thePending(0),
+      theFlushes(0),
+      theRunning(false)
+  {
+    pthread_mutex_init(&theMutex, NULL);
+    pthread_cond_init(&theSendersCondition, NULL);
+    pthread_cond_init(&theProducersCondition, NULL);
+  }
+
+  SQSProducer::~SQSProducer()
+  {
+    stop();
+    pthread_cond_destroy(&theProducersCondition);
+    pthread_cond_destroy(&theSendersCondition);
+    pthread_mutex_destroy(&theMutex);
+  }
+
+  void
+  SQSProducer::start()
+  {
+    pthread_mutex_lock(&theMutex);
+    if (theRunning) {
+      pthread_mutex_unlock(&theMutex);
+      return;
+    }
+    theRunning = true;
+    pthread_mutex_unlock(&theMutex);
+
+    theSenders.resize(theNumberOfSenders);
+    for (unsigned int i = 0; i < theNumberOfSenders; ++i)
+      pthread_create(&theSenders[i], NULL, runSender, this);
+  }
+
+  void
+  SQSProducer::stop()
+  {
+    pthread_mutex_lock(&theMutex);
+    bool lWasRunning = theRunning;
+    theRunning = false;
+    pthread_cond_broadcast(&theSendersCondition);
+    pthread_cond_broadcast(&theProducersCondition);
+    pthread_mutex_unlock(&theMutex);
+
+    if (!lWasRunning)
+      return;
+
+    // the senders send everything that is queued before they exit
+    for (size_t i = 0; i < theSenders.size(); ++i)
+      pthread_join(theSenders[i], NULL);
+    theSenders.clear();
+
+    // messages that raced with stop()
+    Message* lMessage = __sync_lock_test_and_set(&theIntake, (Message*) 0);
+    while (lMessage) {
+      Message* lNext = lMessage->next;
+      if (lMessage->callback) {
+        Result lResult;
+        lResult.successful = false;
+        lResult.error_message = "The producer has been stopped";
+        lMessage->callback(lResult, lMessage->user_data);
+      }
+      __sync_fetch_and_sub(&thePending, 1);
+      delete lMessage;
+      lMessage = lNext;
+    }
+  }
+
+  bool
+  SQSProducer::send(const std::string& aQueueUrl, const std::string& aMessageBody,
+                    Callback aCallback, void* aUserData)
+  {
+    if (thePending >= DEFAULT_MAX_PENDING) {
+      pthread_mutex_lock(&theMutex);
+      while (thePending >= DEFAULT_MAX_PENDING && theRunning)
+        pthread_cond_wait(&theProducersCondition, &theMutex);
+      pthread_mutex_unlock(&theMutex);
+    }
+    if (!theRunning)
+      return false;
+
+    Message* lMessage = new Message();
+    lMessage->queue_url = aQueueUrl;
+    lMessage->body = aMessageBody;
+    lMessage->callback = aCallback;
+    lMessage->user_data = aUserData;
+    lMessage->arrival = now();
+    __sync_fetch_and_add(&thePending, 1);
+
+    Message* lHead;
+    do {
+      lHead = theIntake;
+      lMessage->next = lHead;
+    } while (!__sync_bool_compare_and_swap(&theIntake, lHead, lMessage));
+
+    // the senders only wait if they found the intake empty
+    if (lHead == 0) {
+      pthread_mutex_lock(&theMutex);
+      pthread_cond_signal(&theSendersCondition);
+      pthread_mutex_unlock(&theMutex);
+    }
+    return true;
+  }
+
+  void
+  SQSProducer::flush()
+  {
+    pthread_mutex_lock(&theMutex);
+    ++theFlushes;
+    pthread_cond_broadcast(&theSendersCondition);
+    while (thePending > 0 && theRunning)
+      pthread_cond_wait(&theProducersCondition, &theMutex);
+    --theFlushes;
+    pthread_mutex_unlock(&theMutex);
+  }
+
+  void*
+  SQSProducer::runSender(void* aProducer)
+  {
+    static_cast<SQSProducer*>(aProducer)->sendLoop();
+    return NULL;
+  }
+
+  void
+  SQSProducer::sendLoop()
+  {
+    std::vector<Message*> lBatch;
+
+    pthread_mutex_lock(&theMutex);
+    while (true) {
+      drainIntake();
+
+      long long lWakeup = -1;
+      if (takeBatch(lBatch, now(), lWakeup)) {
+        // another batch may be due already
+        pthread_cond_signal(&theSendersCondition);
+        pthread_mutex_unlock(&theMutex);
+
+        sendBatch(lBatch);
+        for (size_t i = 0; i < lBatch.size(); ++i)
+          delete lBatch[i];
+        __sync_fetch_and_sub(&thePending, lBatch.size());
+        lBatch.clear();
+
+        pthread_mutex_lock(&theMutex);
+        pthread_cond_broadcast(&theProducersCondition);
+        continue;
+      }
+
+      if (!theRunning && theQueues.empty())
+        break;
+
+      if (lWakeup < 0) {
+        pthread_cond_wait(&theSendersCondition, &theMutex);
+      } else {
+        struct timespec lTimeout;
+        lTimeout.tv_sec = lWakeup / 1000;
+        lTimeout.tv_nsec = (lWakeup % 1000) * 1000000;
+        pthread_cond_timedwait(&theSendersCondition, &theMutex, &lTimeout);
+      }
+    }
+    pthread_mutex_unlock(&theMutex);
+  }
+
+  void
+  SQSProducer::drainIntake()
+  {
+    Message* lMessage = __sync_lock_test_and_set(&theIntake, (Message*) 0);
+
+    // the stack has the newest message on top
+    std::vector<Message*> lMessages;
+    for (; lMessage; lMessage = lMessage->next)
+      lMessages.push_back(lMessage);
+
+    for (size_t i = lMessages.size(); i > 0; --i) {
+      Message* lNext = lMessages[i - 1];
+      QueueMap::iterator lIter = theQueues.find(lNext->queue_url);
+      if (lIter == theQueues.end()) {
+        lIter = theQueues.insert(QueueMap::value_type(lNext->queue_url, Queue())).first;
+        lIter->second.bytes = 0;
+      }
+      lIter->second.messages.push_back(lNext);
+      lIter->second.bytes += encodedSize(lNext);
+    }
+  }
+
+  bool
+  SQSProducer::takeBatch(std::vector<Message*>& aBatch, long long aNow, long long& aWakeup)
+  {
+    bool lSendAll = !theRunning || theFlushes > 0;
+    for (QueueMap::iterator lIter = theQueues.begin(); lIter != theQueues.end(); ++lIter) {
+      Queue& lQueue = lIter->second;
+      long long lDue = lQueue.messages.front()->arrival + theLinger;
+      bool lFull = lQueue.messages.size() >= SQSConnection::MAX_BATCH_ENTRIES
+                || lQueue.bytes >= theMaxBatchBytes;
+      if (!lSendAll && !lFull && lDue > aNow) {
+        if (aWakeup < 0 || lDue < aWakeup)
+          aWakeup = lDue;
+        continue;
+      }
+
+      // a message that exceeds the limit on its own is sent alone
+      size_t lBytes = 0;
+      while (!lQueue.messages.empty() && aBatch.size() < SQSConnection::MAX_BATCH_ENTRIES) {
+        size_t lSize = encodedSize(lQueue.messages.front());
+        if (!aBatch.empty() && lBytes + lSize > theMaxBatchBytes)
+          break;
+        aBatch.push_back(lQueue.messages.front());
+        lQueue.messages.pop_front();
+        lQueue.bytes -= lSize;
+        lBytes += lSize;
+      }
+      if (lQueue.messages.empty())
+        theQueues.erase(lIter);
+      return true;
+    }
+    return false;
+  }
+
+  void
+  SQSProducer::sendBatch(const std::vector<Message*>& aBatch)
+  {
+    const std::string& lQueueUrl = aBatch.front()->queue_url;
+    std::vector<std::string> lBodies;
+    for (size_t i = 0; i < aBatch.size(); ++i)
+      lBodies.push_back(aBatch[i]->body);
+
+    std::vector<Result> lResults(aBatch.size());
+    for (size_t i = 0; i < lResults.size(); ++i) {
+      lResults[i].successful = false;
+      lResults[i].error_message = "No result for the message";
+    }
+
+    SQSConnectionPtr lConnection = thePool->getConnection();
+    try {
+      SendMessageBatchResponsePtr lResponse =
+          lConnection->sendMessageBatch(lQueueUrl, lBodies, theEncode);
+      SendMessageBatchResponse::Entry lEntry;
+      lResponse->open();
+      while (lResponse->next(lEntry)) {
+        if (lEntry.index >= lResults.size())
+          continue;
+        Result& lResult = lResults[lEntry.index];
+        lResult.successful = lEntry.successful;
+        lResult.message_id = lEntry.message_id;
+        lResult.error_code = lEntry.error_code;
+        lResult.error_message = lEntry.error_message;
+      }
+      lResponse->close();
+    } catch (AWSException& e) {
+      for (size_t i = 0; i < lResults.size(); ++i)
+        lResults[i].error_message = e.what();
+    }
+    thePool->release(lConnection);
+
+    for (size_t i = 0; i < aBatch.size(); ++i) {
+      if (aBatch[i]->callback)
+        aBatch[i]->callback(lResults[i], aBatch[i]->user_data);
+    }
+  }
+
+  size_t
+  SQSProducer::encodedSize(const Message* aMessage) const
+  {
+    size_t lSize = aMessage->body.size();
+    return theEncode ? (lSize + 2) / 3 * 4 : lSize;
+  }
+
+  long long
+  SQSProducer::now()
+  {
+    // the clock of pthread_cond_timedwait
+    struct timeval lNow;
+    gettimeofday(&lNow, NULL);
+    return (long long) lNow.tv_sec * 1000 + lNow.tv_usec / 1000;
+  }
+
+} /* namespace aws */
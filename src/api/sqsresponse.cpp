@@ -156,5 +156,82 @@ namespace aws {
   DeleteMessageResponse::DeleteMessageResponse(sqs::DeleteMessageResponse* r)
     : SQSResponse<sqs::DeleteMessageResponse>(r) {}
 
+  /**
+   * SQSBatchResponse
+   */
+  template <class T>
+  SQSBatchResponse<T>::SQSBatchResponse(T* r)
+    : SQSResponse<T>(r) {}
+
+  template <class T>
+  void
+  SQSBatchResponse<T>::open()
+  {
+    this->theSQSResponse->open();
+  }
+
+  template <class T>
+  bool
+  SQSBatchResponse<T>::next(Entry& aEntry)
+  {
+    sqs::BatchResponse::Entry lEntry;
+    if (this->theSQSResponse->next(lEntry)) {
+      aEntry.index         = lEntry.index;
+      aEntry.successful    = lEntry.successful;
+      aEntry.message_id    = lEntry.message_id;
+      aEntry.message_md5   = lEntry.message_md5;
+      aEntry.error_code    = lEntry.error_code;
+      aEntry.error_message = lEntry.error_message;
+      aEntry.sender_fault  = lEntry.sender_fault;
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  template <class T>
+  void
+  SQSBatchResponse<T>::close()
+  {
+    this->theSQSResponse->close();
+  }
+
+  template <class T>
+  int
+  SQSBatchResponse<T>::getNumberOfEntries() const
+  {
+    return this->theSQSResponse->getNumberOfEntries();
+  }
+
+  template <class T>
+  int
+  SQSBatchResponse<T>::getNumberOfFailedEntries() const
+  {
+    return this->theSQSResponse->getNumberOfFailedEntries();
+  }
+
+  template class SQSBatchResponse<sqs::SendMessageBatchResponse>;
+  template class SQSBatchResponse<sqs::DeleteMessageBatchResponse>;
+  template class SQSBatchResponse<sqs::ChangeMessageVisibilityBatchResponse>;
+
+  /**
+   * SendMessageBatchResponse
+   */
+  SendMessageBatchResponse::SendMessageBatchResponse(sqs::SendMessageBatchResponse* r)
+    : SQSBatchResponse<sqs::SendMessageBatchResponse>(r) {}
+
+  /**
+   * DeleteMessageBatchResponse
+   */
+  DeleteMessageBatchResponse::DeleteMessageBatchResponse(sqs::DeleteMessageBatchResponse* r)
+    : SQSBatchResponse<sqs::DeleteMessageBatchResponse>(r) {}
+
+  /**
+   * ChangeMessageVisibilityBatchResponse
+   */
+  ChangeMessageVisibilityBatchResponse::ChangeMessageVisibilityBatchResponse(
+      sqs::ChangeMessageVisibilityBatchResponse* r)
+    : SQSBatchResponse<sqs::ChangeMessageVisibilityBatchResponse>(r) {}
+
 } /* namespace aws */
 
@@ -16,7 +16,6 @@
 #include "libaws/config.h"
 #include <curl/curl.h>
 #include <openssl/evp.h>
-#include <openssl/bio.h>
 
 #include <fstream>
 #include <istream>
@@ -24,6 +23,8 @@
 #include <sstream>
 
 #include "awsconnection.h"
+#include "base64.h"
+#include "urlencoding.h"
 
 namespace aws {
 
@@ -77,104 +78,45 @@ AWSConnection::~AWSConnection()
 std::string
 AWSConnection::urlEncode(const std::string& aContent)
 {
-  std::string encoded;
-  unsigned char c;
-  unsigned char low, high;
-
-  for (size_t i = 0; i < aContent.size(); i++) {
-    c = aContent[i];
-    if (isalnum(c))
-       encoded += c;
-    else {
-       high = c / 16;
-       low = c % 16;
-       encoded += '%';
-       encoded += (high < 10 ? '0' + high : 'A' + high - 10);
-       encoded += (low < 10 ? '0' + low : 'A' + low - 10);
-    }
-  }
-  return encoded;
+  std::string lResult;
+  UrlEncoding::append(lResult, aContent.data(), aContent.size());
+  return lResult;
 }
 
 std::string
 AWSConnection::base64Encode(const char* aContent, size_t aContentSize,
                             long& aBase64EncodedStringLength)
 {
-  char* lEncodedString;
-
-  // initialization for base64 encoding stuff
-  BIO* lBio = BIO_new(BIO_s_mem());
-  BIO* lB64 = BIO_new(BIO_f_base64());
-  BIO_set_flags(lB64, BIO_FLAGS_BASE64_NO_NL);
-  lBio = BIO_push(lB64, lBio);
-
-  BIO_write(lBio, aContent, aContentSize);
-  BIO_flush(lBio);
-  aBase64EncodedStringLength = BIO_get_mem_data(lBio, &lEncodedString);
-
-  // ensures null termination
-  std::stringstream lTmp;
-  lTmp.write(lEncodedString, aBase64EncodedStringLength);
-
-  BIO_free_all(lBio);
-
-  return lTmp.str(); // copy
+  return base64Encode((const unsigned char*) aContent, aContentSize,
+                      aBase64EncodedStringLength);
 }
 
 std::string
 AWSConnection::base64Encode(const unsigned char* aContent, size_t aContentSize,
                             long& aBase64EncodedStringLength)
 {
-  char* lEncodedString;
-
-  // initialization for base64 encoding stuff
-  BIO* lBio = BIO_new(BIO_s_mem());
-  BIO* lB64 = BIO_new(BIO_f_base64());
-  BIO_set_flags(lB64, BIO_FLAGS_BASE64_NO_NL);
-  lBio = BIO_push(lB64, lBio);
-
-  BIO_write(lBio, aContent, aContentSize);
-  BIO_flush(lBio);
-  aBase64EncodedStringLength = BIO_get_mem_data(lBio, &lEncodedString);
-
-  // ensures null termination
-  std::stringstream lTmp;
-  lTmp.write(lEncodedString, aBase64EncodedStringLength);
-
-  BIO_free_all(lBio);
-  return lTmp.str(); // copy
+  std::string lResult(Base64::encodedSize(aContentSize), '\0');
+  if (aContentSize > 0)
+    Base64::encode(aContent, aContentSize, &lResult[0]);
+  aBase64EncodedStringLength = lResult.size();
+  return lResult;
 }
 
 const char*
-AWSConnection::base64Decode(const char* a64Content, size_t a64ContentSize, size_t &aDecodedStringLength) {
-
-  // initialization for base64 decoding stuff
-  BIO* lBio = BIO_new_mem_buf((char*) a64Content, a64ContentSize);
-	BIO* lB64 = BIO_new(BIO_f_base64());
-	BIO_set_flags(lB64, BIO_FLAGS_BASE64_NO_NL);
-	lBio = BIO_push(lB64, lBio);
-
-	// decode into an NSMutableData
-	char* lStr = new char[8192];
-	aDecodedStringLength = BIO_read(lBio, lStr, 8192);
-
-	// clean up and go home
-	BIO_free_all(lBio);
+AWSConnection::base64Decode(const char* a64Content, size_t a64ContentSize, size_t &aDecodedStringLength)
+{
+  // null terminated, the caller deletes it
+  char* lStr = new char[Base64::decodedSize(a64ContentSize) + 1];
+  if (!Base64::decode(a64Content, a64ContentSize, (unsigned char*) lStr, aDecodedStringLength))
+    aDecodedStringLength = 0;
+  lStr[aDecodedStringLength] = '\0';
   return lStr;
 }
 
 std::string
 aws::AWSConnection::urlencode(const std::string &aStringToEncode)
 {
-  char* lUrlEncodedValue =
-      curl_escape(const_cast<char*>(aStringToEncode.c_str()),
-                                    aStringToEncode.size());
-  // copy the string
-  std::string lRes(lUrlEncodedValue);
-
-  curl_free(lUrlEncodedValue);
-
-  return lRes; // unfortunately, copy again
+  return urlEncode(aStringToEncode);
 }
 
 } /* namespace aws */
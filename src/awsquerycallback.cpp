@@ -31,20 +31,28 @@ namespace aws {
       int nb_attributes,
       int nb_defaulted,
       const xmlChar ** attributes ) {
+     flushText();
      startElement ( localname, nb_attributes, attributes );
   }
 
   void SimpleQueryCallBack::charactersSAXFunc ( const xmlChar * value,
-      int len ) {;
-    characters ( value, len );
-
+      int len ) {
+    theText.append ( ( const char* ) value, len );
   }
 
   void SimpleQueryCallBack::endElementNs ( const xmlChar * localname,
       const xmlChar * prefix,
       const xmlChar * URI ) {
+    flushText();
     endElement ( localname );
   }
+
+  void SimpleQueryCallBack::flushText() {
+    if ( !theText.empty() ) {
+      characters ( BAD_CAST theText.data(), theText.size() );
+      theText.clear();
+    }
+  }
   
   void QueryCallBack::SAX_StartElementNs ( void * ctx,
       const xmlChar * localname,
@@ -17,6 +17,7 @@
 #define AWS_AWSQUERYCALLBACK_H
 
 #include <string.h>
+#include <string>
 
 #include <libxml/parser.h>
 #include "awsqueryresponse.h"
@@ -104,11 +105,22 @@ namespace aws
   class SimpleQueryCallBack : public QueryCallBack {
 
     protected:
-      SimpleQueryCallBack() : QueryCallBack(), theCurrentState(0) {};
+      SimpleQueryCallBack() : QueryCallBack(), theCurrentState(0), theElement(0) {};
       virtual ~SimpleQueryCallBack(){}
 
       uint64_t theCurrentState;
 
+      // id of the element that is started or ended, for handlers that
+      // dispatch through an ElementMap
+      int theElement;
+
+      // the text of an element is collected and passed to characters once,
+      // before the next element starts or ends, instead of in the chunks
+      // the parser reports it in
+      std::string theText;
+
+      void flushText();
+
     public:
       void setState ( uint64_t s )   { theCurrentState |= s; }
       bool isSet ( uint64_t s )      { return (theCurrentState & s) == s; }
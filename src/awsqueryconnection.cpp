@@ -23,6 +23,8 @@
 #include <curl/curl.h>
 #include <sstream>
 #include "awsqueryresponse.h"
+#include "urlencoding.h"
+#include <libaws/awstime.h>
 #include <cassert>
 #include <iostream>
 
@@ -31,8 +33,6 @@ namespace aws {
 
   DEFINE_LOGGER ( aws::AWSQueryConnection );
 
-  std::string AWSQueryConnection::QUERY_DATE_FORMAT("%Y-%m-%dT%H:%M:%SZ");
-
   AWSQueryConnection::AWSQueryConnection ( const std::string &aAccessKeyId,
       const std::string &aSecretAccessKey,
       const std::string& aCustomHost,
@@ -41,10 +41,14 @@ namespace aws {
       bool aIsSecure) :
       AWSConnection ( aAccessKeyId,aSecretAccessKey, aCustomHost, aPort, aIsSecure ),
       theVersion ( aVersion ),
-      theSList(NULL)
+      theSList(NULL),
+      theFormSList(NULL),
+      thePostThreshold(DEFAULT_POST_THRESHOLD),
+      theTimeout(0)
   {
     // always use a content-type text/plain as required by amazon
     theSList = curl_slist_append ( theSList, "Content-Type: text/plain" );
+    theFormSList = curl_slist_append ( theFormSList, "Content-Type: application/x-www-form-urlencoded" );
     curl_easy_setopt ( theCurl, CURLOPT_HTTPHEADER, theSList );
     curl_easy_setopt ( theCurl, CURLOPT_WRITEFUNCTION,  AWSQueryConnection::dataReceiver );
     curl_easy_setopt ( theCurl, CURLOPT_ERRORBUFFER, theCurlErrorBuffer );
@@ -54,6 +58,26 @@ namespace aws {
   AWSQueryConnection::~AWSQueryConnection()
   {
     curl_slist_free_all ( theSList );
+    curl_slist_free_all ( theFormSList );
+  }
+
+  void
+  AWSQueryConnection::setTimeout(long aSeconds)
+  {
+    theTimeout = aSeconds;
+    // timeouts must not use signals in multi-threaded programs
+    curl_easy_setopt ( theCurl, CURLOPT_NOSIGNAL, 1L );
+    curl_easy_setopt ( theCurl, CURLOPT_TIMEOUT, theTimeout );
+  }
+
+  void
+  AWSQueryConnection::raiseTimeout(long aMinimum)
+  {
+    long lTimeout = theTimeout;
+    if (lTimeout > 0 && lTimeout < aMinimum) {
+      lTimeout = aMinimum;
+    }
+    curl_easy_setopt ( theCurl, CURLOPT_TIMEOUT, lTimeout );
   }
 
   void
@@ -110,20 +134,20 @@ namespace aws {
     aCallBack->createParser();
 
     std::stringstream lStringToSign;
-    std::stringstream lUrl;
 
-    // begin with the url
-    lUrl << aURL;
-
-    // build query url and the string to sign
-    bool lFirst = true;
+    // build the encoded parameters and the string to sign
+    theParameters.clear();
     for ( ParameterMapIter lIter = aParameterMap->begin();
           lIter != aParameterMap->end(); ++lIter )
     {
-      lUrl << ( lFirst?lFirst=false,"/?":"&" );
+      if ( !theParameters.empty() ) {
+        theParameters += '&';
+      }
 
       // url encode each value
-      lUrl << ( *lIter ).first << "=" << urlencode ( ( *lIter ).second );
+      theParameters += ( *lIter ).first;
+      theParameters += '=';
+      UrlEncoding::append ( theParameters, ( *lIter ).second.data(), ( *lIter ).second.size() );
 
       // concatenate parameter name and value for the string to sign
       lStringToSign << ( *lIter ).first << ( *lIter ).second;
@@ -142,22 +166,35 @@ namespace aws {
              ( const unsigned char* ) lStringToSign.str().c_str(), lStringToSign.str().size(),
                lEncryptedResult, &lEncryptedResultSize );
 
-      // append the url and base64 encoded signature
+      // append the base64 encoded signature
       long lBase64EncodedStringLength;
-      lUrl << "&Signature=" <<
-          urlencode ( base64Encode ( lEncryptedResult, lEncryptedResultSize,
-                                 lBase64EncodedStringLength ) );
+      theParameters += "&Signature=";
+      std::string lSignature = base64Encode ( lEncryptedResult, lEncryptedResultSize,
+                                              lBase64EncodedStringLength );
+      UrlEncoding::append ( theParameters, lSignature.data(), lSignature.size() );
     }
 
+    // large requests (e.g. SQS message bodies or SDB batches) exceed
+    // the url limits of servers and proxies, they are sent as form data
+    bool lPost = theParameters.size() > thePostThreshold;
+
     // necessary, in order to keep the string until the end of the function
     // can possibly be removed with a newer curl version
     // because it will always copy
-    std::string lUrlString = lUrl.str();
+    std::string lUrlString = aURL + ( lPost ? "/" : "/?" );
+    if ( lPost ) {
+      LOG_INFO("Send request:" << lUrlString << " (POST, " << theParameters.size() << " bytes)");
+
+      // curl reads the body directly from theParameters
+      curl_easy_setopt ( theCurl, CURLOPT_POST, 1L );
+      curl_easy_setopt ( theCurl, CURLOPT_POSTFIELDS, theParameters.data() );
+      curl_easy_setopt ( theCurl, CURLOPT_POSTFIELDSIZE, (long) theParameters.size() );
+      curl_easy_setopt ( theCurl, CURLOPT_HTTPHEADER, theFormSList );
+    } else {
+      lUrlString += theParameters;
+      LOG_INFO("Send request:" << lUrlString);
+    }
 
-    LOG_INFO("Send request:" << lUrlString);
-    
-    
-    
     //std::cout << lUrlString << std::endl;
     // set the request url
     curl_easy_setopt ( theCurl, CURLOPT_URL, lUrlString.c_str() );
@@ -184,6 +221,12 @@ namespace aws {
     CURLcode lCurlCode = curl_easy_perform ( theCurl );
     curl_easy_setopt ( theCurl, CURLOPT_FRESH_CONNECT, "FALSE" );
 
+    if ( lPost ) {
+      // back to the defaults for the next request
+      curl_easy_setopt ( theCurl, CURLOPT_HTTPGET, 1L );
+      curl_easy_setopt ( theCurl, CURLOPT_HTTPHEADER, theSList );
+    }
+
     //If the error code is !=0 and the handler is marked as succefully there was nothing parsed
     //so we should set the error code from the http reques
     if ( lCurlCode != 0 )
@@ -212,7 +255,8 @@ namespace aws {
     
     double lDownloadSize;
     curl_easy_getinfo( theCurl, CURLINFO_SIZE_DOWNLOAD, &lDownloadSize);
-    aCallBack->theInTransfer = lUrlString.size();
+    // a POST sends the parameters in the body instead of the url
+    aCallBack->theInTransfer = lUrlString.size() + ( lPost ? theParameters.size() : 0 );
     aCallBack->theOutTransfer = lDownloadSize;
     aCallBack->destroyParser();
     
@@ -221,18 +265,9 @@ namespace aws {
   std::string
   AWSQueryConnection::getQueryTimestamp()
   {
-    time_t lRawTime; tm*    lPtm;
-    time ( &lRawTime );
-    lPtm = gmtime ( &lRawTime );
-    char   theDateString[31];
-
-#ifndef NDEBUG
-    size_t lTest = strftime ( theDateString, 31, QUERY_DATE_FORMAT.c_str(), lPtm );
-    assert ( lTest < 31 );
-#else
-    strftime ( theDateString, 31, QUERY_DATE_FORMAT.c_str(), lPtm );
-#endif
-    return std::string ( theDateString );
+    char lDateString[Time::ISO8601_LENGTH + 1];
+    Time::formatISO8601 ( time ( 0 ), lDateString );
+    return std::string ( lDateString, Time::ISO8601_LENGTH );
   }
 
   size_t
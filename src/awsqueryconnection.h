@@ -39,6 +39,11 @@ namespace aws {
       std::string theVersion;
 
       curl_slist* theSList;
+      curl_slist* theFormSList;
+
+      // encoded parameters of the current request, reused to keep its capacity
+      std::string theParameters;
+      size_t      thePostThreshold;
 
       struct ltstr
       {
@@ -56,7 +61,8 @@ namespace aws {
       typedef ParameterMap::iterator ParameterMapIter;
 
     public:
-      static std::string QUERY_DATE_FORMAT;
+      // requests whose encoded parameters are larger are sent with POST
+      static const size_t DEFAULT_POST_THRESHOLD = 2048;
 
     public:
       AWSQueryConnection ( const std::string& aAccessKeyId,
@@ -91,6 +97,19 @@ namespace aws {
       
       virtual void setCommons(QueryCallBack& aHandler, QueryResponse* aResponse);
 
+      // limits the duration of every request, 0 (the default) means no limit
+      void setTimeout(long aSeconds);
+
+      // 0 sends every request with POST
+      void setPostThreshold(size_t aBytes) { thePostThreshold = aBytes; }
+
+    protected:
+      long theTimeout;
+
+      // sets the timeout of the next requests to at least aMinimum seconds
+      // if there is a limit, 0 resets it to the configured timeout
+      void raiseTimeout(long aMinimum);
+
   };
 
 } /* namespace aws */
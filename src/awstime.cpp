@@ -25,6 +25,121 @@
 #endif
 
 namespace aws {
+
+  namespace {
+
+    const std::string RFC1123_FORMAT = "%a, %Od %b %Y %T";
+    const std::string ISO8601_FORMAT = "%Y-%m-%dT%H:%M:%S";
+
+    const char DAYS[] = "SunMonTueWedThuFriSat";
+    const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    // days since 1970-01-01 of a date in the proleptic gregorian calendar
+    long long
+    toDays(int aYear, int aMonth, int aDay)
+    {
+      aYear -= aMonth <= 2;
+      int lEra = (aYear >= 0 ? aYear : aYear - 399) / 400;
+      int lYearOfEra = aYear - lEra * 400;
+      int lDayOfYear = (153 * (aMonth > 2 ? aMonth - 3 : aMonth + 9) + 2) / 5 + aDay - 1;
+      int lDayOfEra = lYearOfEra * 365 + lYearOfEra / 4 - lYearOfEra / 100 + lDayOfYear;
+      return lEra * 146097LL + lDayOfEra - 719468;
+    }
+
+    time_t
+    toSeconds(int aYear, int aMonth, int aDay, int aHour, int aMinute, int aSecond)
+    {
+      return (time_t) (toDays(aYear, aMonth, aDay) * 86400
+                       + aHour * 3600 + aMinute * 60 + aSecond);
+    }
+
+    struct Date
+    {
+      int year, month, day, hour, minute, second, weekday;
+    };
+
+    Date
+    toDate(time_t aTime)
+    {
+      long long lDays = aTime / 86400;
+      long long lSeconds = aTime % 86400;
+      if (lSeconds < 0) {
+        lSeconds += 86400;
+        --lDays;
+      }
+      Date lDate;
+      lDate.hour = (int) (lSeconds / 3600);
+      lDate.minute = (int) (lSeconds / 60 % 60);
+      lDate.second = (int) (lSeconds % 60);
+      lDate.weekday = (int) ((lDays % 7 + 11) % 7);  // 1970-01-01 was a thursday
+
+      lDays += 719468;
+      long long lEra = (lDays >= 0 ? lDays : lDays - 146096) / 146097;
+      int lDayOfEra = (int) (lDays - lEra * 146097);
+      int lYearOfEra = (lDayOfEra - lDayOfEra / 1460 + lDayOfEra / 36524
+                        - lDayOfEra / 146096) / 365;
+      int lDayOfYear = lDayOfEra - (365 * lYearOfEra + lYearOfEra / 4 - lYearOfEra / 100);
+      int lMonth = (5 * lDayOfYear + 2) / 153;
+      lDate.day = lDayOfYear - (153 * lMonth + 2) / 5 + 1;
+      lDate.month = lMonth < 10 ? lMonth + 3 : lMonth - 9;
+      lDate.year = (int) (lYearOfEra + lEra * 400) + (lDate.month <= 2);
+      return lDate;
+    }
+
+    // reads exactly aDigits digits
+    inline bool
+    readNumber(const char*& aPos, const char* aEnd, int aDigits, int& aNumber)
+    {
+      if (aEnd - aPos < aDigits)
+        return false;
+      int lNumber = 0;
+      for (int i = 0; i < aDigits; ++i) {
+        unsigned int lDigit = (unsigned char) aPos[i] - '0';
+        if (lDigit > 9)
+          return false;
+        lNumber = lNumber * 10 + lDigit;
+      }
+      aNumber = lNumber;
+      aPos += aDigits;
+      return true;
+    }
+
+    inline bool
+    readChar(const char*& aPos, const char* aEnd, char aChar)
+    {
+      if (aPos == aEnd || *aPos != aChar)
+        return false;
+      ++aPos;
+      return true;
+    }
+
+    inline void
+    writeNumber(char*& aPos, int aNumber, int aDigits)
+    {
+      for (int i = aDigits - 1; i >= 0; --i) {
+        aPos[i] = '0' + aNumber % 10;
+        aNumber /= 10;
+      }
+      aPos += aDigits;
+    }
+
+    inline bool
+    isValid(int aMonth, int aDay, int aHour, int aMinute, int aSecond)
+    {
+      return aMonth >= 1 && aMonth <= 12 && aDay >= 1 && aDay <= 31
+          && aHour <= 23 && aMinute <= 59 && aSecond <= 60;
+    }
+
+    inline const char*
+    skipSpaces(const char* aPos, const char* aEnd)
+    {
+      while (aPos != aEnd && (*aPos == ' ' || *aPos == '\t' || *aPos == '\r' || *aPos == '\n'))
+        ++aPos;
+      return aPos;
+    }
+
+  } /* namespace */
+
   Time::Time() : theTime(0) {}
   Time::Time ( time_t aTime) : theTime(aTime) {}
   
@@ -42,8 +157,29 @@ namespace aws {
   }
   
   Time::Time ( const Time& aTime) : theTime(aTime.theTime) {}
+
+  Time& Time::operator=( const Time& aTime ) {
+    theTime = aTime.theTime;
+    return *this;
+  }
   
   void Time::setUp(const std::string& aDateTime, const std::string& aFormat) {
+    // the formats of S3 are parsed without strptime
+    if (aFormat == RFC1123_FORMAT) {
+      theTime = 0;
+#ifndef NDEBUG
+      bool lParsed = parseRFC1123(aDateTime.data(), aDateTime.size(), theTime);
+      assert(lParsed);
+#else
+      parseRFC1123(aDateTime.data(), aDateTime.size(), theTime);
+#endif
+      return;
+    }
+    if (aFormat.compare(0, ISO8601_FORMAT.size(), ISO8601_FORMAT) == 0
+        && parseISO8601(aDateTime.data(), aDateTime.size(), theTime)) {
+      return;
+    }
+
     struct tm aTm;
     memset(&aTm, 0, sizeof(aTm));
 #ifndef NDEBUG
@@ -52,7 +188,9 @@ namespace aws {
 #else
     strptime(aDateTime.c_str(), aFormat.c_str(), &aTm);
 #endif
-    theTime = mktime(&aTm);
+    // the date is UTC, mktime would interpret it as local time
+    theTime = toSeconds(aTm.tm_year + 1900, aTm.tm_mon + 1, aTm.tm_mday,
+                        aTm.tm_hour, aTm.tm_min, aTm.tm_sec);
     
     std::string::size_type aLoc = aDateTime.find( "GMT", 0 );
     if( aLoc != std::string::npos && (aLoc + 3 < aDateTime.size()) ) {
@@ -112,6 +250,144 @@ namespace aws {
     return lTm;
   }
   
+
+  bool Time::parseRFC1123(const char* aDateTime, size_t aSize, time_t& aTime) {
+    // header values end with \r\n
+    const char* lEnd = aDateTime + aSize;
+    while (lEnd != aDateTime && (lEnd[-1] == ' ' || lEnd[-1] == '\t'
+                                 || lEnd[-1] == '\r' || lEnd[-1] == '\n'))
+      --lEnd;
+    const char* lPos = skipSpaces(aDateTime, lEnd);
+
+    // the weekday is redundant
+    if (lEnd - lPos >= 5 && lPos[3] == ',')
+      lPos = skipSpaces(lPos + 4, lEnd);
+
+    int lDay, lYear, lHour, lMinute, lSecond;
+    // single digit days, with or without padding
+    if (!readNumber(lPos, lEnd, 2, lDay) && !readNumber(lPos, lEnd, 1, lDay))
+      return false;
+    if (!readChar(lPos, lEnd, ' ') || lEnd - lPos < 4)
+      return false;
+
+    int lMonth = 0;
+    for (int i = 0; i < 12; ++i) {
+      if (lPos[0] == MONTHS[3 * i] && lPos[1] == MONTHS[3 * i + 1] && lPos[2] == MONTHS[3 * i + 2]) {
+        lMonth = i + 1;
+        break;
+      }
+    }
+    lPos += 3;
+    if (lMonth == 0 || !readChar(lPos, lEnd, ' ')
+        || !readNumber(lPos, lEnd, 4, lYear) || !readChar(lPos, lEnd, ' ')
+        || !readNumber(lPos, lEnd, 2, lHour) || !readChar(lPos, lEnd, ':')
+        || !readNumber(lPos, lEnd, 2, lMinute) || !readChar(lPos, lEnd, ':')
+        || !readNumber(lPos, lEnd, 2, lSecond)
+        || !isValid(lMonth, lDay, lHour, lMinute, lSecond))
+      return false;
+
+    time_t lTime = toSeconds(lYear, lMonth, lDay, lHour, lMinute, lSecond);
+
+    // GMT, UTC, and the offsets that setUp always accepted (GMT+1)
+    lPos = skipSpaces(lPos, lEnd);
+    if (lEnd - lPos >= 3 && (strncmp(lPos, "GMT", 3) == 0 || strncmp(lPos, "UTC", 3) == 0)) {
+      lPos += 3;
+      if (lPos != lEnd && (*lPos == '+' || *lPos == '-')) {
+        int lSign = *lPos++ == '-' ? -1 : 1;
+        int lOffset = 0;
+        if (lPos == lEnd)
+          return false;
+        while (lPos != lEnd && *lPos >= '0' && *lPos <= '9')
+          lOffset = lOffset * 10 + (*lPos++ - '0');
+        lTime -= lSign * lOffset * 3600;
+      }
+    }
+    if (lPos != lEnd)
+      return false;
+
+    aTime = lTime;
+    return true;
+  }
+
+  bool Time::parseISO8601(const char* aDateTime, size_t aSize, time_t& aTime) {
+    const char* lPos = skipSpaces(aDateTime, aDateTime + aSize);
+    const char* lEnd = aDateTime + aSize;
+
+    int lYear, lMonth, lDay, lHour, lMinute, lSecond;
+    if (!readNumber(lPos, lEnd, 4, lYear) || !readChar(lPos, lEnd, '-')
+        || !readNumber(lPos, lEnd, 2, lMonth) || !readChar(lPos, lEnd, '-')
+        || !readNumber(lPos, lEnd, 2, lDay)
+        || (!readChar(lPos, lEnd, 'T') && !readChar(lPos, lEnd, ' '))
+        || !readNumber(lPos, lEnd, 2, lHour) || !readChar(lPos, lEnd, ':')
+        || !readNumber(lPos, lEnd, 2, lMinute) || !readChar(lPos, lEnd, ':')
+        || !readNumber(lPos, lEnd, 2, lSecond)
+        || !isValid(lMonth, lDay, lHour, lMinute, lSecond))
+      return false;
+
+    if (readChar(lPos, lEnd, '.')) {
+      while (lPos != lEnd && *lPos >= '0' && *lPos <= '9')
+        ++lPos;
+    }
+
+    time_t lTime = toSeconds(lYear, lMonth, lDay, lHour, lMinute, lSecond);
+    if (lPos != lEnd && (*lPos == '+' || *lPos == '-')) {
+      int lSign = *lPos++ == '-' ? -1 : 1;
+      int lOffsetHours, lOffsetMinutes;
+      if (!readNumber(lPos, lEnd, 2, lOffsetHours))
+        return false;
+      readChar(lPos, lEnd, ':');
+      if (!readNumber(lPos, lEnd, 2, lOffsetMinutes))
+        return false;
+      lTime -= lSign * (lOffsetHours * 3600 + lOffsetMinutes * 60);
+    } else {
+      readChar(lPos, lEnd, 'Z');
+    }
+    if (skipSpaces(lPos, lEnd) != lEnd)
+      return false;
+
+    aTime = lTime;
+    return true;
+  }
+
+  void Time::formatRFC1123(time_t aTime, char* aBuffer) {
+    Date lDate = toDate(aTime);
+    char* lPos = aBuffer;
+    memcpy(lPos, DAYS + 3 * lDate.weekday, 3);
+    lPos[3] = ',';
+    lPos[4] = ' ';
+    lPos += 5;
+    writeNumber(lPos, lDate.day, 2);
+    *lPos++ = ' ';
+    memcpy(lPos, MONTHS + 3 * (lDate.month - 1), 3);
+    lPos[3] = ' ';
+    lPos += 4;
+    writeNumber(lPos, lDate.year, 4);
+    *lPos++ = ' ';
+    writeNumber(lPos, lDate.hour, 2);
+    *lPos++ = ':';
+    writeNumber(lPos, lDate.minute, 2);
+    *lPos++ = ':';
+    writeNumber(lPos, lDate.second, 2);
+    memcpy(lPos, " GMT", 5);
+  }
+
+  void Time::formatISO8601(time_t aTime, char* aBuffer) {
+    Date lDate = toDate(aTime);
+    char* lPos = aBuffer;
+    writeNumber(lPos, lDate.year, 4);
+    *lPos++ = '-';
+    writeNumber(lPos, lDate.month, 2);
+    *lPos++ = '-';
+    writeNumber(lPos, lDate.day, 2);
+    *lPos++ = 'T';
+    writeNumber(lPos, lDate.hour, 2);
+    *lPos++ = ':';
+    writeNumber(lPos, lDate.minute, 2);
+    *lPos++ = ':';
+    writeNumber(lPos, lDate.second, 2);
+    memcpy(lPos, "Z", 2);
+  }
+  
 } /* namespace aws */
 
 std::ostream & operator << ( std::ostream & aOStream, const aws::Time & aTime ) {
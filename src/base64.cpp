@@ -0,0 +1,325 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "base64.h"
+
+// the vector code is compiled with target attributes and selected at
+// runtime, so the library doesn't need to be built with -mavx2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define AWS_BASE64_X86
+#  include <immintrin.h>
+#endif
+
+namespace aws {
+
+namespace {
+
+  const char ALPHABET[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  const unsigned char PAD = 253;
+  const unsigned char SPACE = 254;
+  const unsigned char INVALID = 255;
+
+  const unsigned char DECODE[256] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 254, 254, 255, 255, 254, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
+     52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 253, 255, 255,
+    255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
+    255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+     41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+  };
+
+  void
+  encodeScalar(const unsigned char* aData, size_t aSize, char* aResult)
+  {
+    size_t i = 0;
+    for (; i + 3 <= aSize; i += 3) {
+      unsigned int lTriple = (aData[i] << 16) | (aData[i + 1] << 8) | aData[i + 2];
+      *aResult++ = ALPHABET[lTriple >> 18];
+      *aResult++ = ALPHABET[(lTriple >> 12) & 0x3f];
+      *aResult++ = ALPHABET[(lTriple >> 6) & 0x3f];
+      *aResult++ = ALPHABET[lTriple & 0x3f];
+    }
+    if (i + 1 == aSize) {
+      *aResult++ = ALPHABET[aData[i] >> 2];
+      *aResult++ = ALPHABET[(aData[i] & 0x03) << 4];
+      *aResult++ = '=';
+      *aResult++ = '=';
+    } else if (i + 2 == aSize) {
+      *aResult++ = ALPHABET[aData[i] >> 2];
+      *aResult++ = ALPHABET[((aData[i] & 0x03) << 4) | (aData[i + 1] >> 4)];
+      *aResult++ = ALPHABET[(aData[i + 1] & 0x0f) << 2];
+      *aResult++ = '=';
+    }
+  }
+
+  bool
+  decodeScalar(const char* aData, size_t aSize, unsigned char* aResult, size_t& aResultSize)
+  {
+    unsigned char* lResult = aResult;
+    unsigned int lBits = 0;
+    unsigned int lNumberOfBits = 0;
+    for (size_t i = 0; i < aSize; ++i) {
+      unsigned char lValue = DECODE[(unsigned char) aData[i]];
+      if (lValue < 64) {
+        lBits = (lBits << 6) | lValue;
+        lNumberOfBits += 6;
+        if (lNumberOfBits >= 8) {
+          lNumberOfBits -= 8;
+          *lResult++ = (unsigned char) (lBits >> lNumberOfBits);
+        }
+      } else if (lValue == PAD) {
+        break;
+      } else if (lValue != SPACE) {
+        return false;
+      }
+    }
+    aResultSize = lResult - aResult;
+    return true;
+  }
+
+#ifdef AWS_BASE64_X86
+
+  enum Implementation { SCALAR, SSSE3, AVX2 };
+
+  Implementation
+  detect()
+  {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+      return SSSE3;
+    return SCALAR;
+  }
+
+  const Implementation theImplementation = detect();
+
+  /*
+   * Encoding after Mula: the 12 input bytes of a lane are spread to 16
+   * bytes, the 6 bit indices are moved into place with two multiplications
+   * and the alphabet is computed from the index range with pshufb.
+   */
+  __attribute__((target("ssse3")))
+  size_t
+  encodeSSSE3(const unsigned char* aData, size_t aSize, char* aResult)
+  {
+    const __m128i lSpread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i lOffsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    // 16 bytes are read for every 12
+    for (; i + 16 <= aSize; i += 12) {
+      __m128i lIn = _mm_loadu_si128((const __m128i*) (aData + i));
+      lIn = _mm_shuffle_epi8(lIn, lSpread);
+
+      __m128i lHigh = _mm_mulhi_epu16(_mm_and_si128(lIn, _mm_set1_epi32(0x0fc0fc00)),
+                                      _mm_set1_epi32(0x04000040));
+      __m128i lLow = _mm_mullo_epi16(_mm_and_si128(lIn, _mm_set1_epi32(0x003f03f0)),
+                                     _mm_set1_epi32(0x01000010));
+      __m128i lIndices = _mm_or_si128(lHigh, lLow);
+
+      __m128i lRange = _mm_subs_epu8(lIndices, _mm_set1_epi8(51));
+      __m128i lUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), lIndices);
+      lRange = _mm_or_si128(lRange, _mm_and_si128(lUpper, _mm_set1_epi8(13)));
+      __m128i lOut = _mm_add_epi8(_mm_shuffle_epi8(lOffsets, lRange), lIndices);
+
+      _mm_storeu_si128((__m128i*) (aResult + i / 3 * 4), lOut);
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  size_t
+  encodeAVX2(const unsigned char* aData, size_t aSize, char* aResult)
+  {
+    const __m256i lSpread = _mm256_broadcastsi128_si256(
+        _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m256i lOffsets = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+    size_t i = 0;
+    // 12 bytes per lane, the second load reads 4 bytes beyond them
+    for (; i + 28 <= aSize; i += 24) {
+      __m256i lIn = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) (aData + i))),
+          _mm_loadu_si128((const __m128i*) (aData + i + 12)), 1);
+      lIn = _mm256_shuffle_epi8(lIn, lSpread);
+
+      __m256i lHigh = _mm256_mulhi_epu16(_mm256_and_si256(lIn, _mm256_set1_epi32(0x0fc0fc00)),
+                                         _mm256_set1_epi32(0x04000040));
+      __m256i lLow = _mm256_mullo_epi16(_mm256_and_si256(lIn, _mm256_set1_epi32(0x003f03f0)),
+                                        _mm256_set1_epi32(0x01000010));
+      __m256i lIndices = _mm256_or_si256(lHigh, lLow);
+
+      __m256i lRange = _mm256_subs_epu8(lIndices, _mm256_set1_epi8(51));
+      __m256i lUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), lIndices);
+      lRange = _mm256_or_si256(lRange, _mm256_and_si256(lUpper, _mm256_set1_epi8(13)));
+      __m256i lOut = _mm256_add_epi8(_mm256_shuffle_epi8(lOffsets, lRange), lIndices);
+
+      _mm256_storeu_si256((__m256i*) (aResult + i / 3 * 4), lOut);
+    }
+    return i;
+  }
+
+  /*
+   * Decoding classifies the characters by range. A block with any other
+   * character (whitespace, padding, garbage) ends the vector loop and is
+   * left to the scalar code. The 6 bit values are packed with two
+   * multiply-adds and the 3 bytes of every 4 characters are gathered.
+   */
+  __attribute__((target("ssse3")))
+  size_t
+  decodeSSSE3(const char* aData, size_t aSize, unsigned char* aResult)
+  {
+    const __m128i lGather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    // 16 bytes are written for every 12, the last ones must fit into decodedSize()
+    for (; i + 24 <= aSize; i += 16) {
+      __m128i lIn = _mm_loadu_si128((const __m128i*) (aData + i));
+
+      __m128i lUpper = _mm_and_si128(_mm_cmpgt_epi8(lIn, _mm_set1_epi8('A' - 1)),
+                                     _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), lIn));
+      __m128i lLower = _mm_and_si128(_mm_cmpgt_epi8(lIn, _mm_set1_epi8('a' - 1)),
+                                     _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lIn));
+      __m128i lDigit = _mm_and_si128(_mm_cmpgt_epi8(lIn, _mm_set1_epi8('0' - 1)),
+                                     _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), lIn));
+      __m128i lPlus = _mm_cmpeq_epi8(lIn, _mm_set1_epi8('+'));
+      __m128i lSlash = _mm_cmpeq_epi8(lIn, _mm_set1_epi8('/'));
+
+      __m128i lValid = _mm_or_si128(_mm_or_si128(lUpper, lLower),
+                                    _mm_or_si128(lDigit, _mm_or_si128(lPlus, lSlash)));
+      if (_mm_movemask_epi8(lValid) != 0xffff)
+        break;
+
+      __m128i lShift = _mm_or_si128(
+          _mm_or_si128(_mm_and_si128(lUpper, _mm_set1_epi8(-'A')),
+                       _mm_and_si128(lLower, _mm_set1_epi8(26 - 'a'))),
+          _mm_or_si128(_mm_and_si128(lDigit, _mm_set1_epi8(52 - '0')),
+                       _mm_or_si128(_mm_and_si128(lPlus, _mm_set1_epi8(62 - '+')),
+                                    _mm_and_si128(lSlash, _mm_set1_epi8(63 - '/')))));
+      __m128i lValues = _mm_add_epi8(lIn, lShift);
+
+      __m128i lPairs = _mm_maddubs_epi16(lValues, _mm_set1_epi32(0x01400140));
+      __m128i lQuads = _mm_madd_epi16(lPairs, _mm_set1_epi32(0x00011000));
+      _mm_storeu_si128((__m128i*) (aResult + i / 4 * 3), _mm_shuffle_epi8(lQuads, lGather));
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  size_t
+  decodeAVX2(const char* aData, size_t aSize, unsigned char* aResult)
+  {
+    const __m256i lGather = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    const __m256i lCompact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    size_t i = 0;
+    // 32 bytes are written for every 24
+    for (; i + 48 <= aSize; i += 32) {
+      __m256i lIn = _mm256_loadu_si256((const __m256i*) (aData + i));
+
+      __m256i lUpper = _mm256_and_si256(_mm256_cmpgt_epi8(lIn, _mm256_set1_epi8('A' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), lIn));
+      __m256i lLower = _mm256_and_si256(_mm256_cmpgt_epi8(lIn, _mm256_set1_epi8('a' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lIn));
+      __m256i lDigit = _mm256_and_si256(_mm256_cmpgt_epi8(lIn, _mm256_set1_epi8('0' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), lIn));
+      __m256i lPlus = _mm256_cmpeq_epi8(lIn, _mm256_set1_epi8('+'));
+      __m256i lSlash = _mm256_cmpeq_epi8(lIn, _mm256_set1_epi8('/'));
+
+      __m256i lValid = _mm256_or_si256(_mm256_or_si256(lUpper, lLower),
+                                       _mm256_or_si256(lDigit, _mm256_or_si256(lPlus, lSlash)));
+      if (_mm256_movemask_epi8(lValid) != -1)
+        break;
+
+      __m256i lShift = _mm256_or_si256(
+          _mm256_or_si256(_mm256_and_si256(lUpper, _mm256_set1_epi8(-'A')),
+                          _mm256_and_si256(lLower, _mm256_set1_epi8(26 - 'a'))),
+          _mm256_or_si256(_mm256_and_si256(lDigit, _mm256_set1_epi8(52 - '0')),
+                          _mm256_or_si256(_mm256_and_si256(lPlus, _mm256_set1_epi8(62 - '+')),
+                                          _mm256_and_si256(lSlash, _mm256_set1_epi8(63 - '/')))));
+      __m256i lValues = _mm256_add_epi8(lIn, lShift);
+
+      __m256i lPairs = _mm256_maddubs_epi16(lValues, _mm256_set1_epi32(0x01400140));
+      __m256i lQuads = _mm256_madd_epi16(lPairs, _mm256_set1_epi32(0x00011000));
+      __m256i lOut = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(lQuads, lGather), lCompact);
+      _mm256_storeu_si256((__m256i*) (aResult + i / 4 * 3), lOut);
+    }
+    return i;
+  }
+
+#endif /* AWS_BASE64_X86 */
+
+} /* namespace */
+
+size_t
+Base64::encode(const unsigned char* aData, size_t aSize, char* aResult)
+{
+  size_t lDone = 0;
+#ifdef AWS_BASE64_X86
+  if (theImplementation == AVX2)
+    lDone = encodeAVX2(aData, aSize, aResult);
+  if (theImplementation >= SSSE3)
+    lDone += encodeSSSE3(aData + lDone, aSize - lDone, aResult + lDone / 3 * 4);
+#endif
+  encodeScalar(aData + lDone, aSize - lDone, aResult + lDone / 3 * 4);
+  return encodedSize(aSize);
+}
+
+bool
+Base64::decode(const char* aData, size_t aSize, unsigned char* aResult, size_t& aResultSize)
+{
+  size_t lDone = 0;
+#ifdef AWS_BASE64_X86
+  if (theImplementation == AVX2)
+    lDone = decodeAVX2(aData, aSize, aResult);
+  if (theImplementation >= SSSE3)
+    lDone += decodeSSSE3(aData + lDone, aSize - lDone, aResult + lDone / 4 * 3);
+#endif
+  size_t lTail;
+  if (!decodeScalar(aData + lDone, aSize - lDone, aResult + lDone / 4 * 3, lTail))
+    return false;
+  aResultSize = lDone / 4 * 3 + lTail;
+  return true;
+}
+
+const char*
+Base64::implementation()
+{
+#ifdef AWS_BASE64_X86
+  switch (theImplementation) {
+    case AVX2:  return "avx2";
+    case SSSE3: return "ssse3";
+    default:    break;
+  }
+#endif
+  return "scalar";
+}
+
+} /* namespace aws */
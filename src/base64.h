@@ -0,0 +1,54 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_BASE64_H
+#define AWS_BASE64_H
+
+#include <stddef.h>
+
+namespace aws {
+
+/*
+ * Base64 (RFC 4648, with padding and without line breaks) into caller
+ * provided buffers.
+ * On x86 the AVX2 or SSSE3 code is used if the cpu supports it, the
+ * scalar code handles the tails and all other platforms.
+ */
+class Base64 {
+
+public:
+  // exact size of the encoding of aSize bytes
+  static size_t encodedSize(size_t aSize) { return (aSize + 2) / 3 * 4; }
+
+  // upper bound of the decoded size of aSize characters
+  static size_t decodedSize(size_t aSize) { return (aSize + 3) / 4 * 3; }
+
+  // writes encodedSize(aSize) characters, no null termination
+  static size_t encode(const unsigned char* aData, size_t aSize, char* aResult);
+
+  /*
+   * Writes at most decodedSize(aSize) bytes and returns the number of bytes
+   * written in aResultSize. Whitespace is skipped, decoding stops at the
+   * first padding character. Returns false for any other invalid character.
+   */
+  static bool decode(const char* aData, size_t aSize, unsigned char* aResult,
+                     size_t& aResultSize);
+
+  // "avx2", "ssse3", or "scalar"
+  static const char* implementation();
+};
+
+} /* namespace aws */
+#endif /* !AWS_BASE64_H */
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "elementmap.h"
+
+namespace aws {
+
+namespace {
+
+  // seeds tried per table size before the table is doubled
+  const uint32_t MAX_SEEDS = 1 << 16;
+
+} /* namespace */
+
+ElementMap::ElementMap(const Entry* aEntries, size_t aSize)
+{
+  // with a quarter of the slots used a seed is found after a few tries
+  unsigned int lBits = 2;
+  while (((size_t) 1 << lBits) < 4 * aSize) {
+    ++lBits;
+  }
+
+  Slot lEmpty = { "", 0, 0 };
+  for (;; ++lBits) {
+    theShift = 32 - lBits;
+    for (uint32_t lSeed = 0; lSeed < MAX_SEEDS; ++lSeed) {
+      theSeed = 2166136261u + lSeed * 2654435761u;
+      theSlots.assign((size_t) 1 << lBits, lEmpty);
+
+      bool lPerfect = true;
+      for (size_t i = 0; i < aSize && lPerfect; ++i) {
+        size_t lLength;
+        Slot& lSlot = theSlots[hash(BAD_CAST aEntries[i].theName, theSeed, lLength) >> theShift];
+        if (lSlot.theId == 0) {
+          lSlot.theName = aEntries[i].theName;
+          lSlot.theLength = lLength;
+          lSlot.theId = aEntries[i].theId;
+        } else if (lSlot.theLength != lLength
+                   || memcmp(lSlot.theName, aEntries[i].theName, lLength) != 0) {
+          lPerfect = false;
+        }
+        // a name that is listed twice keeps its first id
+      }
+      if (lPerfect) {
+        return;
+      }
+    }
+  }
+}
+
+} /* namespace aws */
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_ELEMENTMAP_H
+#define AWS_ELEMENTMAP_H
+
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include <libxml/xmlstring.h>
+
+namespace aws {
+
+/*
+ * Maps the element names a SAX handler dispatches on to integer ids, so
+ * that the handlers switch on an id instead of comparing the name with
+ * every name they know.
+ * The map is a perfect hash table: the seed of the hash function is
+ * searched when the map is built, until no two names share a slot. A
+ * lookup is one pass over the name and one compare with a single
+ * candidate. Names that aren't in the map have the id 0.
+ */
+class ElementMap {
+
+public:
+  struct Entry {
+    const char* theName;
+    int         theId;
+  };
+
+  // the ids must not be 0
+  ElementMap(const Entry* aEntries, size_t aSize);
+
+  int lookup(const xmlChar* aName) const;
+
+private:
+  struct Slot {
+    const char* theName;
+    size_t      theLength;
+    int         theId;
+  };
+
+  static uint32_t hash(const xmlChar* aName, uint32_t aSeed, size_t& aLength);
+
+  std::vector<Slot> theSlots;
+  uint32_t          theSeed;
+  unsigned int      theShift;
+};
+
+inline uint32_t
+ElementMap::hash(const xmlChar* aName, uint32_t aSeed, size_t& aLength)
+{
+  // FNV-1a; the slot is taken from the high bits, which depend on all
+  // characters and on the whole seed
+  const xmlChar* lEnd = aName;
+  for (; *lEnd; ++lEnd) {
+    aSeed = (aSeed ^ *lEnd) * 16777619u;
+  }
+  aLength = lEnd - aName;
+  return aSeed;
+}
+
+inline int
+ElementMap::lookup(const xmlChar* aName) const
+{
+  size_t lLength;
+  const Slot& lSlot = theSlots[hash(aName, theSeed, lLength) >> theShift];
+  if (lSlot.theLength == lLength && memcmp(lSlot.theName, aName, lLength) == 0) {
+    return lSlot.theId;
+  }
+  return 0;
+}
+
+} /* namespace aws */
+#endif /* !AWS_ELEMENTMAP_H */
@@ -24,15 +24,13 @@
 #include <cassert>
 #include <curl/curl.h>
 
+#include <libaws/awstime.h>
 #include "awsconnection.h"
 
 #include "s3/s3object.h"
 
 namespace aws { 
 
-std::string RequestHeaderMap::DATE_FORMAT("%a, %d %b %Y %H:%M:%S GMT");
-
-
 void 
 RequestHeaderMap::addHeader(std::string aKey, std::string aValue)
 {
@@ -48,21 +46,10 @@ RequestHeaderMap::containsKey(std::string aKey)
 void
 RequestHeaderMap::addDateHeader()
 {
-    time_t lRawTime; tm*    lPtm;
-    time ( &lRawTime );
-    lPtm = gmtime ( &lRawTime );
-
-    char* lDateString = new char[31];
-#ifndef NDEBUG
-    size_t lTest = strftime(lDateString, 31, DATE_FORMAT.c_str(), lPtm);
-    assert(lTest<31); // should be long enough for the date format above
-#else
-    strftime(lDateString, 31, DATE_FORMAT.c_str(), lPtm);
-#endif
+    char lDateString[Time::RFC1123_LENGTH + 1];
+    Time::formatRFC1123(time(0), lDateString);
 
     addHeader("Date", lDateString);
-    
-    delete[] lDateString; lDateString = 0;
 }
 
 void
@@ -44,7 +44,6 @@ public:
     
 private:
     requestmap_t theMap;
-    static std::string DATE_FORMAT;
     
 public:
     void
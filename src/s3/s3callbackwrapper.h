@@ -17,6 +17,7 @@
 #define AWS_S3_S3CALLBACKWRAPPER_H
 
 #include <string.h>
+#include <string>
 
 #include <libxml/parser.h>
 
@@ -45,6 +46,18 @@ namespace aws
       void
       createParser()
       {
+        // the callbacks of the handler are called through the wrapper,
+        // which passes the text of an element on in one piece instead of
+        // in the chunks the parser reports it in
+        if (theSAXHandler.characters != &S3CallBackWrapper::characters) {
+          theStartElementNs = theSAXHandler.startElementNs;
+          theCharacters     = theSAXHandler.characters;
+          theEndElementNs   = theSAXHandler.endElementNs;
+          theSAXHandler.startElementNs = &S3CallBackWrapper::startElementNs;
+          theSAXHandler.characters     = &S3CallBackWrapper::characters;
+          theSAXHandler.endElementNs   = &S3CallBackWrapper::endElementNs;
+        }
+        theText.clear();
         theParserCtxt = xmlCreatePushParserCtxt ( &theSAXHandler, this, NULL, 0, 0 );
         theParserCreated = true;
       }
@@ -56,11 +69,59 @@ namespace aws
           xmlFreeParserCtxt ( theParserCtxt );        
       }
 
+      static void
+      startElementNs(void * ctx,
+                     const xmlChar * localname,
+                     const xmlChar * prefix,
+                     const xmlChar * URI,
+                     int nb_namespaces,
+                     const xmlChar ** namespaces,
+                     int nb_attributes,
+                     int nb_defaulted,
+                     const xmlChar ** attributes)
+      {
+        S3CallBackWrapper* lWrapper = static_cast<S3CallBackWrapper*>( ctx );
+        lWrapper->flushText();
+        lWrapper->theStartElementNs(ctx, localname, prefix, URI, nb_namespaces, namespaces,
+                                    nb_attributes, nb_defaulted, attributes);
+      }
+
+      static void
+      characters(void * ctx, const xmlChar * value, int len)
+      {
+        static_cast<S3CallBackWrapper*>( ctx )->theText.append((const char*)value, len);
+      }
+
+      static void
+      endElementNs(void * ctx,
+                   const xmlChar * localname,
+                   const xmlChar * prefix,
+                   const xmlChar * URI)
+      {
+        S3CallBackWrapper* lWrapper = static_cast<S3CallBackWrapper*>( ctx );
+        lWrapper->flushText();
+        lWrapper->theEndElementNs(ctx, localname, prefix, URI);
+      }
+
+      void
+      flushText()
+      {
+        if (!theText.empty()) {
+          theCharacters(this, BAD_CAST theText.data(), theText.size());
+          theText.clear();
+        }
+      }
+
       bool                    theParserCreated;
       aws::s3::S3Response*    theResponse;
       aws::s3::S3Handler*     theHandler;
       xmlSAXHandler           theSAXHandler;
       xmlParserCtxtPtr        theParserCtxt;
+
+      startElementNsSAX2Func  theStartElementNs;
+      charactersSAXFunc       theCharacters;
+      endElementNsSAX2Func    theEndElementNs;
+      std::string             theText;
     };
 
 } }
@@ -142,11 +142,8 @@ S3Connection::listBucket(const std::string& aBucketName, const std::string& aPre
 
   PathArgs_t lPathArgsMap;
 
-  char* lEscapedPrefixChar = curl_escape(aPrefix.c_str(), aPrefix.size());
-  char* lEscapedMarkerChar = curl_escape(aMarker.c_str(), aMarker.size());
-
-  std::string lEscapedPrefix(lEscapedPrefixChar);
-  std::string lEscapedMarker(lEscapedMarkerChar);
+  std::string lEscapedPrefix = urlencode(aPrefix);
+  std::string lEscapedMarker = urlencode(aMarker);
 
   if (lEscapedPrefix.size() != 0)
       lPathArgsMap.insert(stringpair_t("prefix", lEscapedPrefix));
@@ -160,19 +157,18 @@ S3Connection::listBucket(const std::string& aBucketName, const std::string& aPre
       lPathArgsMap.insert(stringpair_t("max-keys", s.str()));
   }
 
+  // keys that aren't valid in xml can be listed, ListBucketHandler decodes them
+  lPathArgsMap.insert(stringpair_t("encoding-type", "url"));
+
   lWrapper.createParser();
 
   try {
     makeRequest(aBucketName, LIST_BUCKET, &lWrapper, &lPathArgsMap, 0);
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedPrefixChar);
-    curl_free(lEscapedMarkerChar);
     throw e;
   }
   lWrapper.destroyParser();
-  curl_free(lEscapedPrefixChar);
-  curl_free(lEscapedMarkerChar);
 
   if ( ! lRes->isSuccessful() )
     throw ListBucketException( lRes->theS3ResponseError );
@@ -199,13 +195,9 @@ S3Connection::listBucket(const std::string& aBucketName, const std::string& aPre
 
   PathArgs_t lPathArgsMap;
 
-  char* lEscapedPrefixChar = curl_escape(aPrefix.c_str(), aPrefix.size());
-  char* lEscapedMarkerChar = curl_escape(aMarker.c_str(), aMarker.size());
-  char* lEscapedDelimiterChar = curl_escape(aDelimiter.c_str(), aDelimiter.size());
-
-  std::string lEscapedPrefix(lEscapedPrefixChar);
-  std::string lEscapedMarker(lEscapedMarkerChar);
-  std::string lEscapedDelimiter(lEscapedDelimiterChar);
+  std::string lEscapedPrefix = urlencode(aPrefix);
+  std::string lEscapedMarker = urlencode(aMarker);
+  std::string lEscapedDelimiter = urlencode(aDelimiter);
 
   if (lEscapedPrefix.size() != 0)
       lPathArgsMap.insert(stringpair_t("prefix", lEscapedPrefix));
@@ -214,7 +206,7 @@ S3Connection::listBucket(const std::string& aBucketName, const std::string& aPre
       lPathArgsMap.insert(stringpair_t("marker", lEscapedMarker));
 
   if (lEscapedDelimiter.size() != 0)
-      lPathArgsMap.insert(stringpair_t("delimiter", lEscapedDelimiterChar));
+      lPathArgsMap.insert(stringpair_t("delimiter", lEscapedDelimiter));
 
   if (aMaxKeys != -1) {
       std::stringstream s;
@@ -222,21 +214,18 @@ S3Connection::listBucket(const std::string& aBucketName, const std::string& aPre
       lPathArgsMap.insert(stringpair_t("max-keys", s.str()));
   }
 
+  // keys that aren't valid in xml can be listed, ListBucketHandler decodes them
+  lPathArgsMap.insert(stringpair_t("encoding-type", "url"));
+
   lWrapper.createParser();
 
   try {
     makeRequest(aBucketName, LIST_BUCKET, &lWrapper, &lPathArgsMap, 0);
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedPrefixChar);
-    curl_free(lEscapedMarkerChar);
-    curl_free(lEscapedDelimiterChar);
     throw e;
   }
   lWrapper.destroyParser();
-  curl_free(lEscapedPrefixChar);
-  curl_free(lEscapedMarkerChar);
-  curl_free(lEscapedDelimiterChar);
 
   if ( ! lRes->isSuccessful() )
     throw ListBucketException( lRes->theS3ResponseError );
@@ -282,9 +271,7 @@ S3Connection::put(const std::string& aBucketName,
   lWrapper.theSAXHandler.characters     = &PutHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &PutHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
-  curl_free(lEscapedKeyChar);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
@@ -361,9 +348,7 @@ S3Connection::put(const std::string& aBucketName,
   lWrapper.theSAXHandler.characters     = &PutHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &PutHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
-  curl_free(lEscapedKeyChar);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
@@ -456,8 +441,7 @@ S3Connection::get(const std::string& aBucketName, const std::string& aKey,
   lWrapper.theSAXHandler.characters     = &GetHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &GetHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
@@ -477,12 +461,10 @@ S3Connection::get(const std::string& aBucketName, const std::string& aKey,
 
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedKeyChar);
     throw e;
   }
 
   lWrapper.destroyParser();
-  curl_free(lEscapedKeyChar);
 
   if ( ! lRes->isSuccessful() )
     throw GetException( lRes->theS3ResponseError );
@@ -494,6 +476,36 @@ S3Connection::get(const std::string& aBucketName, const std::string& aKey,
 GetResponse*
 S3Connection::get(const std::string& aBucketName, const std::string& aKey,
                   const std::string& aOldEtag)
+{
+  // the etags of the responses are stored without the quotes
+  std::string lOldEtag = aOldEtag;
+  if (lOldEtag.empty() || lOldEtag[0] != '"')
+    lOldEtag = "\"" + lOldEtag + "\"";
+
+  RequestHeaderMap lRequestHeaderMap;
+  lRequestHeaderMap.addHeader("If-None-Match",lOldEtag);
+
+  return getWithHeaders(aBucketName, aKey, &lRequestHeaderMap);
+}
+
+GetResponse*
+S3Connection::getRange(const std::string& aBucketName, const std::string& aKey,
+                       long long aOffset, long long aLength)
+{
+  std::ostringstream lRange;
+  lRange << "bytes=" << aOffset << "-";
+  if (aLength >= 0)
+    lRange << (aOffset + aLength - 1);
+
+  RequestHeaderMap lRequestHeaderMap;
+  lRequestHeaderMap.addHeader("Range",lRange.str());
+
+  return getWithHeaders(aBucketName, aKey, &lRequestHeaderMap);
+}
+
+GetResponse*
+S3Connection::getWithHeaders(const std::string& aBucketName, const std::string& aKey,
+                             RequestHeaderMap* aHeaderMap)
 {
   std::auto_ptr<GetResponse> lRes(new GetResponse(aBucketName, aKey));
 
@@ -507,26 +519,19 @@ S3Connection::get(const std::string& aBucketName, const std::string& aKey,
   lWrapper.theSAXHandler.characters     = &GetHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &GetHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
-
-  RequestHeaderMap lRequestHeaderMap;
-  lRequestHeaderMap.addHeader("If-None-Match",aOldEtag);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
   try {
-    makeRequest(aBucketName, GET, &lWrapper, 0, &lRequestHeaderMap, lEscapedKey, 0);
+    makeRequest(aBucketName, GET, &lWrapper, 0, aHeaderMap, lEscapedKey, 0);
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedKeyChar);
     throw e;
   }
 
   lWrapper.destroyParser();
 
-  curl_free(lEscapedKeyChar);
-
   if ( ! lRes->isSuccessful() )
     throw GetException( lRes->theS3ResponseError );
 
@@ -548,8 +553,7 @@ S3Connection::del(const std::string& aBucketName, const std::string& aKey)
   lWrapper.theSAXHandler.characters     = &DeleteHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &DeleteHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
@@ -557,14 +561,11 @@ S3Connection::del(const std::string& aBucketName, const std::string& aKey)
     makeRequest(aBucketName, DELETE, &lWrapper, 0, 0, lEscapedKey, 0);
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedKeyChar);
     throw e;
   }
 
   lWrapper.destroyParser();
 
-  curl_free(lEscapedKeyChar);
-
   if ( ! lRes->isSuccessful() )
     throw DeleteException( lRes->theS3ResponseError );
 
@@ -599,6 +600,14 @@ S3Connection::deleteAll(const std::string& aBucketName, const std::string& aPref
   return lRes.release();
 }
 
+HeadManyResponse*
+S3Connection::headMany(const std::string& aBucketName, const std::vector<std::string>& aKeys,
+                       int aConcurrency)
+{
+  // the requests are sent as soon as the response is opened
+  return new HeadManyResponse(this, aBucketName, aKeys, aConcurrency);
+}
+
 HeadResponse*
 S3Connection::head(const std::string& aBucketName, const std::string& aKey)
 {
@@ -614,8 +623,7 @@ S3Connection::head(const std::string& aBucketName, const std::string& aKey)
   lWrapper.theSAXHandler.characters     = &HeadHandler::charactersSAXFunc;
   lWrapper.theSAXHandler.endElementNs   = &HeadHandler::endElementNs;
 
-  char* lEscapedKeyChar = curl_escape(aKey.c_str(), aKey.size());
-  std::string lEscapedKey(lEscapedKeyChar);
+  std::string lEscapedKey = urlencode(aKey);
 
   lWrapper.createParser();
 
@@ -623,14 +631,11 @@ S3Connection::head(const std::string& aBucketName, const std::string& aKey)
     makeRequest(aBucketName, HEAD, &lWrapper, 0, 0, lEscapedKey, 0);
   } catch (AWSException& e) {
     lWrapper.destroyParser();
-    curl_free(lEscapedKeyChar);
     throw e;
   }
 
   lWrapper.destroyParser();
 
-  curl_free(lEscapedKeyChar);
-
   if ( ! lRes->isSuccessful() )
     throw HeadException( lRes->theS3ResponseError );
 
@@ -754,8 +759,6 @@ S3Connection::makeRequest(const std::string& aBucketName,
   S3Response* lResponse;
   aws::CallingFormat* lCallingFormat;
   RequestHeaderMap lHeaderMap;
-  std::string lStringToSign;
-  std::stringstream lAuthData;
   CURLcode lResCode;
   struct curl_slist* lSList;
 
@@ -794,24 +797,7 @@ S3Connection::makeRequest(const std::string& aBucketName,
   }
 
   // authorization
-  lStringToSign = Canonizer::canonicalize(aActionType, aBucketName, aKey, aHeaderMap,
-                                          false, false, aActionType==BUCKET_LOGGING);
-  {
-    // compute signature
-    HMAC(EVP_sha1(), theSecretAccessKey.c_str(),  theSecretAccessKey.size(),
-        (const unsigned char*) lStringToSign.c_str(), lStringToSign.size(),
-        theEncryptedResult, &theEncryptedResultSize);
-
-    long lBase64EncodedStringLength;
-    lAuthData << " AWS " << theAccessKeyId << ":" <<
-        base64Encode(theEncryptedResult, theEncryptedResultSize,
-                     lBase64EncodedStringLength);
-  }
-
-
-  // avoid temporary objects
-  std::string lAuthDataString = lAuthData.str();
-  aHeaderMap->addHeader("Authorization", lAuthDataString.c_str());
+  signRequest(aActionType, aBucketName, aKey, aHeaderMap);
 
   lSList = 0;
 
@@ -867,6 +853,61 @@ S3Connection::makeRequest(const std::string& aBucketName,
 
 }
 
+void
+S3Connection::signRequest(ActionType aActionType, const std::string& aBucketName,
+                          const std::string& aKey, RequestHeaderMap* aHeaderMap)
+{
+  std::string lStringToSign;
+  std::stringstream lAuthData;
+
+  lStringToSign = Canonizer::canonicalize(aActionType, aBucketName, aKey, aHeaderMap,
+                                          false, false, aActionType==BUCKET_LOGGING);
+  {
+    // compute signature
+    HMAC(EVP_sha1(), theSecretAccessKey.c_str(),  theSecretAccessKey.size(),
+        (const unsigned char*) lStringToSign.c_str(), lStringToSign.size(),
+        theEncryptedResult, &theEncryptedResultSize);
+
+    long lBase64EncodedStringLength;
+    lAuthData << " AWS " << theAccessKeyId << ":" <<
+        base64Encode(theEncryptedResult, theEncryptedResultSize,
+                     lBase64EncodedStringLength);
+  }
+
+  // avoid temporary objects
+  std::string lAuthDataString = lAuthData.str();
+  aHeaderMap->addHeader("Authorization", lAuthDataString.c_str());
+}
+
+CURL*
+S3Connection::createHeadRequest(const std::string& aBucketName, const std::string& aKey,
+                                S3CallBackWrapper* aCallBackWrapper, struct curl_slist** aHeaders)
+{
+  std::string lEscapedKey = urlencode(aKey);
+
+  aws::CallingFormat* lCallingFormat = aws::CallingFormat::getRegularCallingFormat();
+  std::string lUrl = lCallingFormat->getUrl(theIsSecure, theHost, thePort,
+                                            aBucketName, lEscapedKey, 0);
+
+  CURL* lCurl = curl_easy_init();
+  curl_easy_setopt(lCurl, CURLOPT_URL, lUrl.c_str());
+  curl_easy_setopt(lCurl, CURLOPT_NOBODY, 1);
+  curl_easy_setopt(lCurl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
+  curl_easy_setopt(lCurl, CURLOPT_HEADERFUNCTION, S3Connection::getHeaderData);
+  curl_easy_setopt(lCurl, CURLOPT_WRITEHEADER, (void*)(aCallBackWrapper));
+  curl_easy_setopt(lCurl, CURLOPT_PRIVATE, (void*)(aCallBackWrapper));
+
+  RequestHeaderMap lHeaderMap;
+  lHeaderMap.addDateHeader();
+  signRequest(HEAD, aBucketName, lEscapedKey, &lHeaderMap);
+
+  *aHeaders = 0;
+  lHeaderMap.addHeadersToCurlSList(*aHeaders);
+  curl_easy_setopt(lCurl, CURLOPT_HTTPHEADER, *aHeaders);
+
+  return lCurl;
+}
+
 size_t
 S3Connection::getS3Data(void *ptr, size_t size, size_t nmemb, void *data)
 {
@@ -910,7 +951,8 @@ S3Connection::getHeaderData(void *ptr, size_t size, size_t nmemb, void *stream)
   }
 
   if (lTmp.find("200 OK") != std::string::npos ||
-      lTmp.find("204 No Content") != std::string::npos) {
+      lTmp.find("204 No Content") != std::string::npos ||
+      lTmp.find("206 Partial Content") != std::string::npos) {
     // if we got a 20x header, the request was successful
     lRes->theIsSuccessful = true;
   } else if (lTmp.find("ETag:") != std::string::npos) {
@@ -930,8 +972,9 @@ S3Connection::getHeaderData(void *ptr, size_t size, size_t nmemb, void *stream)
   } else if ((lGetResponse = dynamic_cast<GetResponse*>(lRes))) {
     if (lTmp.find("Last-Modified:") != std::string::npos) {
       // parse a time string of the following format: Fri, 09 Nov 2007 13:05:49 GMT
-      Time t(lTmp.c_str()+15);
-      lGetResponse->theLastModified = t;
+      time_t lTime;
+      if (Time::parseRFC1123(lTmp.c_str() + 15, lTmp.size() - 15, lTime))
+        lGetResponse->theLastModified = Time(lTime);
 
     } else if ( lTmp.find("Content-Length:") != std::string::npos) {
       lGetResponse->theContentLength = atoll(lTmp.c_str() + 16);
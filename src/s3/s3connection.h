@@ -19,6 +19,7 @@
 #include "common.h"
 
 #include <map>
+#include <vector>
 #include <iostream>
 
 #include "awsconnection.h"
@@ -27,6 +28,9 @@
 #ifdef DELETE 
 #  undef DELETE
 #endif
+
+struct curl_slist;
+
 namespace aws {
 
   // forward declarations
@@ -40,6 +44,7 @@ namespace aws {
   namespace s3 {
 
     class  S3Object;
+    class  HeadManyResponse;
     struct S3CallBackWrapper;
 
 
@@ -47,6 +52,7 @@ namespace aws {
 
       friend class    ::aws::S3ConnectionImpl;
       friend class    ::aws::Canonizer;
+      friend class    HeadManyResponse;
 
     private:
       //! Instance of this class are only created by the aws::AWSConnectionFactory
@@ -126,6 +132,10 @@ namespace aws {
       get(const std::string& aBucketName, const std::string& aKey, 
           const std::map<std::string, std::string>* aMetaDataMap);
 
+      GetResponse*
+      getRange(const std::string& aBucketName, const std::string& aKey,
+               long long aOffset, long long aLength);
+
       DeleteResponse*
       del(const std::string& aBucketName, const std::string& aKey);
 
@@ -135,6 +145,10 @@ namespace aws {
       HeadResponse*
       head(const std::string& aBucketName, const std::string& aKey);
 
+      HeadManyResponse*
+      headMany(const std::string& aBucketName, const std::vector<std::string>& aKeys,
+               int aConcurrency);
+
       BucketLoggingStatusResponse*
       bucketLoggingStatus(const std::string& aBucketName);
 
@@ -158,6 +172,19 @@ namespace aws {
 
       void            setRequestMethod(ActionType aActionType);
 
+      GetResponse*
+      getWithHeaders(const std::string& aBucketName, const std::string& aKey,
+                     RequestHeaderMap* aHeaderMap);
+
+      void
+      signRequest(ActionType aActionType, const std::string& aBucketName,
+                  const std::string& aKey, RequestHeaderMap* aHeaderMap);
+
+      // creates an easy handle for a HEAD request that can be added to a multi handle
+      CURL*
+      createHeadRequest(const std::string& aBucketName, const std::string& aKey,
+                        S3CallBackWrapper* aCallBackWrapper, struct curl_slist** aHeaders);
+
       //all the callback handlers
       static          size_t
       getS3Data(void *aBuffer, size_t aSize, size_t nmemb, void *userp);
@@ -17,15 +17,86 @@
 
 #include <time.h>
 #include <cassert>
+#include <stdlib.h>
 
 #include "s3/s3handler.h"
 #include "s3/s3response.h"
 #include "s3/s3callbackwrapper.h"
+#include "urlencoding.h"
+#include "elementmap.h"
 
 
 #include <iostream>
 namespace aws { namespace s3 {
 
+namespace {
+
+  // the element names the handlers dispatch on
+  namespace element {
+    enum {
+      Error = 1,
+      Code,
+      Message,
+      RequestId,
+      HostId,
+      ListAllMyBucketsResult,
+      Owner,
+      Id,
+      DisplayName,
+      Buckets,
+      Bucket,
+      Name,
+      CreationDate,
+      Prefix,
+      Marker,
+      IsTruncated,
+      Contents,
+      Key,
+      LastModified,
+      ETag,
+      Size,
+      CommonPrefixes,
+      EncodingType,
+      ListBucketResult,
+      TargetBucket,
+      TargetPrefix
+    };
+  }
+
+  const ElementMap::Entry theElementEntries[] = {
+    { "Error", element::Error },
+    { "Code", element::Code },
+    { "Message", element::Message },
+    { "RequestId", element::RequestId },
+    { "HostId", element::HostId },
+    { "ListAllMyBucketsResult", element::ListAllMyBucketsResult },
+    { "Owner", element::Owner },
+    { "Id", element::Id },
+    { "DisplayName", element::DisplayName },
+    { "Buckets", element::Buckets },
+    { "Bucket", element::Bucket },
+    { "Name", element::Name },
+    { "CreationDate", element::CreationDate },
+    { "Prefix", element::Prefix },
+    { "Marker", element::Marker },
+    { "IsTruncated", element::IsTruncated },
+    { "Contents", element::Contents },
+    { "Key", element::Key },
+    { "LastModified", element::LastModified },
+    { "ETag", element::ETag },
+    { "Size", element::Size },
+    { "CommonPrefixes", element::CommonPrefixes },
+    { "EncodingType", element::EncodingType },
+    { "ListBucketResult", element::ListBucketResult },
+    { "TargetBucket", element::TargetBucket },
+    { "TargetPrefix", element::TargetPrefix }
+  };
+
+  const ElementMap theElements(theElementEntries,
+                               sizeof(theElementEntries) / sizeof(ElementMap::Entry));
+
+} /* namespace */
+
 S3Handler::S3Handler()
   : theCurrentState(0)
 {}
@@ -51,20 +122,21 @@ CreateBucketHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   CreateBucketResponse* lRes     = static_cast<CreateBucketResponse*>( lWrapper->theResponse );
   CreateBucketHandler*  lHandler = static_cast<CreateBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
     
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
     lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
     lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->setState(HostId);
   }
 }
@@ -101,17 +173,18 @@ CreateBucketHandler::endElementNs(void * ctx,
 {
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   CreateBucketHandler*  lHandler = static_cast<CreateBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
     lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->unsetState(HostId);
   }
 }
@@ -138,20 +211,21 @@ DeleteBucketHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   DeleteBucketResponse* lRes     = static_cast<DeleteBucketResponse*>( lWrapper->theResponse );
   DeleteBucketHandler*  lHandler = static_cast<DeleteBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
     
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->setState(HostId);
   }
 }
@@ -189,17 +263,18 @@ DeleteBucketHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   //DeleteBucketResponse* lRes     = static_cast<DeleteBucketResponse*>( lWrapper->theResponse );
   DeleteBucketHandler*  lHandler = static_cast<DeleteBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->unsetState(HostId);
   }
 }
@@ -224,41 +299,42 @@ ListAllBucketsHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   ListAllBucketsResponse* lRes     = static_cast<ListAllBucketsResponse*>( lWrapper->theResponse );
   ListAllBucketsHandler*  lHandler = static_cast<ListAllBucketsHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
     
-  if (xmlStrEqual(localname, BAD_CAST "ListAllMyBucketsResult")) {
+  if (lElement == element::ListAllMyBucketsResult) {
       lRes->theIsSuccessful = true;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Owner")) {
+  else if (lElement == element::Owner) {
       lHandler->setState(Owner);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Id")) {
+  else if (lElement == element::Id) {
       lHandler->setState(Id);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "DisplayName")) {
+  else if (lElement == element::DisplayName) {
       lHandler->setState(DisplayName);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Buckets")) {
+  else if (lElement == element::Buckets) {
       lHandler->setState(Buckets);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Bucket")) {
+  else if (lElement == element::Bucket) {
       lHandler->setState(Bucket);
       ListAllBucketsResponse::Bucket lBucket;
       lRes->theBuckets.push_back(lBucket);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Name")) {
+  else if (lElement == element::Name) {
       lHandler->setState(Name);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "CreationDate")) {
+  else if (lElement == element::CreationDate) {
       lHandler->setState(CreationDate);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  else if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
       lHandler->setState(Error);
   } 
-  else if (lHandler->isSet(Error) && xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lHandler->isSet(Error) && lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (lHandler->isSet(Error) && xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lHandler->isSet(Error) && lElement == element::Message) {
       lHandler->setState(Message);
   }
 }
@@ -304,41 +380,43 @@ ListAllBucketsHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   //ListAllBucketsResponse* lRes     = static_cast<ListAllBucketsResponse*>( lWrapper->theResponse );
   ListAllBucketsHandler*  lHandler = static_cast<ListAllBucketsHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
  
-  if (xmlStrEqual(localname, BAD_CAST "Owner")) {
+  if (lElement == element::Owner) {
       lHandler->unsetState(Owner);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Id")) {
+  else if (lElement == element::Id) {
       lHandler->unsetState(Id);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "DisplayName")) {
+  else if (lElement == element::DisplayName) {
       lHandler->unsetState(DisplayName);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Buckets")) {
+  else if (lElement == element::Buckets) {
       lHandler->unsetState(Buckets);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Bucket")) {
+  else if (lElement == element::Bucket) {
       lHandler->unsetState(Bucket);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Name")) {
+  else if (lElement == element::Name) {
       lHandler->unsetState(Name);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "CreationDate")) {
+  else if (lElement == element::CreationDate) {
       lHandler->unsetState(CreationDate);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  else if (lElement == element::Error) {
       lHandler->unsetState(Error);
   } 
-  else if (lHandler->isSet(Error) && xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lHandler->isSet(Error) && lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (lHandler->isSet(Error) && xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lHandler->isSet(Error) && lElement == element::Message) {
       lHandler->unsetState(Message);
   }
 }
 
 ListBucketHandler::ListBucketHandler()
-        : S3Handler()
+        : S3Handler(),
+          theUrlEncoded(false)
 {}
 
 
@@ -356,37 +434,57 @@ ListBucketHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   ListBucketResponse* lRes     = static_cast<ListBucketResponse*>( lWrapper->theResponse );
   ListBucketHandler*  lHandler = static_cast<ListBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  switch (lElement) {
+  case element::Error:
     lRes->theIsSuccessful = false;
-  } else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+    break;
+  case element::Code:
     lHandler->setState(Code);
-  } else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+    break;
+  case element::Message:
     lHandler->setState(Message);
-  } else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+    break;
+  case element::RequestId:
     lHandler->setState(RequestId);
-  } else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+    break;
+  case element::HostId:
     lHandler->setState(HostId);
-  } else if (xmlStrEqual(localname, BAD_CAST "Name")) {
+    break;
+  case element::Name:
     lHandler->setState(Name);
-  } else if (xmlStrEqual(localname, BAD_CAST "Prefix")) {
+    break;
+  case element::Prefix:
     lHandler->setState(Prefix);
-  } else if (xmlStrEqual(localname, BAD_CAST "Marker")) {
+    break;
+  case element::Marker:
     lHandler->setState(Marker);
-  } else if (xmlStrEqual(localname, BAD_CAST "IsTruncated")) {
+    break;
+  case element::IsTruncated:
     lHandler->setState(Truncated);
-  } else if (xmlStrEqual(localname, BAD_CAST "Contents")) {
+    break;
+  case element::Contents:
     lHandler->setState(Contents);
-  } else if (xmlStrEqual(localname, BAD_CAST "Key")) {
+    break;
+  case element::Key:
     lHandler->setState(Key);
-  } else if (xmlStrEqual(localname, BAD_CAST "LastModified")) {
+    break;
+  case element::LastModified:
     lHandler->setState(LastModified);
-  } else if (xmlStrEqual(localname, BAD_CAST "ETag")) {
+    break;
+  case element::ETag:
     lHandler->setState(ETag);
-  } else if (xmlStrEqual(localname, BAD_CAST "Size")) {
+    break;
+  case element::Size:
     lHandler->setState(Length);
-  } else if (xmlStrEqual(localname, BAD_CAST "CommonPrefixes")) {
+    break;
+  case element::CommonPrefixes:
     lHandler->setState(CommonPrefixes);
+    break;
+  case element::EncodingType:
+    lHandler->setState(EncodingType);
+    break;
   }
 }
     
@@ -409,30 +507,34 @@ ListBucketHandler::charactersSAXFunc(void * ctx,
     lRes->theS3ResponseError.theHostId = std::string((const char*)value, len);         
   } else if (lHandler->isSet(Truncated)) {
     lRes->theIsTruncated = ((std::string((const char*)value, len)).compare("true") == 0);
+  } else if (lHandler->isSet(EncodingType)) {
+    lHandler->theUrlEncoded = ((std::string((const char*)value, len)).compare("url") == 0);
   } else if (lHandler->isSet(Contents) && lHandler->isSet(Key)) {
-    ListBucketResponse::Key lKey;
-    lKey.KeyValue = std::string((const char*)value, len);
-    lRes->theKeys.push_back(lKey);
+    lRes->theKeys.push_back(ListBucketResponse::Key());
+    ListBucketResponse::Key& lKey = lRes->theKeys.back();
+    lKey.KeyValue.assign((const char*)value, len);
+    lKey.Length = 0;
   } else if (lHandler->isSet(Contents) && lHandler->isSet(LastModified)) {
-    // FIXME convert to tm or time_t
     ListBucketResponse::Key& lKey = lRes->theKeys.back();
-    lKey.LastModified = std::string((const char*)value, len);
+    lKey.LastModified.assign((const char*)value, len);
+    time_t lTime;
+    if (Time::parseISO8601((const char*)value, len, lTime))
+      lKey.LastModifiedTime = Time(lTime);
   } else if (lHandler->isSet(Contents) && lHandler->isSet(ETag)) {
-    if (len != 1) {
-      ListBucketResponse::Key& lKey = lRes->theKeys.back();
-      lKey.ETag = std::string((const char*)value, len);
+    // the etag is quoted, the quotes aren't part of the md5
+    ListBucketResponse::Key& lKey = lRes->theKeys.back();
+    if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+      lKey.ETag.assign((const char*)value + 1, len - 2);
+    } else {
+      lKey.ETag.assign((const char*)value, len);
     }
   } else if (lHandler->isSet(Contents) && lHandler->isSet(Length)) {
-    char** lEndValue = 0;
     ListBucketResponse::Key& lKey = lRes->theKeys.back();
     std::string lTmp((const char*)value, len);
 #ifdef HAVE_STRTOIMAX_F
-    lKey.Length = strtoimax(lTmp.c_str(), lEndValue, 10);
+    lKey.Length = strtoimax(lTmp.c_str(), 0, 10);
 #else
-
-#endif
-#ifndef NDEBUG
-    assert(lEndValue=='\0');
+    lKey.Length = strtoll(lTmp.c_str(), 0, 10);
 #endif
   } else if (lHandler->isSet(CommonPrefixes) && lHandler->isSet(Prefix)) {
     lRes->theCommonPrefixes.push_back(std::string((const char*)value, len));
@@ -446,37 +548,73 @@ ListBucketHandler::endElementNs(void * ctx,
     					         const xmlChar * URI)
 {
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
-  // ListBucketResponse* lRes     = static_cast<ListBucketResponse*>( lWrapper->theResponse );
+  ListBucketResponse* lRes     = static_cast<ListBucketResponse*>( lWrapper->theResponse );
   ListBucketHandler*  lHandler = static_cast<ListBucketHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  switch (lElement) {
+  case element::Code:
     lHandler->unsetState(Code);
-  } else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+    break;
+  case element::Message:
     lHandler->unsetState(Message);
-  } else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+    break;
+  case element::RequestId:
     lHandler->unsetState(RequestId);
-  } else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+    break;
+  case element::HostId:
     lHandler->unsetState(HostId);
-  } else if (xmlStrEqual(localname, BAD_CAST "Name")) {
+    break;
+  case element::Name:
     lHandler->unsetState(Name);
-  } else if (xmlStrEqual(localname, BAD_CAST "Prefix")) {
+    break;
+  case element::Prefix:
     lHandler->unsetState(Prefix);
-  } else if (xmlStrEqual(localname, BAD_CAST "Marker")) {
+    break;
+  case element::Marker:
     lHandler->unsetState(Marker);
-  } else if (xmlStrEqual(localname, BAD_CAST "IsTruncated")) {
+    break;
+  case element::IsTruncated:
     lHandler->unsetState(Truncated);
-  } else if (xmlStrEqual(localname, BAD_CAST "Contents")) {
+    break;
+  case element::Contents:
     lHandler->unsetState(Contents);
-  } else if (xmlStrEqual(localname, BAD_CAST "Key")) {
+    break;
+  case element::Key:
     lHandler->unsetState(Key);
-  } else if (xmlStrEqual(localname, BAD_CAST "LastModified")) {
+    break;
+  case element::LastModified:
     lHandler->unsetState(LastModified);
-  } else if (xmlStrEqual(localname, BAD_CAST "ETag")) {
+    break;
+  case element::ETag:
     lHandler->unsetState(ETag);
-  } else if (xmlStrEqual(localname, BAD_CAST "Size")) {
+    break;
+  case element::Size:
     lHandler->unsetState(Length);
-  } else if (xmlStrEqual(localname, BAD_CAST "CommonPrefixes")) {
+    break;
+  case element::CommonPrefixes:
     lHandler->unsetState(CommonPrefixes);
+    break;
+  case element::EncodingType:
+    lHandler->unsetState(EncodingType);
+    break;
+  case element::ListBucketResult:
+    if (!lHandler->theUrlEncoded) {
+      break;
+    }
+    // EncodingType may follow the keys, so they are decoded at the end
+    std::string lDecoded;
+    for (std::vector<ListBucketResponse::Key>::iterator lIter = lRes->theKeys.begin();
+         lIter != lRes->theKeys.end(); ++lIter) {
+      UrlEncoding::decode((*lIter).KeyValue, lDecoded);
+      (*lIter).KeyValue.swap(lDecoded);
+    }
+    for (std::vector<std::string>::iterator lIter = lRes->theCommonPrefixes.begin();
+         lIter != lRes->theCommonPrefixes.end(); ++lIter) {
+      UrlEncoding::decode(*lIter, lDecoded);
+      (*lIter).swap(lDecoded);
+    }
+    break;
   }
 }
 
@@ -499,20 +637,21 @@ PutHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   PutResponse* lRes     = static_cast<PutResponse*>( lWrapper->theResponse );
   PutHandler*  lHandler = static_cast<PutHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->setState(HostId);
   }
 }
@@ -549,17 +688,18 @@ PutHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   // PutResponse* lRes     = static_cast<PutResponse*>( lWrapper->theResponse );
   PutHandler*  lHandler = static_cast<PutHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->unsetState(HostId);
   }
 }
@@ -585,20 +725,21 @@ GetHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   GetResponse* lRes     = static_cast<GetResponse*>( lWrapper->theResponse );
   GetHandler*  lHandler = static_cast<GetHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->setState(HostId);
   }
 }
@@ -635,17 +776,18 @@ GetHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   // GetResponse* lRes     = static_cast<GetResponse*>( lWrapper->theResponse );
   GetHandler*  lHandler = static_cast<GetHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->unsetState(HostId);
   }
 }
@@ -672,20 +814,21 @@ HeadHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   HeadResponse* lRes     = static_cast<HeadResponse*>( lWrapper->theResponse );
   HeadHandler*  lHandler = static_cast<HeadHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->setState(HostId);
   }
 }
@@ -722,17 +865,18 @@ HeadHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   // HeadResponse* lRes     = static_cast<HeadResponse*>( lWrapper->theResponse );
   HeadHandler*  lHandler = static_cast<HeadHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->unsetState(HostId);
   }
 }
@@ -759,20 +903,21 @@ DeleteHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   DeleteResponse* lRes     = static_cast<DeleteResponse*>( lWrapper->theResponse );
   DeleteHandler*  lHandler = static_cast<DeleteHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
       lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
       lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->setState(HostId);
   }
 }
@@ -809,17 +954,18 @@ DeleteHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   // DeleteResponse* lRes     = static_cast<DeleteResponse*>( lWrapper->theResponse );
   DeleteHandler*  lHandler = static_cast<DeleteHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
       lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
       lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
       lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
       lHandler->unsetState(HostId);
   }
 }
@@ -845,26 +991,27 @@ BucketLoggingStatusHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   BucketLoggingStatusResponse* lRes     = static_cast<BucketLoggingStatusResponse*>( lWrapper->theResponse );
   BucketLoggingStatusHandler*  lHandler = static_cast<BucketLoggingStatusHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
     lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
     lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->setState(HostId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "TargetBucket")) {
+  else if (lElement == element::TargetBucket) {
     lHandler->setState(TargetBucket);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "TargetPrefix")) {
+  else if (lElement == element::TargetPrefix) {
     lHandler->setState(TargetPrefix);
   }
 }
@@ -907,23 +1054,24 @@ BucketLoggingStatusHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   BucketLoggingStatusResponse* lRes     = static_cast<BucketLoggingStatusResponse*>( lWrapper->theResponse );
   BucketLoggingStatusHandler*  lHandler = static_cast<BucketLoggingStatusHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
     lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->unsetState(HostId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "TargetBucket")) {
+  else if (lElement == element::TargetBucket) {
     lHandler->unsetState(TargetBucket);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "TargetPrefix")) {
+  else if (lElement == element::TargetPrefix) {
     lHandler->unsetState(TargetPrefix);
   }
 }
@@ -949,20 +1097,21 @@ SetBucketLoggingHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   SetBucketLoggingResponse* lRes     = static_cast<SetBucketLoggingResponse*>( lWrapper->theResponse );
   SetBucketLoggingHandler*  lHandler = static_cast<SetBucketLoggingHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
     lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
     lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->setState(HostId);
   }
 }
@@ -999,17 +1148,18 @@ SetBucketLoggingHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   SetBucketLoggingResponse* lRes     = static_cast<SetBucketLoggingResponse*>( lWrapper->theResponse );
   SetBucketLoggingHandler*  lHandler = static_cast<SetBucketLoggingHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
     lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->unsetState(HostId);
   }
 }
@@ -1035,20 +1185,21 @@ DisableBucketLoggingHandler::startElementNs( void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   DisableBucketLoggingResponse* lRes     = static_cast<DisableBucketLoggingResponse*>( lWrapper->theResponse );
   DisableBucketLoggingHandler*  lHandler = static_cast<DisableBucketLoggingHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Error")) {
+  if (lElement == element::Error) {
     lRes->theIsSuccessful = false;
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  else if (lElement == element::Code) {
     lHandler->setState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->setState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->setState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->setState(HostId);
   }
 }
@@ -1085,17 +1236,18 @@ DisableBucketLoggingHandler::endElementNs(void * ctx,
   S3CallBackWrapper*    lWrapper = static_cast<S3CallBackWrapper*>( ctx );
   DisableBucketLoggingResponse* lRes     = static_cast<DisableBucketLoggingResponse*>( lWrapper->theResponse );
   DisableBucketLoggingHandler*  lHandler = static_cast<DisableBucketLoggingHandler*>(lWrapper->theHandler);
+  int lElement = theElements.lookup(localname);
 
-  if (xmlStrEqual(localname, BAD_CAST "Code")) {
+  if (lElement == element::Code) {
     lHandler->unsetState(Code);
   } 
-  else if (xmlStrEqual(localname, BAD_CAST "Message")) {
+  else if (lElement == element::Message) {
     lHandler->unsetState(Message);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "RequestId")) {
+  else if (lElement == element::RequestId) {
     lHandler->unsetState(RequestId);
   }
-  else if (xmlStrEqual(localname, BAD_CAST "HostId")) {
+  else if (lElement == element::HostId) {
     lHandler->unsetState(HostId);
   }
 }
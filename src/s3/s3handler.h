@@ -168,9 +168,13 @@ protected:
         LastModified = 1024,
         ETag         = 2048,
         Length         = 4096,
-        CommonPrefixes = 8192
+        CommonPrefixes = 8192,
+        EncodingType   = 16384
     };
 
+    // the listing was requested with encoding-type=url
+    bool theUrlEncoded;
+
 public:
     static void startElementNs( void * ctx, 
                                 const xmlChar * localname, 
@@ -15,9 +15,13 @@
  */
 #include "common.h"
 #include <iostream>
+#include <sstream>
+#include <curl/curl.h>
 
 #include "curlstreambuf.h"
 #include "s3/s3response.h"
+#include "s3/s3connection.h"
+#include "s3/s3callbackwrapper.h"
 
 namespace aws { namespace s3 {
 
@@ -65,6 +69,8 @@ namespace aws { namespace s3 {
           return "InvalidAccessKeyId";
         case S3Exception::BucketAlreadyExists:
           return "BucketAlreadyExists";
+        case S3Exception::ConnectionError:
+          return "ConnectionError";
         default:
           return "Not implemented the Conversion";
       }
@@ -128,7 +134,12 @@ namespace aws { namespace s3 {
 
     ListBucketResponse::ListBucketResponse(const std::string& aBucketName, const std::string& aPrefix,
                                            const std::string& aMarker, int aMaxKeys)
-        : S3Response()
+        : S3Response(),
+        theBucketName ( aBucketName ),
+        thePrefix ( aPrefix ),
+        theMarker ( aMarker ),
+        theMaxKeys ( aMaxKeys ),
+        theIsTruncated ( false )
     {
     }
 
@@ -148,6 +159,7 @@ namespace aws { namespace s3 {
       if (theIterator != theKeys.end()) {
         aKey.KeyValue     = (*theIterator).KeyValue;
         aKey.LastModified = (*theIterator).LastModified;
+        aKey.LastModifiedTime = (*theIterator).LastModifiedTime;
         aKey.ETag         = (*theIterator).ETag;
         aKey.Length       = (*theIterator).Length;
         ++theIterator;
@@ -217,6 +229,168 @@ namespace aws { namespace s3 {
     }
 
 
+    HeadManyResponse::HeadManyResponse ( S3Connection* aConnection,
+                                         const std::string& aBucketName,
+                                         const std::vector<std::string>& aKeys,
+                                         int aConcurrency )
+        : theConnection ( aConnection ),
+          theBucketName ( aBucketName ),
+          theKeys ( aKeys ),
+          theNextKey ( 0 ),
+          theConcurrency ( aConcurrency > 0 ? aConcurrency : 1 ),
+          theMultiHandle ( 0 )
+    {
+      theIsSuccessful = true;
+    }
+
+    HeadManyResponse::~HeadManyResponse()
+    {
+      close();
+    }
+
+    void
+    HeadManyResponse::open()
+    {
+      close();
+      theNextKey = 0;
+      theMultiHandle = curl_multi_init();
+      startRequests();
+    }
+
+    bool
+    HeadManyResponse::next(Key& aKey)
+    {
+      while (theFinished.empty() && !theRunning.empty()) {
+        perform();
+      }
+      if (theFinished.empty()) {
+        return false;
+      }
+      aKey = theFinished.front();
+      theFinished.pop_front();
+      return true;
+    }
+
+    void
+    HeadManyResponse::close()
+    {
+      for (std::map<CURL*, Request>::iterator lIter = theRunning.begin();
+           lIter != theRunning.end(); ++lIter) {
+        curl_multi_remove_handle(theMultiHandle, lIter->first);
+        curl_easy_cleanup(lIter->first);
+        curl_slist_free_all(lIter->second.theHeaders);
+        delete lIter->second.theWrapper;
+        delete lIter->second.theResponse;
+      }
+      theRunning.clear();
+      theFinished.clear();
+      if (theMultiHandle) {
+        curl_multi_cleanup(theMultiHandle);
+        theMultiHandle = 0;
+      }
+      theNextKey = theKeys.size();
+    }
+
+    void
+    HeadManyResponse::startRequests()
+    {
+      while (theRunning.size() < (size_t) theConcurrency && theNextKey < theKeys.size()) {
+        Request lRequest;
+        lRequest.theKey = theKeys[theNextKey++];
+        lRequest.theResponse = new HeadResponse(theBucketName);
+        lRequest.theWrapper = new S3CallBackWrapper();
+        lRequest.theWrapper->theResponse = lRequest.theResponse;
+        lRequest.theWrapper->theHandler = 0;
+
+        CURL* lCurl = theConnection->createHeadRequest(theBucketName, lRequest.theKey,
+                                                       lRequest.theWrapper, &lRequest.theHeaders);
+        theRunning[lCurl] = lRequest;
+        curl_multi_add_handle(theMultiHandle, lCurl);
+      }
+    }
+
+    void
+    HeadManyResponse::perform()
+    {
+      int lStillRunning = 0;
+      while (CURLM_CALL_MULTI_PERFORM == curl_multi_perform(theMultiHandle, &lStillRunning))
+        ;
+
+      CURLMsg* lMsg;
+      int lMsgsInQueue;
+      bool lFinished = false;
+      while ((lMsg = curl_multi_info_read(theMultiHandle, &lMsgsInQueue))) {
+        if (lMsg->msg == CURLMSG_DONE) {
+          finishRequest(lMsg->easy_handle, lMsg->data.result);
+          lFinished = true;
+        }
+      }
+
+      if (lFinished) {
+        // refill the free slots
+        startRequests();
+        return;
+      }
+
+      // nothing finished yet -> wait until one of the sockets gets ready
+      // (poll based, the descriptors may be beyond FD_SETSIZE)
+      long lTimeout = -1;
+      curl_multi_timeout(theMultiHandle, &lTimeout);
+      if (lTimeout < 0 || lTimeout > 1000) {
+        lTimeout = 1000;
+      }
+      curl_multi_wait(theMultiHandle, NULL, 0, (int) lTimeout, NULL);
+    }
+
+    void
+    HeadManyResponse::finishRequest(CURL* aCurl, int aResult)
+    {
+      std::map<CURL*, Request>::iterator lIter = theRunning.find(aCurl);
+      if (lIter == theRunning.end()) {
+        return;
+      }
+      Request& lRequest = lIter->second;
+      HeadResponse* lRes = lRequest.theResponse;
+
+      Key lKey;
+      lKey.KeyValue      = lRequest.theKey;
+      lKey.IsSuccessful  = false;
+      lKey.ErrorCode     = S3Exception::NoError;
+      lKey.ContentLength = 0;
+
+      long lHttpCode = 0;
+      curl_easy_getinfo(aCurl, CURLINFO_RESPONSE_CODE, &lHttpCode);
+
+      if (aResult != CURLE_OK) {
+        lKey.ErrorCode    = (aResult == CURLE_OPERATION_TIMEDOUT) ? S3Exception::RequestTimeout
+                                                                  : S3Exception::ConnectionError;
+        lKey.ErrorMessage = curl_easy_strerror((CURLcode) aResult);
+      } else if (lRes->isSuccessful()) {
+        lKey.IsSuccessful  = true;
+        lKey.ContentLength = lRes->getContentLength();
+        lKey.ContentType   = lRes->getContentType();
+        lKey.ETag          = lRes->getETag();
+        lKey.MetaData      = lRes->getMetaData();
+      } else if (lHttpCode == 404) {
+        lKey.ErrorCode    = S3Exception::NoSuchKey;
+        lKey.ErrorMessage = "NOT FOUND";
+      } else {
+        std::ostringstream lMessage;
+        lMessage << "HEAD request failed with http status " << lHttpCode;
+        lKey.ErrorCode    = (lHttpCode == 403) ? S3Exception::AccessDenied
+                                               : S3Exception::InternalError;
+        lKey.ErrorMessage = lMessage.str();
+      }
+      theFinished.push_back(lKey);
+
+      curl_multi_remove_handle(theMultiHandle, aCurl);
+      curl_easy_cleanup(aCurl);
+      curl_slist_free_all(lRequest.theHeaders);
+      delete lRequest.theWrapper;
+      delete lRequest.theResponse;
+      theRunning.erase(lIter);
+    }
+
     DeleteResponse::DeleteResponse ( const std::string& aBucketName,
                                      const std::string& aKey )
         : theBucketName ( aBucketName ),
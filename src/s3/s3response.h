@@ -21,15 +21,21 @@
 #include <libaws/awstime.h>
 #include <libaws/s3exception.h>
 #include <vector>
+#include <deque>
 #include <time.h>
 #include <sstream>
 #include <istream>
 
 #include "response.h"
 
+typedef void CURL;
+typedef void CURLM;
+struct curl_slist;
+
 namespace aws { namespace s3  {
 
   class CurlStreamBuffer;
+  class S3CallBackWrapper;
 
   class S3ResponseError
   {
@@ -184,6 +190,7 @@ public:
     struct Key {
       std::string KeyValue;
       std::string LastModified;
+      Time        LastModifiedTime;
       std::string ETag;
       intmax_t    Length;
     };
@@ -342,6 +349,75 @@ protected:
     Time              theLastModified;
 };
 
+/**
+ * Response of a bulk HEAD request.
+ *
+ * The HEAD requests are sent concurrently (at most theConcurrency at a time)
+ * over a curl multi handle when the response is opened. next() returns the
+ * results in the order the requests complete. A failing key doesn't abort the
+ * other requests but is returned with IsSuccessful set to false.
+ * The response must not outlive the connection that created it.
+ */
+class HeadManyResponse : public S3Response
+{
+    friend class S3Connection;
+public:
+    struct Key {
+      std::string                         KeyValue;
+      bool                                IsSuccessful;
+      S3Exception::ErrorCode              ErrorCode;
+      std::string                         ErrorMessage;
+      long long                           ContentLength;
+      std::string                         ContentType;
+      std::string                         ETag;
+      std::map<std::string, std::string>  MetaData;
+    };
+
+    virtual ~HeadManyResponse();
+
+    const std::string&
+    getBucketName() const { return theBucketName; }
+
+    void
+    open();
+
+    bool
+    next(Key& aKey);
+
+    void
+    close();
+
+protected:
+    HeadManyResponse(S3Connection* aConnection, const std::string& aBucketName,
+                     const std::vector<std::string>& aKeys, int aConcurrency);
+
+    // one running request
+    struct Request {
+      std::string        theKey;
+      HeadResponse*      theResponse;
+      S3CallBackWrapper* theWrapper;
+      struct curl_slist* theHeaders;
+    };
+
+    void
+    startRequests();
+
+    void
+    perform();
+
+    void
+    finishRequest(CURL* aCurl, int aResult);
+
+    S3Connection*               theConnection;
+    std::string                 theBucketName;
+    std::vector<std::string>    theKeys;
+    size_t                      theNextKey;
+    int                         theConcurrency;
+    CURLM*                      theMultiHandle;
+    std::map<CURL*, Request>    theRunning;
+    std::deque<Key>             theFinished;
+};
+
 class DeleteResponse : public S3Response
 {
     friend class DeleteHandler;
@@ -16,6 +16,7 @@
 #include "common.h"
 #include "sdb/sdbhandler.h"
 #include "sdb/sdbresponse.h"
+#include "elementmap.h"
 #include <iostream>
 #include <stdlib.h>
 
@@ -26,25 +27,106 @@ using namespace aws;
 namespace aws {
 	namespace sdb {
 
+		namespace {
+
+			// the element names the handlers dispatch on
+			namespace element {
+				enum {
+					ErrorResponse = 1,
+					Error,
+					BoxUsage,
+					Code,
+					Message,
+					RequestID,
+					CreateDomainResponse,
+					DeleteDomainResponse,
+					DomainMetadataResponse,
+					ItemCount,
+					ItemNamesSizeBytes,
+					AttributeNameCount,
+					AttributeNamesSizeBytes,
+					AttributeValueCount,
+					AttributeValuesSizeBytes,
+					Timestamp,
+					ListDomainsResponse,
+					DomainName,
+					NextToken,
+					PutAttributesResponse,
+					BatchPutAttributesResponse,
+					DeleteAttributesResponse,
+					GetAttributesResponse,
+					Name,
+					Value,
+					QueryResponse,
+					ItemName,
+					QueryWithAttributesResponse,
+					Item,
+					Attribute,
+					AttributeName,
+					AttributeValue
+				};
+			}
+
+			const ElementMap::Entry theElementEntries[] = {
+				{ "ErrorResponse", element::ErrorResponse },
+				{ "Error", element::Error },
+				{ "BoxUsage", element::BoxUsage },
+				{ "Code", element::Code },
+				{ "Message", element::Message },
+				{ "RequestID", element::RequestID },
+				{ "CreateDomainResponse", element::CreateDomainResponse },
+				{ "DeleteDomainResponse", element::DeleteDomainResponse },
+				{ "DomainMetadataResponse", element::DomainMetadataResponse },
+				{ "ItemCount", element::ItemCount },
+				{ "ItemNamesSizeBytes", element::ItemNamesSizeBytes },
+				{ "AttributeNameCount", element::AttributeNameCount },
+				{ "AttributeNamesSizeBytes", element::AttributeNamesSizeBytes },
+				{ "AttributeValueCount", element::AttributeValueCount },
+				{ "AttributeValuesSizeBytes", element::AttributeValuesSizeBytes },
+				{ "Timestamp", element::Timestamp },
+				{ "ListDomainsResponse", element::ListDomainsResponse },
+				{ "DomainName", element::DomainName },
+				{ "NextToken", element::NextToken },
+				{ "PutAttributesResponse", element::PutAttributesResponse },
+				{ "BatchPutAttributesResponse", element::BatchPutAttributesResponse },
+				{ "DeleteAttributesResponse", element::DeleteAttributesResponse },
+				{ "GetAttributesResponse", element::GetAttributesResponse },
+				{ "Name", element::Name },
+				{ "Value", element::Value },
+				{ "QueryResponse", element::QueryResponse },
+				{ "ItemName", element::ItemName },
+				{ "QueryWithAttributesResponse", element::QueryWithAttributesResponse },
+				{ "Item", element::Item },
+				{ "Attribute", element::Attribute },
+				{ "AttributeName", element::AttributeName },
+				{ "AttributeValue", element::AttributeValue }
+			};
+
+			const ElementMap theElements(theElementEntries,
+					sizeof(theElementEntries) / sizeof(ElementMap::Entry));
+
+		} /* namespace */
+
 		template<class T>
 		void SDBHandler<T>::startElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar ** attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "ErrorResponse") || xmlStrEqual(localname, (xmlChar*) "Error")) {
+			theElement = theElements.lookup(localname);
+			if (theElement == element::ErrorResponse || theElement == element::Error) {
 				theIsSuccessful = false;
 			}
-			else if (theIsSuccessful && xmlStrEqual(localname, (xmlChar*) "BoxUsage")) {
+			else if (theIsSuccessful && theElement == element::BoxUsage) {
 				setState(BoxUsage);
 			}
 			else if (theIsSuccessful) {
 				responseStartElement(localname, nb_attributes, attributes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Code")) {
+			else if (theElement == element::Code) {
 				setState(ERROR_Code);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Message")) {
+			else if (theElement == element::Message) {
 				setState(ERROR_Message);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "RequestID")) {
+			else if (theElement == element::RequestID) {
 				setState(RequestId);
 			}
 
@@ -78,8 +160,9 @@ namespace aws {
 
 		template<class T>
 		void SDBHandler<T>::endElement(const xmlChar * localname) {
+			theElement = theElements.lookup(localname);
 			if (theIsSuccessful) {
-				if (xmlStrEqual(localname, (xmlChar*) "BoxUsage")) {
+				if (theElement == element::BoxUsage) {
 					unsetState(BoxUsage);
 				}
 				else {
@@ -87,13 +170,13 @@ namespace aws {
 				}
 			}
 			else {
-				if (xmlStrEqual(localname, (xmlChar*) "Code")) {
+				if (theElement == element::Code) {
 					unsetState(ERROR_Code);
 				}
-				else if (xmlStrEqual(localname, (xmlChar*) "Message")) {
+				else if (theElement == element::Message) {
 					unsetState(ERROR_Message);
 				}
-				else if (xmlStrEqual(localname, (xmlChar*) "RequestID")) {
+				else if (theElement == element::RequestID) {
 					unsetState(RequestId);
 				}
 			}
@@ -101,7 +184,7 @@ namespace aws {
 
 		void CreateDomainHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "CreateDomainResponse")) {
+			if (theElement == element::CreateDomainResponse) {
 				theResponse = new CreateDomainResponse();
 			}
 		}
@@ -114,7 +197,7 @@ namespace aws {
 
 		void DeleteDomainHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "DeleteDomainResponse")) {
+			if (theElement == element::DeleteDomainResponse) {
 				theResponse = new DeleteDomainResponse();
 			}
 		}
@@ -127,28 +210,28 @@ namespace aws {
 
 		void DomainMetadataHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "DomainMetadataResponse")) {
+			if (theElement == element::DomainMetadataResponse) {
 				theResponse = new DomainMetadataResponse();
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "ItemCount")) {
+			else if (theElement == element::ItemCount) {
 				setState(ItemCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "ItemNamesSizeBytes")) {
+			else if (theElement == element::ItemNamesSizeBytes) {
 				setState(ItemNamesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeNameCount")) {
+			else if (theElement == element::AttributeNameCount) {
 				setState(AttributeNameCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeNamesSizeBytes")) {
+			else if (theElement == element::AttributeNamesSizeBytes) {
 				setState(AttributeNamesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValueCount")) {
+			else if (theElement == element::AttributeValueCount) {
 				setState(AttributeValueCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValuesSizeBytes")) {
+			else if (theElement == element::AttributeValuesSizeBytes) {
 				setState(AttributeValuesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Timestamp")) {
+			else if (theElement == element::Timestamp) {
 				setState(Timestamp);
 			}
 		}
@@ -186,38 +269,38 @@ namespace aws {
 		}
 
 		void DomainMetadataHandler::responseEndElement(const xmlChar * localname) {
-			if (xmlStrEqual(localname, (xmlChar*) "ItemCount")) {
+			if (theElement == element::ItemCount) {
 				unsetState(ItemCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "ItemNamesSizeBytes")) {
+			else if (theElement == element::ItemNamesSizeBytes) {
 				unsetState(ItemNamesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeNameCount")) {
+			else if (theElement == element::AttributeNameCount) {
 				unsetState(AttributeNameCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeNamesSizeBytes")) {
+			else if (theElement == element::AttributeNamesSizeBytes) {
 				unsetState(AttributeNamesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValueCount")) {
+			else if (theElement == element::AttributeValueCount) {
 				unsetState(AttributeValueCount);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValuesSizeBytes")) {
+			else if (theElement == element::AttributeValuesSizeBytes) {
 				unsetState(AttributeValuesSizeBytes);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Timestamp")) {
+			else if (theElement == element::Timestamp) {
 				unsetState(Timestamp);
 			}
 		}
 
 		void ListDomainsHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "ListDomainsResponse")) {
+			if (theElement == element::ListDomainsResponse) {
 				theResponse = new ListDomainsResponse();
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "DomainName")) {
+			else if (theElement == element::DomainName) {
 				setState(DomainName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				setState(NextToken);
 			}
 		}
@@ -233,17 +316,17 @@ namespace aws {
 		}
 
 		void ListDomainsHandler::responseEndElement(const xmlChar * localname) {
-			if (xmlStrEqual(localname, (xmlChar*) "DomainName")) {
+			if (theElement == element::DomainName) {
 				unsetState(DomainName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				unsetState(NextToken);
 			}
 		}
 
 		void PutAttributesHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "PutAttributesResponse")) {
+			if (theElement == element::PutAttributesResponse) {
 				theResponse = new PutAttributesResponse();
 			}
 		}
@@ -257,7 +340,7 @@ namespace aws {
 
 		void BatchPutAttributesHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "BatchPutAttributesResponse")) {
+			if (theElement == element::BatchPutAttributesResponse) {
 				theResponse = new BatchPutAttributesResponse();
 			}
 		}
@@ -272,7 +355,7 @@ namespace aws {
 		void DeleteAttributesHandler::responseStartElement(
 				const xmlChar * localname, int nb_attributes,
 				const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "DeleteAttributesResponse")) {
+			if (theElement == element::DeleteAttributesResponse) {
 				theResponse = new DeleteAttributesResponse();
 			}
 		}
@@ -286,13 +369,13 @@ namespace aws {
 
 		void GetAttributesHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "GetAttributesResponse")) {
+			if (theElement == element::GetAttributesResponse) {
 				theResponse = new GetAttributesResponse();
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Name")) {
+			else if (theElement == element::Name) {
 				setState(Name);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Value")) {
+			else if (theElement == element::Value) {
 				setState(Value);
 			}
 		}
@@ -310,23 +393,23 @@ namespace aws {
 		}
 
 		void GetAttributesHandler::responseEndElement(const xmlChar * localname) {
-			if (xmlStrEqual(localname, (xmlChar*) "Name")) {
+			if (theElement == element::Name) {
 				unsetState(Name);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Value")) {
+			else if (theElement == element::Value) {
 				unsetState(Value);
 			}
 		}
 
 		void QueryHandler::responseStartElement(const xmlChar * localname,
 				int nb_attributes, const xmlChar **attributes) {
-			if (xmlStrEqual(localname, (xmlChar*) "QueryResponse")) {
+			if (theElement == element::QueryResponse) {
 				theResponse = new SDBQueryResponse();
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "ItemName")) {
+			else if (theElement == element::ItemName) {
 				setState(ItemName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				setState(NextToken);
 			}
 		}
@@ -342,10 +425,10 @@ namespace aws {
 		}
 
 		void QueryHandler::responseEndElement(const xmlChar * localname) {
-			if (xmlStrEqual(localname, (xmlChar*) "ItemName")) {
+			if (theElement == element::ItemName) {
 				unsetState(ItemName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				unsetState(NextToken);
 			}
 		}
@@ -354,28 +437,28 @@ namespace aws {
     QueryWithAttributesHandler::responseStartElement(const xmlChar * localname,
 	                                     int nb_attributes, const xmlChar **attributes)
     {
-			if (xmlStrEqual(localname, (xmlChar*) "QueryWithAttributesResponse")) {
+			if (theElement == element::QueryWithAttributesResponse) {
 				theResponse = new SDBQueryWithAttributesResponse();
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Item")) {
+			else if (theElement == element::Item) {
         theResponse->theResponseElements.push_back(SDBQueryWithAttributesResponse::ResponseElement());
 				setState(Item);
 			}
-			else if (isSet(Item) && xmlStrEqual(localname, (xmlChar*) "Name")) {
+			else if (isSet(Item) && theElement == element::Name) {
 				setState(ItemName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Attribute")) {
+			else if (theElement == element::Attribute) {
         AttributePair lPair;
 				theResponse->theResponseElements.back().Attributes.push_back(lPair);
 				setState(Attribute);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeName")) {
+			else if (theElement == element::AttributeName) {
 				setState(AttributeName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValue")) {
+			else if (theElement == element::AttributeValue) {
 				setState(AttributeValue);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				setState(NextToken);
 			}
 		}
@@ -401,22 +484,22 @@ namespace aws {
 		void
     QueryWithAttributesHandler::responseEndElement(const xmlChar * localname)
     {
-			if (xmlStrEqual(localname, (xmlChar*) "Item")) {
+			if (theElement == element::Item) {
 				unsetState(Item);
 			}
-			else if (isSet(Item) && xmlStrEqual(localname, (xmlChar*) "Name")) {
+			else if (isSet(Item) && theElement == element::Name) {
 				unsetState(ItemName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "Attribute")) {
+			else if (theElement == element::Attribute) {
 				unsetState(Attribute);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeName")) {
+			else if (theElement == element::AttributeName) {
 				unsetState(AttributeName);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "AttributeValue")) {
+			else if (theElement == element::AttributeValue) {
 				unsetState(AttributeValue);
 			}
-			else if (xmlStrEqual(localname, (xmlChar*) "NextToken")) {
+			else if (theElement == element::NextToken) {
 				unsetState(NextToken);
 			}
 		}
@@ -22,6 +22,7 @@
 #include <sstream>
 #include <memory>
 #include <cassert>
+#include <cstdlib>
 
 
 using namespace aws;
@@ -30,6 +31,8 @@ namespace aws { namespace sqs {
 
   const std::string SQSConnection::DEFAULT_VERSION = "2008-01-01";
   const std::string SQSConnection::DEFAULT_HOST = "queue.amazonaws.com";
+  const std::string SQSConnection::BATCH_VERSION = "2011-10-01";
+  const std::string SQSConnection::LONG_POLLING_VERSION = "2012-11-05";
 
   SQSConnection::SQSConnection(const std::string& aAccessKeyId,
                                const std::string& aSecretAccessKey,
@@ -140,7 +143,8 @@ namespace aws { namespace sqs {
   SQSConnection::receiveMessage (const std::string &aQueueUrl,
                                  int aNumberOfMessages,
                                  int aVisibilityTimeout,
-                                 bool aDecode) {
+                                 bool aDecode,
+                                 int aWaitTimeSeconds) {
     ParameterMap lMap;
     if (aNumberOfMessages != 0) {
         std::stringstream s;
@@ -152,6 +156,11 @@ namespace aws { namespace sqs {
         s << aVisibilityTimeout;
         lMap.insert (ParameterPair ("VisibilityTimeout", s.str()));
       }
+    if (aWaitTimeSeconds > 0) {
+        std::stringstream s;
+        s << aWaitTimeSeconds;
+        lMap.insert (ParameterPair ("WaitTimeSeconds", s.str()));
+      }
   
     return receiveMessage (aQueueUrl, lMap, aDecode);
   } 
@@ -160,8 +169,29 @@ namespace aws { namespace sqs {
   SQSConnection::receiveMessage (const std::string &aQueueUrl,
                                  ParameterMap& lMap,
                                  bool aDecode) {
+    // long polling: the request takes up to WaitTimeSeconds,
+    // the timeout of the connection must not cut it short
+    long lWaitTimeSeconds = 0;
+    ParameterMapIter lWait = lMap.find ("WaitTimeSeconds");
+    if (lWait != lMap.end()) {
+      lWaitTimeSeconds = atol (lWait->second.c_str());
+      if (lWaitTimeSeconds > MAX_WAIT_TIME_SECONDS) {
+        std::stringstream lTmp;
+        lTmp << "WaitTimeSeconds larger than " << MAX_WAIT_TIME_SECONDS << " : " << lWaitTimeSeconds;
+        throw ReceiveMessageException( QueryErrorResponse("1", lTmp.str(), "", "") );
+      }
+      if (lWaitTimeSeconds > 0) {
+        lMap.insert (ParameterPair ("Version", LONG_POLLING_VERSION));
+        // plus some slack for sending the request and the answer
+        raiseTimeout (lWaitTimeSeconds + 10);
+      }
+    }
+
     ReceiveMessageHandler lHandler(aDecode);
     makeQueryRequest (aQueueUrl, "ReceiveMessage", &lMap, &lHandler);
+    if (lWaitTimeSeconds > 0) {
+      raiseTimeout (0);
+    }
     if (lHandler.isSuccessful()) {
       setCommons(lHandler, lHandler.theReceiveMessageResponse);
         return lHandler.theReceiveMessageResponse;
@@ -186,5 +216,121 @@ namespace aws { namespace sqs {
     }
   }
 
+  template <class E> void
+  SQSConnection::checkBatchSize(size_t aNumberOfEntries)
+  {
+    if (aNumberOfEntries == 0 || aNumberOfEntries > MAX_BATCH_ENTRIES) {
+      std::stringstream lTmp;
+      lTmp << "A batch request needs between 1 and " << MAX_BATCH_ENTRIES
+           << " entries : " << aNumberOfEntries;
+      throw E( QueryErrorResponse("1", lTmp.str(), "", "") );
+    }
+  }
+
+  std::string
+  SQSConnection::batchEntryParameter(const std::string &aAction, size_t aIndex, const std::string &aName)
+  {
+    std::stringstream s;
+    s << aAction << "RequestEntry." << (aIndex + 1) << "." << aName;
+    return s.str();
+  }
+
+  SendMessageBatchResponse*
+  SQSConnection::sendMessageBatch(const std::string &aQueueUrl,
+                                  const std::vector<std::string> &aMessageBodies,
+                                  bool aEncode)
+  {
+    checkBatchSize<SendMessageBatchException>(aMessageBodies.size());
+
+    ParameterMap lMap;
+    // inserted first, so setCommonParamaters keeps it
+    lMap.insert ( ParameterPair ( "Version", BATCH_VERSION ) );
+    for (size_t i = 0; i < aMessageBodies.size(); ++i) {
+      const std::string& lBody = aMessageBodies[i];
+      long lBody64Len;
+      std::string enc;
+      if (aEncode)
+        enc = AWSConnection::base64Encode(lBody.c_str(), lBody.size(), lBody64Len);
+      else
+        enc = lBody;
+      if (enc.size() > 32768) {
+        std::stringstream lTmp;
+        lTmp << "Message " << i << " larger than 32kB : " << enc.size() / 1024 << " kb";
+        throw SendMessageBatchException( QueryErrorResponse("1", lTmp.str(), "", "") );
+      }
+      std::stringstream lId;
+      lId << i;
+      lMap.insert ( ParameterPair ( batchEntryParameter("SendMessageBatch", i, "Id"), lId.str() ) );
+      lMap.insert ( ParameterPair ( batchEntryParameter("SendMessageBatch", i, "MessageBody"), enc ) );
+    }
+
+    SendMessageBatchHandler lHandler;
+    makeQueryRequest ( aQueueUrl, "SendMessageBatch", &lMap, &lHandler );
+    if (lHandler.isSuccessful()) {
+      setCommons(lHandler, lHandler.theSendMessageBatchResponse);
+      return lHandler.theSendMessageBatchResponse;
+    } else {
+      throw SendMessageBatchException( lHandler.getQueryErrorResponse() );
+    }
+  }
+
+  DeleteMessageBatchResponse*
+  SQSConnection::deleteMessageBatch(const std::string &aQueueUrl,
+                                    const std::vector<std::string> &aReceiptHandles)
+  {
+    checkBatchSize<DeleteMessageBatchException>(aReceiptHandles.size());
+
+    ParameterMap lMap;
+    lMap.insert ( ParameterPair ( "Version", BATCH_VERSION ) );
+    for (size_t i = 0; i < aReceiptHandles.size(); ++i) {
+      std::stringstream lId;
+      lId << i;
+      lMap.insert ( ParameterPair ( batchEntryParameter("DeleteMessageBatch", i, "Id"), lId.str() ) );
+      lMap.insert ( ParameterPair ( batchEntryParameter("DeleteMessageBatch", i, "ReceiptHandle"),
+                                    aReceiptHandles[i] ) );
+    }
+
+    DeleteMessageBatchHandler lHandler;
+    makeQueryRequest ( aQueueUrl, "DeleteMessageBatch", &lMap, &lHandler );
+    if (lHandler.isSuccessful()) {
+      setCommons(lHandler, lHandler.theDeleteMessageBatchResponse);
+      return lHandler.theDeleteMessageBatchResponse;
+    } else {
+      throw DeleteMessageBatchException( lHandler.getQueryErrorResponse() );
+    }
+  }
+
+  ChangeMessageVisibilityBatchResponse*
+  SQSConnection::changeMessageVisibilityBatch(const std::string &aQueueUrl,
+                                              const std::vector<std::string> &aReceiptHandles,
+                                              int aVisibilityTimeout)
+  {
+    checkBatchSize<ChangeMessageVisibilityBatchException>(aReceiptHandles.size());
+
+    std::stringstream lTimeout;
+    lTimeout << aVisibilityTimeout;
+
+    ParameterMap lMap;
+    lMap.insert ( ParameterPair ( "Version", BATCH_VERSION ) );
+    for (size_t i = 0; i < aReceiptHandles.size(); ++i) {
+      std::stringstream lId;
+      lId << i;
+      lMap.insert ( ParameterPair ( batchEntryParameter("ChangeMessageVisibilityBatch", i, "Id"), lId.str() ) );
+      lMap.insert ( ParameterPair ( batchEntryParameter("ChangeMessageVisibilityBatch", i, "ReceiptHandle"),
+                                    aReceiptHandles[i] ) );
+      lMap.insert ( ParameterPair ( batchEntryParameter("ChangeMessageVisibilityBatch", i, "VisibilityTimeout"),
+                                    lTimeout.str() ) );
+    }
+
+    ChangeMessageVisibilityBatchHandler lHandler;
+    makeQueryRequest ( aQueueUrl, "ChangeMessageVisibilityBatch", &lMap, &lHandler );
+    if (lHandler.isSuccessful()) {
+      setCommons(lHandler, lHandler.theChangeMessageVisibilityBatchResponse);
+      return lHandler.theChangeMessageVisibilityBatchResponse;
+    } else {
+      throw ChangeMessageVisibilityBatchException( lHandler.getQueryErrorResponse() );
+    }
+  }
+
 }}//namespaces
 
@@ -19,9 +19,11 @@
 #include "common.h"
 
 #include <map>
+#include <vector>
 #include <iostream>
 
 #include "awsqueryconnection.h"
+#include <libaws/sqsconnection.h>
 
 namespace aws {
 
@@ -33,6 +35,9 @@ namespace aws {
     class SendMessageResponse;
     class ReceiveMessageResponse;
     class DeleteMessageResponse;
+    class SendMessageBatchResponse;
+    class DeleteMessageBatchResponse;
+    class ChangeMessageVisibilityBatchResponse;
 
     class SQSConnection : public AWSQueryConnection
     {
@@ -40,6 +45,14 @@ namespace aws {
         static const std::string DEFAULT_VERSION;
         static const std::string DEFAULT_HOST;
 
+        // the batch actions only exist since this version of the api
+        static const std::string BATCH_VERSION;
+        static const unsigned int MAX_BATCH_ENTRIES = ::aws::SQSConnection::MAX_BATCH_ENTRIES;
+
+        // WaitTimeSeconds only exists since this version of the api
+        static const std::string LONG_POLLING_VERSION;
+        static const int MAX_WAIT_TIME_SECONDS = 20;
+
       public:
         SQSConnection(const std::string& aAccessKeyId,
                       const std::string& aSecretAccessKey,
@@ -69,7 +82,8 @@ namespace aws {
         receiveMessage( const std::string &aQueueUrl,
                         int aNumberOfMessages = 0,
                         int aVisibilityTimeout = -1,
-                        bool aDecode = true);
+                        bool aDecode = true,
+                        int aWaitTimeSeconds = 0);
         
         virtual ReceiveMessageResponse*
         receiveMessage (const std::string &aQueueUrl,
@@ -78,6 +92,29 @@ namespace aws {
 
         virtual DeleteMessageResponse*
         deleteMessage( const std::string &aQueueUrl, const std::string &aReceiptHandle);
+
+        // the id of each entry is its position in the given vector
+        virtual SendMessageBatchResponse*
+        sendMessageBatch( const std::string &aQueueUrl,
+                          const std::vector<std::string> &aMessageBodies,
+                          bool aEncode = true);
+
+        virtual DeleteMessageBatchResponse*
+        deleteMessageBatch( const std::string &aQueueUrl,
+                            const std::vector<std::string> &aReceiptHandles);
+
+        virtual ChangeMessageVisibilityBatchResponse*
+        changeMessageVisibilityBatch( const std::string &aQueueUrl,
+                                      const std::vector<std::string> &aReceiptHandles,
+                                      int aVisibilityTimeout);
+
+      protected:
+        // throws aException if the number of entries isn't supported by a batch request
+        template <class E> static void
+        checkBatchSize(size_t aNumberOfEntries);
+
+        static std::string
+        batchEntryParameter(const std::string &aAction, size_t aIndex, const std::string &aName);
     };
 
   } /* namespace sqs  */
@@ -79,4 +79,19 @@ namespace aws {
 
     DeleteMessageException::~DeleteMessageException() throw() {}
 
+    SendMessageBatchException::SendMessageBatchException (const QueryErrorResponse& aError)
+        : SQSException (aError) {}
+
+    SendMessageBatchException::~SendMessageBatchException() throw() {}
+
+    DeleteMessageBatchException::DeleteMessageBatchException (const QueryErrorResponse& aError)
+        : SQSException (aError) {}
+
+    DeleteMessageBatchException::~DeleteMessageBatchException() throw() {}
+
+    ChangeMessageVisibilityBatchException::ChangeMessageVisibilityBatchException (const QueryErrorResponse& aError)
+        : SQSException (aError) {}
+
+    ChangeMessageVisibilityBatchException::~ChangeMessageVisibilityBatchException() throw() {}
+
   } /* namespace aws */
@@ -18,28 +18,99 @@
 #include "sqs/sqsresponse.h"
 #include <iostream>
 #include "awsconnection.h"
+#include "elementmap.h"
 
 #include <string>
 #include <cstring>
+#include <cstdlib>
 
 using namespace aws;
 
 namespace aws {
   namespace sqs {
 
+    namespace {
+
+      // the element names the handlers dispatch on
+      namespace element {
+        enum {
+          ErrorResponse = 1,
+          Code,
+          Message,
+          RequestID,
+          CreateQueueResponse,
+          DeleteQueueResponse,
+          ListQueuesResponse,
+          QueueUrl,
+          SendMessageResponse,
+          MessageId,
+          MD5OfMessageBody,
+          ReceiveMessageResponse,
+          ReceiptHandle,
+          MD5OfBody,
+          Body,
+          MetaData,
+          DeleteMessageResponse,
+          SendMessageBatchResponse,
+          SendMessageBatchResultEntry,
+          DeleteMessageBatchResponse,
+          DeleteMessageBatchResultEntry,
+          ChangeMessageVisibilityBatchResponse,
+          ChangeMessageVisibilityBatchResultEntry,
+          BatchResultErrorEntry,
+          Id,
+          SenderFault
+        };
+      }
+
+      const ElementMap::Entry theElementEntries[] = {
+        { "ErrorResponse", element::ErrorResponse },
+        { "Code", element::Code },
+        { "Message", element::Message },
+        { "RequestID", element::RequestID },
+        { "CreateQueueResponse", element::CreateQueueResponse },
+        { "DeleteQueueResponse", element::DeleteQueueResponse },
+        { "ListQueuesResponse", element::ListQueuesResponse },
+        { "QueueUrl", element::QueueUrl },
+        { "SendMessageResponse", element::SendMessageResponse },
+        { "MessageId", element::MessageId },
+        { "MD5OfMessageBody", element::MD5OfMessageBody },
+        { "ReceiveMessageResponse", element::ReceiveMessageResponse },
+        { "ReceiptHandle", element::ReceiptHandle },
+        { "MD5OfBody", element::MD5OfBody },
+        { "Body", element::Body },
+        { "MetaData", element::MetaData },
+        { "DeleteMessageResponse", element::DeleteMessageResponse },
+        { "SendMessageBatchResponse", element::SendMessageBatchResponse },
+        { "SendMessageBatchResultEntry", element::SendMessageBatchResultEntry },
+        { "DeleteMessageBatchResponse", element::DeleteMessageBatchResponse },
+        { "DeleteMessageBatchResultEntry", element::DeleteMessageBatchResultEntry },
+        { "ChangeMessageVisibilityBatchResponse", element::ChangeMessageVisibilityBatchResponse },
+        { "ChangeMessageVisibilityBatchResultEntry", element::ChangeMessageVisibilityBatchResultEntry },
+        { "BatchResultErrorEntry", element::BatchResultErrorEntry },
+        { "Id", element::Id },
+        { "SenderFault", element::SenderFault }
+      };
+
+      const ElementMap theElements ( theElementEntries,
+                                     sizeof ( theElementEntries ) / sizeof ( ElementMap::Entry ) );
+
+    } /* namespace */
+
     void
     QueueErrorHandler::startElement ( const xmlChar *  localname,
                                       int nb_attributes,
                                       const xmlChar ** attributes ) {
-      if (xmlStrEqual ( localname, BAD_CAST "ErrorResponse" ) ) {
+      theElement = theElements.lookup ( localname );
+      if (theElement == element::ErrorResponse ) {
         theIsSuccessful = false;
       } else if (theIsSuccessful ) {
         responseStartElement ( localname, nb_attributes, attributes );
-      } else if (xmlStrEqual ( localname, BAD_CAST "Code" )) {
+      } else if (theElement == element::Code) {
         setState ( ERROR_Code );
-      } else if (xmlStrEqual ( localname, BAD_CAST "Message" )) {
+      } else if (theElement == element::Message) {
         setState ( ERROR_Message );
-      } else if (xmlStrEqual ( localname, BAD_CAST "RequestID" )) {
+      } else if (theElement == element::RequestID) {
         setState ( RequestId );
       }
 
@@ -65,13 +136,14 @@ namespace aws {
 
     void
     QueueErrorHandler::endElement ( const xmlChar *  localname ) {
+      theElement = theElements.lookup ( localname );
       if (theIsSuccessful ){
         responseEndElement ( localname );
-      } else if (xmlStrEqual ( localname, BAD_CAST "Code" )) {
+      } else if (theElement == element::Code) {
         unsetState ( ERROR_Code );
-      } else if (xmlStrEqual ( localname, BAD_CAST "Message" )) {
+      } else if (theElement == element::Message) {
         unsetState ( ERROR_Message );
-      } else if (xmlStrEqual ( localname, BAD_CAST "RequestID" )) {
+      } else if (theElement == element::RequestID) {
         unsetState ( RequestId );
       }
 
@@ -80,9 +152,9 @@ namespace aws {
     void
     CreateQueueHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "CreateQueueResponse" ) ) {
+      if ( theElement == element::CreateQueueResponse ) {
         theCreateQueueResponse = new CreateQueueResponse();
-      } else if ( xmlStrEqual ( localname, BAD_CAST "QueueUrl" ) ) {
+      } else if ( theElement == element::QueueUrl ) {
         setState ( QueueUrl );
       }
     }
@@ -100,7 +172,7 @@ namespace aws {
     void
     CreateQueueHandler::responseEndElement ( const xmlChar * localname )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "QueueUrl" ) ) {
+      if ( theElement == element::QueueUrl ) {
         unsetState ( QueueUrl );
       }
     }
@@ -108,7 +180,7 @@ namespace aws {
     void
     DeleteQueueHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "DeleteQueueResponse" ) ) {
+      if ( theElement == element::DeleteQueueResponse ) {
         theDeleteQueueResponse = new DeleteQueueResponse();
       }
     }
@@ -126,9 +198,9 @@ namespace aws {
     void
     ListQueuesHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "ListQueuesResponse" ) ) {
+      if ( theElement == element::ListQueuesResponse ) {
         theListQueuesResponse = new ListQueuesResponse();
-      } else if ( xmlStrEqual ( localname, BAD_CAST "QueueUrl" ) ) {
+      } else if ( theElement == element::QueueUrl ) {
         setState ( QueueUrl );
       }
     }
@@ -145,7 +217,7 @@ namespace aws {
     void
     ListQueuesHandler::responseEndElement ( const xmlChar * localname )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "QueueUrl" ) ) {
+      if ( theElement == element::QueueUrl ) {
         unsetState ( QueueUrl );
       }
     }
@@ -153,11 +225,11 @@ namespace aws {
     void
     SendMessageHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "SendMessageResponse" ) ) {
+      if ( theElement == element::SendMessageResponse ) {
       	theSendMessageResponse = new SendMessageResponse();
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MessageId" ) ) {
+      } else if ( theElement == element::MessageId ) {
         setState ( MessageId );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MD5OfMessageBody" ) ) {
+      } else if ( theElement == element::MD5OfMessageBody ) {
         setState ( MD5OfMessageBody );
       }
     }
@@ -179,9 +251,9 @@ namespace aws {
     void
     SendMessageHandler::responseEndElement ( const xmlChar * localname )
     {
-    	if ( xmlStrEqual ( localname, BAD_CAST "MessageId" ) ) {
+    	if ( theElement == element::MessageId ) {
     		unsetState ( MessageId );
-    	} else if ( xmlStrEqual ( localname, BAD_CAST "MD5OfMessageBody" ) ) {
+    	} else if ( theElement == element::MD5OfMessageBody ) {
     		unsetState ( MD5OfMessageBody );
     	}
     }
@@ -189,20 +261,20 @@ namespace aws {
     void
     ReceiveMessageHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "ReceiveMessageResponse" ) ) {
+      if ( theElement == element::ReceiveMessageResponse ) {
       	theReceiveMessageResponse = new ReceiveMessageResponse();
-      } else if ( xmlStrEqual ( localname, BAD_CAST "Message" ) ) {
+      } else if ( theElement == element::Message ) {
       	ReceiveMessageResponse::Message lMessage;
       	theReceiveMessageResponse->theMessages.push_back(lMessage);
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MessageId" ) ) {
+      } else if ( theElement == element::MessageId ) {
         setState ( MessageId );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "ReceiptHandle" ) ) {
+      } else if ( theElement == element::ReceiptHandle ) {
         setState ( ReceiptHandle );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MD5OfBody" ) ) {
+      } else if ( theElement == element::MD5OfBody ) {
         setState ( MD5OfMessageBody );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "Body" ) ) {
+      } else if ( theElement == element::Body ) {
         setState ( Body );
-      }else if ( xmlStrEqual ( localname, BAD_CAST "MetaData" ) ) {
+      }else if ( theElement == element::MetaData ) {
         setState ( MetaData );
       }
     }
@@ -236,15 +308,15 @@ namespace aws {
     void
     ReceiveMessageHandler::responseEndElement ( const xmlChar * localname )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "MessageId" ) ) {
+      if ( theElement == element::MessageId ) {
       	unsetState ( MessageId );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "ReceiptHandle" ) ) {
+      } else if ( theElement == element::ReceiptHandle ) {
       	unsetState ( ReceiptHandle );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MD5OfBody" ) ) {
+      } else if ( theElement == element::MD5OfBody ) {
       	unsetState ( MD5OfMessageBody );
-      } else if ( xmlStrEqual ( localname, BAD_CAST "MetaData" ) ) {
+      } else if ( theElement == element::MetaData ) {
         unsetState ( MetaData );
-      }else if ( xmlStrEqual ( localname, BAD_CAST "Body" ) ) {
+      }else if ( theElement == element::Body ) {
       	unsetState ( Body );
         ReceiveMessageResponse::Message& lMessage = theReceiveMessageResponse->theMessages.back();
         if (theDecode) {
@@ -265,7 +337,7 @@ namespace aws {
     void
     DeleteMessageHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
     {
-      if ( xmlStrEqual ( localname, BAD_CAST "DeleteMessageResponse" ) ) {
+      if ( theElement == element::DeleteMessageResponse ) {
       	theDeleteMessageResponse = new DeleteMessageResponse();
       }
     }
@@ -280,5 +352,121 @@ namespace aws {
     {
     }
 
+    BatchHandler::BatchHandler(int aResponseElement, int aResultEntryElement)
+      : theResponseElement(aResponseElement),
+        theResultEntryElement(aResultEntryElement),
+        theBatchResponse(0)
+    {
+    }
+
+    void
+    BatchHandler::responseStartElement ( const xmlChar * localname, int nb_attributes, const xmlChar ** attributes )
+    {
+      bool lSuccessful = theElement == theResultEntryElement;
+      if ( theElement == theResponseElement ) {
+        theBatchResponse = createResponse();
+      } else if ( theBatchResponse == 0 ) {
+        return;
+      } else if ( lSuccessful || theElement == element::BatchResultErrorEntry ) {
+        BatchResponse::Entry lEntry;
+        lEntry.index = 0;
+        lEntry.successful = lSuccessful;
+        lEntry.sender_fault = false;
+        theBatchResponse->theEntries.push_back(lEntry);
+      } else if ( theBatchResponse->theEntries.empty() ) {
+        return;
+      } else if ( theElement == element::Id ) {
+        setState ( BatchId );
+      } else if ( theElement == element::MessageId ) {
+        setState ( MessageId );
+      } else if ( theElement == element::MD5OfMessageBody ) {
+        setState ( MD5OfMessageBody );
+      } else if ( theElement == element::Code ) {
+        setState ( BatchErrorCode );
+      } else if ( theElement == element::Message ) {
+        setState ( BatchErrorMessage );
+      } else if ( theElement == element::SenderFault ) {
+        setState ( SenderFault );
+      }
+      theValue.clear();
+    }
+
+    void
+    BatchHandler::responseCharacters ( const xmlChar *  value, int len )
+    {
+      if ( isSet ( BatchId ) || isSet ( MessageId ) || isSet ( MD5OfMessageBody )
+           || isSet ( BatchErrorCode ) || isSet ( BatchErrorMessage ) || isSet ( SenderFault ) ) {
+        theValue.append( (const char*)value, len );
+      }
+    }
+
+    void
+    BatchHandler::responseEndElement ( const xmlChar * localname )
+    {
+      if ( theBatchResponse == 0 || theBatchResponse->theEntries.empty() ) {
+        return;
+      }
+      BatchResponse::Entry& lEntry = theBatchResponse->theEntries.back();
+      if ( theElement == element::Id && isSet ( BatchId ) ) {
+        unsetState ( BatchId );
+        // the ids of the request entries are their positions
+        lEntry.index = strtoul(theValue.c_str(), NULL, 10);
+      } else if ( theElement == element::MessageId && isSet ( MessageId ) ) {
+        unsetState ( MessageId );
+        lEntry.message_id = theValue;
+      } else if ( theElement == element::MD5OfMessageBody && isSet ( MD5OfMessageBody ) ) {
+        unsetState ( MD5OfMessageBody );
+        lEntry.message_md5 = theValue;
+      } else if ( theElement == element::Code && isSet ( BatchErrorCode ) ) {
+        unsetState ( BatchErrorCode );
+        lEntry.error_code = theValue;
+      } else if ( theElement == element::Message && isSet ( BatchErrorMessage ) ) {
+        unsetState ( BatchErrorMessage );
+        lEntry.error_message = theValue;
+      } else if ( theElement == element::SenderFault && isSet ( SenderFault ) ) {
+        unsetState ( SenderFault );
+        lEntry.sender_fault = theValue == "true";
+      }
+    }
+
+    SendMessageBatchHandler::SendMessageBatchHandler()
+      : BatchHandler(element::SendMessageBatchResponse, element::SendMessageBatchResultEntry),
+        theSendMessageBatchResponse(0)
+    {
+    }
+
+    BatchResponse*
+    SendMessageBatchHandler::createResponse()
+    {
+      theSendMessageBatchResponse = new SendMessageBatchResponse();
+      return theSendMessageBatchResponse;
+    }
+
+    DeleteMessageBatchHandler::DeleteMessageBatchHandler()
+      : BatchHandler(element::DeleteMessageBatchResponse, element::DeleteMessageBatchResultEntry),
+        theDeleteMessageBatchResponse(0)
+    {
+    }
+
+    BatchResponse*
+    DeleteMessageBatchHandler::createResponse()
+    {
+      theDeleteMessageBatchResponse = new DeleteMessageBatchResponse();
+      return theDeleteMessageBatchResponse;
+    }
+
+    ChangeMessageVisibilityBatchHandler::ChangeMessageVisibilityBatchHandler()
+      : BatchHandler(element::ChangeMessageVisibilityBatchResponse, element::ChangeMessageVisibilityBatchResultEntry),
+        theChangeMessageVisibilityBatchResponse(0)
+    {
+    }
+
+    BatchResponse*
+    ChangeMessageVisibilityBatchHandler::createResponse()
+    {
+      theChangeMessageVisibilityBatchResponse = new ChangeMessageVisibilityBatchResponse();
+      return theChangeMessageVisibilityBatchResponse;
+    }
+
   } /* namespace sqs  */
 } /* namespace aws */
@@ -27,6 +27,10 @@ namespace aws {
     class SendMessageResponse;
     class ReceiveMessageResponse;
     class DeleteMessageResponse;
+    class BatchResponse;
+    class SendMessageBatchResponse;
+    class DeleteMessageBatchResponse;
+    class ChangeMessageVisibilityBatchResponse;
 
     class QueueErrorHandler : public SimpleQueryCallBack{
       
@@ -42,7 +46,11 @@ namespace aws {
           MD5OfMessageBody 	= 64,
           ReceiptHandle			= 128,
           Body							= 256,
-          MetaData          = 512
+          MetaData          = 512,
+          BatchId           = 1024,
+          BatchErrorCode    = 2048,
+          BatchErrorMessage = 4096,
+          SenderFault       = 8192
         };
 
         virtual void startElement ( const xmlChar *  localname, int nb_attributes, const xmlChar ** attributes );
@@ -138,6 +146,68 @@ namespace aws {
 
     };
 
+    /**
+     * Common parser for the responses of the batch actions. Every
+     * <aResultEntry> element and every BatchResultErrorEntry element
+     * becomes one entry of the BatchResponse created by the subclass.
+     */
+    class BatchHandler : public QueueErrorHandler
+    {
+      private:
+        // element ids, see sqshandler.cpp
+        int theResponseElement;
+        int theResultEntryElement;
+        std::string theValue;
+
+      protected:
+        BatchResponse* theBatchResponse;
+
+        BatchHandler(int aResponseElement, int aResultEntryElement);
+
+        virtual BatchResponse* createResponse() = 0;
+
+      public:
+        virtual void responseStartElement ( const xmlChar *  localname, int nb_attributes, const xmlChar ** attributes );
+        virtual void responseCharacters ( const xmlChar *  value, int len );
+        virtual void responseEndElement ( const xmlChar *  localname );
+
+    };
+
+    class SendMessageBatchHandler : public BatchHandler
+    {
+      protected:
+        friend class SQSConnection;
+        SendMessageBatchResponse* theSendMessageBatchResponse;
+
+        virtual BatchResponse* createResponse();
+
+      public:
+        SendMessageBatchHandler();
+    };
+
+    class DeleteMessageBatchHandler : public BatchHandler
+    {
+      protected:
+        friend class SQSConnection;
+        DeleteMessageBatchResponse* theDeleteMessageBatchResponse;
+
+        virtual BatchResponse* createResponse();
+
+      public:
+        DeleteMessageBatchHandler();
+    };
+
+    class ChangeMessageVisibilityBatchHandler : public BatchHandler
+    {
+      protected:
+        friend class SQSConnection;
+        ChangeMessageVisibilityBatchResponse* theChangeMessageVisibilityBatchResponse;
+
+        virtual BatchResponse* createResponse();
+
+      public:
+        ChangeMessageVisibilityBatchHandler();
+    };
 
   } /* namespace sqs  */
 } /* namespace aws */
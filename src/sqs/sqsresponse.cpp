@@ -104,5 +104,47 @@ namespace aws {
       return theMessages.size();
     }
 
+    void
+    BatchResponse::open()
+    {
+      theIterator = theEntries.begin();
+    }
+
+    bool
+    BatchResponse::next(Entry& aEntry)
+    {
+      if (theIterator != theEntries.end()) {
+        aEntry = *theIterator;
+        ++theIterator;
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    void
+    BatchResponse::close()
+    {
+      theIterator = theEntries.end();
+    }
+
+    int
+    BatchResponse::getNumberOfEntries() const
+    {
+      return theEntries.size();
+    }
+
+    int
+    BatchResponse::getNumberOfFailedEntries() const
+    {
+      int lFailed = 0;
+      for (std::vector<Entry>::const_iterator lIter = theEntries.begin();
+           lIter != theEntries.end(); ++lIter) {
+        if (!lIter->successful)
+          ++lFailed;
+      }
+      return lFailed;
+    }
+
   } /* namespace sqs */
 } /* namespace aws */
@@ -116,6 +116,63 @@ namespace aws {
         friend class DeleteMessageHandler;
     };
 
+    /**
+     * Result of one of the batch actions. There is one entry for every
+     * entry of the request, either successful or failed.
+     */
+    class BatchResponse : public QueryResponse
+    {
+      public:
+        struct Entry
+        {
+          unsigned int index;         // position of the entry in the request
+          bool         successful;
+          std::string  message_id;    // SendMessageBatch only
+          std::string  message_md5;   // SendMessageBatch only
+          std::string  error_code;
+          std::string  error_message;
+          bool         sender_fault;
+        };
+
+        void
+        open();
+
+        bool
+        next(Entry& aEntry);
+
+        void
+        close();
+
+        int
+        getNumberOfEntries() const;
+
+        int
+        getNumberOfFailedEntries() const;
+
+      protected:
+        friend class BatchHandler;
+        std::vector<Entry> theEntries;
+        std::vector<Entry>::iterator theIterator;
+    };
+
+    class SendMessageBatchResponse : public BatchResponse
+    {
+      protected:
+        friend class SendMessageBatchHandler;
+    };
+
+    class DeleteMessageBatchResponse : public BatchResponse
+    {
+      protected:
+        friend class DeleteMessageBatchHandler;
+    };
+
+    class ChangeMessageVisibilityBatchResponse : public BatchResponse
+    {
+      protected:
+        friend class ChangeMessageVisibilityBatchHandler;
+    };
+
   } /* namespace sqs */
 } /* namespace aws */
 
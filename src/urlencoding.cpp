@@ -0,0 +1,317 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "urlencoding.h"
+
+// see base64.cpp, the vector code is selected at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define AWS_URLENCODING_X86
+#  include <immintrin.h>
+#endif
+
+namespace aws {
+
+namespace {
+
+  const char HEX[] = "0123456789ABCDEF";
+
+  const unsigned char UNRESERVED[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+  };
+
+  inline int
+  hexValue(char c)
+  {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  char*
+  encodeScalar(const char* aData, size_t aSize, char* aResult)
+  {
+    for (size_t i = 0; i < aSize; ++i) {
+      unsigned char c = aData[i];
+      if (UNRESERVED[c]) {
+        *aResult++ = c;
+      } else {
+        *aResult++ = '%';
+        *aResult++ = HEX[c >> 4];
+        *aResult++ = HEX[c & 0x0f];
+      }
+    }
+    return aResult;
+  }
+
+  // decodes the character at aPos, which is a '%' or a '+'
+  inline char*
+  decodeEscape(const char* aData, size_t aSize, size_t& aPos, char* aResult)
+  {
+    if (aData[aPos] == '+') {
+      *aResult++ = ' ';
+      ++aPos;
+      return aResult;
+    }
+    int lHigh, lLow;
+    if (aPos + 2 < aSize && (lHigh = hexValue(aData[aPos + 1])) >= 0
+                         && (lLow = hexValue(aData[aPos + 2])) >= 0) {
+      *aResult++ = (char) ((lHigh << 4) | lLow);
+      aPos += 3;
+    } else {
+      *aResult++ = '%';
+      ++aPos;
+    }
+    return aResult;
+  }
+
+  char*
+  decodeScalar(const char* aData, size_t aSize, size_t aPos, char* aResult)
+  {
+    while (aPos < aSize) {
+      char c = aData[aPos];
+      if (c == '%' || c == '+') {
+        aResult = decodeEscape(aData, aSize, aPos, aResult);
+      } else {
+        *aResult++ = c;
+        ++aPos;
+      }
+    }
+    return aResult;
+  }
+
+#ifdef AWS_URLENCODING_X86
+
+  enum Implementation { SCALAR, SSE2, AVX2 };
+
+  Implementation
+  detect()
+  {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return AVX2;
+    if (__builtin_cpu_supports("sse2"))
+      return SSE2;
+    return SCALAR;
+  }
+
+  const Implementation theImplementation = detect();
+
+  /*
+   * A block of unreserved characters is stored as it is. In other blocks
+   * the leading unreserved characters are stored with the block and the
+   * rest is escaped by the scalar code. The stores never exceed
+   * encodedSize() because at least 16 input bytes are left.
+   */
+  __attribute__((target("sse2")))
+  __m128i
+  unreserved(__m128i aIn)
+  {
+    __m128i lUpper = _mm_and_si128(_mm_cmpgt_epi8(aIn, _mm_set1_epi8('A' - 1)),
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), aIn));
+    __m128i lLower = _mm_and_si128(_mm_cmpgt_epi8(aIn, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), aIn));
+    // '-', '.' and the digits
+    __m128i lDigit = _mm_and_si128(_mm_cmpgt_epi8(aIn, _mm_set1_epi8('-' - 1)),
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), aIn));
+    __m128i lOther = _mm_or_si128(_mm_cmpeq_epi8(aIn, _mm_set1_epi8('_')),
+                                  _mm_cmpeq_epi8(aIn, _mm_set1_epi8('~')));
+    lDigit = _mm_andnot_si128(_mm_cmpeq_epi8(aIn, _mm_set1_epi8('/')), lDigit);
+    return _mm_or_si128(_mm_or_si128(lUpper, lLower), _mm_or_si128(lDigit, lOther));
+  }
+
+  __attribute__((target("sse2")))
+  size_t
+  encodeSSE2(const char* aData, size_t aSize, char*& aResult)
+  {
+    size_t i = 0;
+    for (; i + 16 <= aSize; i += 16) {
+      __m128i lIn = _mm_loadu_si128((const __m128i*) (aData + i));
+      unsigned int lMask = _mm_movemask_epi8(unreserved(lIn));
+      _mm_storeu_si128((__m128i*) aResult, lIn);
+      if (lMask == 0xffff) {
+        aResult += 16;
+      } else {
+        unsigned int lRun = __builtin_ctz(~lMask);
+        aResult = encodeScalar(aData + i + lRun, 16 - lRun, aResult + lRun);
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  __m256i
+  unreserved(__m256i aIn)
+  {
+    __m256i lUpper = _mm256_and_si256(_mm256_cmpgt_epi8(aIn, _mm256_set1_epi8('A' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), aIn));
+    __m256i lLower = _mm256_and_si256(_mm256_cmpgt_epi8(aIn, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), aIn));
+    __m256i lDigit = _mm256_and_si256(_mm256_cmpgt_epi8(aIn, _mm256_set1_epi8('-' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), aIn));
+    __m256i lOther = _mm256_or_si256(_mm256_cmpeq_epi8(aIn, _mm256_set1_epi8('_')),
+                                     _mm256_cmpeq_epi8(aIn, _mm256_set1_epi8('~')));
+    lDigit = _mm256_andnot_si256(_mm256_cmpeq_epi8(aIn, _mm256_set1_epi8('/')), lDigit);
+    return _mm256_or_si256(_mm256_or_si256(lUpper, lLower), _mm256_or_si256(lDigit, lOther));
+  }
+
+  __attribute__((target("avx2")))
+  size_t
+  encodeAVX2(const char* aData, size_t aSize, char*& aResult)
+  {
+    size_t i = 0;
+    for (; i + 32 <= aSize; i += 32) {
+      __m256i lIn = _mm256_loadu_si256((const __m256i*) (aData + i));
+      unsigned int lMask = _mm256_movemask_epi8(unreserved(lIn));
+      _mm256_storeu_si256((__m256i*) aResult, lIn);
+      if (lMask == 0xffffffff) {
+        aResult += 32;
+      } else {
+        unsigned int lRun = __builtin_ctz(~lMask);
+        aResult = encodeScalar(aData + i + lRun, 32 - lRun, aResult + lRun);
+      }
+    }
+    return i;
+  }
+
+  /*
+   * Decoding stores blocks without '%' or '+' as they are, the others
+   * are decoded by the scalar code after their leading run. The output
+   * never gets ahead of the input, so the stores stay within aSize.
+   */
+  __attribute__((target("sse2")))
+  size_t
+  decodeSSE2(const char* aData, size_t aSize, char*& aResult)
+  {
+    size_t i = 0;
+    while (i + 16 <= aSize) {
+      __m128i lIn = _mm_loadu_si128((const __m128i*) (aData + i));
+      unsigned int lMask = _mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(lIn, _mm_set1_epi8('%')),
+                       _mm_cmpeq_epi8(lIn, _mm_set1_epi8('+'))));
+      _mm_storeu_si128((__m128i*) aResult, lIn);
+      if (lMask == 0) {
+        aResult += 16;
+        i += 16;
+      } else {
+        // the rest of the block, an escape may reach into the next one
+        size_t lEnd = i + 16;
+        unsigned int lRun = __builtin_ctz(lMask);
+        i += lRun;
+        aResult += lRun;
+        while (i < lEnd) {
+          if (aData[i] == '%' || aData[i] == '+') {
+            aResult = decodeEscape(aData, aSize, i, aResult);
+          } else {
+            *aResult++ = aData[i++];
+          }
+        }
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  size_t
+  decodeAVX2(const char* aData, size_t aSize, char*& aResult)
+  {
+    size_t i = 0;
+    while (i + 32 <= aSize) {
+      __m256i lIn = _mm256_loadu_si256((const __m256i*) (aData + i));
+      unsigned int lMask = _mm256_movemask_epi8(
+          _mm256_or_si256(_mm256_cmpeq_epi8(lIn, _mm256_set1_epi8('%')),
+                          _mm256_cmpeq_epi8(lIn, _mm256_set1_epi8('+'))));
+      _mm256_storeu_si256((__m256i*) aResult, lIn);
+      if (lMask == 0) {
+        aResult += 32;
+        i += 32;
+      } else {
+        // the rest of the block, an escape may reach into the next one
+        size_t lEnd = i + 32;
+        unsigned int lRun = __builtin_ctz(lMask);
+        i += lRun;
+        aResult += lRun;
+        while (i < lEnd) {
+          if (aData[i] == '%' || aData[i] == '+') {
+            aResult = decodeEscape(aData, aSize, i, aResult);
+          } else {
+            *aResult++ = aData[i++];
+          }
+        }
+      }
+    }
+    return i;
+  }
+
+#endif /* AWS_URLENCODING_X86 */
+
+} /* namespace */
+
+size_t
+UrlEncoding::encode(const char* aData, size_t aSize, char* aResult)
+{
+  char* lResult = aResult;
+  size_t lDone = 0;
+#ifdef AWS_URLENCODING_X86
+  if (theImplementation == AVX2)
+    lDone = encodeAVX2(aData, aSize, lResult);
+  if (theImplementation >= SSE2)
+    lDone += encodeSSE2(aData + lDone, aSize - lDone, lResult);
+#endif
+  lResult = encodeScalar(aData + lDone, aSize - lDone, lResult);
+  return lResult - aResult;
+}
+
+void
+UrlEncoding::append(std::string& aTarget, const char* aData, size_t aSize)
+{
+  if (aSize == 0)
+    return;
+  size_t lOffset = aTarget.size();
+  aTarget.resize(lOffset + encodedSize(aSize));
+  aTarget.resize(lOffset + encode(aData, aSize, &aTarget[lOffset]));
+}
+
+size_t
+UrlEncoding::decode(const char* aData, size_t aSize, char* aResult)
+{
+  char* lResult = aResult;
+  size_t lDone = 0;
+#ifdef AWS_URLENCODING_X86
+  if (theImplementation == AVX2)
+    lDone = decodeAVX2(aData, aSize, lResult);
+  if (theImplementation >= SSE2)
+    lDone += decodeSSE2(aData + lDone, aSize - lDone, lResult);
+#endif
+  lResult = decodeScalar(aData, aSize, lDone, lResult);
+  return lResult - aResult;
+}
+
+void
+UrlEncoding::decode(const std::string& aData, std::string& aResult)
+{
+  aResult.resize(aData.size());
+  if (!aData.empty())
+    aResult.resize(decode(aData.data(), aData.size(), &aResult[0]));
+}
+
+} /* namespace aws */
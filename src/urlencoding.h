@@ -0,0 +1,54 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_URLENCODING_H
+#define AWS_URLENCODING_H
+
+#include <stddef.h>
+#include <string>
+
+namespace aws {
+
+/*
+ * Percent-encoding (RFC 3986) into caller provided buffers.
+ * Everything but the unreserved characters (letters, digits, '-', '.',
+ * '_' and '~') is escaped with upper case hex digits.
+ * On x86 runs of unreserved characters are copied 16 or 32 bytes at a
+ * time, the scalar code handles the characters that need escaping.
+ */
+class UrlEncoding {
+
+public:
+  // upper bound of the encoded size of aSize bytes
+  static size_t encodedSize(size_t aSize) { return 3 * aSize; }
+
+  // writes at most encodedSize(aSize) characters, no null termination
+  static size_t encode(const char* aData, size_t aSize, char* aResult);
+
+  // appends the encoding to aTarget, without temporary strings
+  static void append(std::string& aTarget, const char* aData, size_t aSize);
+
+  /*
+   * Writes at most aSize bytes. '+' is decoded as a space, as in form data
+   * and in S3 listings. A '%' that isn't followed by two hex digits is
+   * kept as it is.
+   */
+  static size_t decode(const char* aData, size_t aSize, char* aResult);
+
+  static void decode(const std::string& aData, std::string& aResult);
+};
+
+} /* namespace aws */
+#endif /* !AWS_URLENCODING_H */
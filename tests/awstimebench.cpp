@@ -0,0 +1,116 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <libaws/awstime.h>
+
+#include "bench.h"
+
+// Compares the date parsing and formatting of aws::Time with
+// strptime/mktime and gmtime/strftime and checks that the results match.
+
+using namespace aws;
+
+namespace {
+
+  const char* RFC1123 = "%a, %d %b %Y %H:%M:%S GMT";
+  const char* ISO8601 = "%Y-%m-%dT%H:%M:%SZ";
+
+  int
+  check(time_t aTime)
+  {
+    struct tm lTm;
+    gmtime_r(&aTime, &lTm);
+    char lExpected[64];
+    char lResult[64];
+
+    strftime(lExpected, sizeof(lExpected), RFC1123, &lTm);
+    Time::formatRFC1123(aTime, lResult);
+    time_t lParsed = -1;
+    if (strcmp(lExpected, lResult) != 0
+        || !Time::parseRFC1123(lResult, strlen(lResult), lParsed) || lParsed != aTime) {
+      std::cerr << "RFC 1123: " << lExpected << " != " << lResult << std::endl;
+      return 1;
+    }
+
+    strftime(lExpected, sizeof(lExpected), ISO8601, &lTm);
+    Time::formatISO8601(aTime, lResult);
+    if (strcmp(lExpected, lResult) != 0
+        || !Time::parseISO8601(lResult, strlen(lResult), lParsed) || lParsed != aTime) {
+      std::cerr << "ISO 8601: " << lExpected << " != " << lResult << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+} /* namespace */
+
+int
+main(int argc, char** argv)
+{
+  int lIterations = bench::iterations(argc, argv, 1000000);
+
+  // every day from 1970 to 2100, at different times of the day
+  for (time_t lTime = 0; lTime < 4102444800LL; lTime += 86400 + 3607) {
+    if (check(lTime) != 0)
+      return 1;
+  }
+  if (lIterations == 0)
+    return 0;
+
+  const char* lDate = "Fri, 09 Nov 2007 13:05:49 GMT";
+  size_t lSize = strlen(lDate);
+  time_t lSum = 0;
+  struct tm lTm;
+  char lBuffer[64];
+
+  bench::Timer lTimer;
+  for (int i = 0; i < lIterations; ++i) {
+    memset(&lTm, 0, sizeof(lTm));
+    strptime(lDate, RFC1123, &lTm);
+    lSum += mktime(&lTm);
+  }
+  double lStrptime = lTimer.lap();
+
+  for (int i = 0; i < lIterations; ++i) {
+    time_t lTime;
+    Time::parseRFC1123(lDate, lSize, lTime);
+    lSum += lTime;
+  }
+  double lParse = lTimer.lap();
+
+  for (int i = 0; i < lIterations; ++i) {
+    time_t lTime = 1194613549 + i;
+    strftime(lBuffer, sizeof(lBuffer), RFC1123, gmtime_r(&lTime, &lTm));
+    lSum += lBuffer[5];
+  }
+  double lStrftime = lTimer.lap();
+
+  for (int i = 0; i < lIterations; ++i) {
+    Time::formatRFC1123(1194613549 + i, lBuffer);
+    lSum += lBuffer[5];
+  }
+  double lFormat = lTimer.lap();
+
+  std::cout << "parse: " << bench::nanoseconds(lIterations, lStrptime) << " ns (strptime+mktime) "
+            << bench::nanoseconds(lIterations, lParse) << " ns" << std::endl
+            << "format: " << bench::nanoseconds(lIterations, lStrftime) << " ns (gmtime+strftime) "
+            << bench::nanoseconds(lIterations, lFormat) << " ns" << std::endl
+            << "checksum: " << lSum % 1000 << std::endl;
+  return 0;
+}
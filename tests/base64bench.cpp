@@ -0,0 +1,134 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <../src/base64.h> //HACK
+
+#include "bench.h"
+
+// Compares the base64 codec with the OpenSSL BIO chains it replaced and
+// checks that both produce the same results.
+
+using namespace aws;
+
+namespace {
+
+  std::string
+  bioEncode(const unsigned char* aContent, size_t aSize)
+  {
+    char* lEncoded;
+    BIO* lBio = BIO_new(BIO_s_mem());
+    BIO* lB64 = BIO_new(BIO_f_base64());
+    BIO_set_flags(lB64, BIO_FLAGS_BASE64_NO_NL);
+    lBio = BIO_push(lB64, lBio);
+    BIO_write(lBio, aContent, aSize);
+    (void) BIO_flush(lBio);
+    long lLength = BIO_get_mem_data(lBio, &lEncoded);
+    std::string lResult(lEncoded, lLength);
+    BIO_free_all(lBio);
+    return lResult;
+  }
+
+  size_t
+  bioDecode(const std::string& aContent, unsigned char* aResult, size_t aSize)
+  {
+    BIO* lBio = BIO_new_mem_buf((char*) aContent.data(), aContent.size());
+    BIO* lB64 = BIO_new(BIO_f_base64());
+    BIO_set_flags(lB64, BIO_FLAGS_BASE64_NO_NL);
+    lBio = BIO_push(lB64, lBio);
+    int lRead = BIO_read(lBio, aResult, aSize);
+    BIO_free_all(lBio);
+    return lRead < 0 ? 0 : lRead;
+  }
+
+  int
+  run(size_t aSize, int aIterations)
+  {
+    std::vector<unsigned char> lData(aSize + 1);
+    for (size_t i = 0; i < aSize; ++i)
+      lData[i] = rand();
+
+    std::string lExpected = bioEncode(&lData[0], aSize);
+    std::vector<char> lEncoded(Base64::encodedSize(aSize) + 1);
+    size_t lEncodedSize = Base64::encode(&lData[0], aSize, &lEncoded[0]);
+    if (lExpected != std::string(&lEncoded[0], lEncodedSize)) {
+      std::cerr << "encoding of " << aSize << " bytes differs from OpenSSL" << std::endl;
+      return 1;
+    }
+
+    std::vector<unsigned char> lDecoded(Base64::decodedSize(lEncodedSize) + 1);
+    size_t lDecodedSize = 0;
+    if (!Base64::decode(&lEncoded[0], lEncodedSize, &lDecoded[0], lDecodedSize)
+        || lDecodedSize != aSize || memcmp(&lDecoded[0], &lData[0], aSize) != 0) {
+      std::cerr << "decoding of " << aSize << " bytes failed" << std::endl;
+      return 1;
+    }
+    if (aIterations == 0)
+      return 0;
+
+    bench::Timer lTimer;
+    for (int i = 0; i < aIterations; ++i)
+      bioEncode(&lData[0], aSize);
+    double lBioEncode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      Base64::encode(&lData[0], aSize, &lEncoded[0]);
+    double lEncode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      bioDecode(lExpected, &lDecoded[0], lDecoded.size());
+    double lBioDecode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      Base64::decode(&lEncoded[0], lEncodedSize, &lDecoded[0], lDecodedSize);
+    double lDecode = lTimer.lap();
+
+    std::cout << aSize << " bytes: encode "
+              << bench::megabytesPerSecond(aSize, aIterations, lBioEncode) << " MB/s (BIO) "
+              << bench::megabytesPerSecond(aSize, aIterations, lEncode) << " MB/s ("
+              << Base64::implementation() << "), decode "
+              << bench::megabytesPerSecond(aSize, aIterations, lBioDecode) << " MB/s (BIO) "
+              << bench::megabytesPerSecond(aSize, aIterations, lDecode) << " MB/s ("
+              << Base64::implementation() << ")" << std::endl;
+    return 0;
+  }
+
+} /* namespace */
+
+int
+main(int argc, char** argv)
+{
+  int lIterations = bench::iterations(argc, argv, 10000);
+
+  // a signature, a small and a large SQS message
+  size_t lSizes[] = { 20, 1024, 8192, 24576 };
+  for (size_t i = 0; i < sizeof(lSizes) / sizeof(size_t); ++i) {
+    if (run(lSizes[i], lIterations) != 0)
+      return 1;
+  }
+
+  // the tails of the vector code
+  for (size_t lSize = 0; lSize < 100; ++lSize) {
+    if (run(lSize, 0) != 0)
+      return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AWS_TESTS_BENCH_H
+#define AWS_TESTS_BENCH_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+// Helpers of the benchmarks. A benchmark first checks its results and
+// returns non-zero if they are wrong, then it measures.
+// usage: <benchmark> [iterations]
+// With 0 iterations nothing is measured, that's how the tests run them.
+
+namespace bench {
+
+  inline double
+  now()
+  {
+    struct timeval lNow;
+    gettimeofday(&lNow, NULL);
+    return lNow.tv_sec + lNow.tv_usec / 1000000.0;
+  }
+
+  inline int
+  iterations(int argc, char** argv, int aDefault)
+  {
+    return argc > 1 ? atoi(argv[1]) : aDefault;
+  }
+
+  class Timer
+  {
+    public:
+      Timer() : theStart(now()) {}
+
+      // the seconds since the construction or the last lap
+      double
+      lap()
+      {
+        double lNow = now();
+        double lSeconds = lNow - theStart;
+        theStart = lNow;
+        return lSeconds;
+      }
+
+    private:
+      double theStart;
+  };
+
+  inline double
+  megabytesPerSecond(size_t aBytes, int aIterations, double aSeconds)
+  {
+    return (double) aBytes * aIterations / (1024 * 1024) / aSeconds;
+  }
+
+  inline double
+  nanoseconds(double aItems, double aSeconds)
+  {
+    return aSeconds * 1e9 / aItems;
+  }
+
+} /* namespace bench */
+
+#endif /* AWS_TESTS_BENCH_H */
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "s3/s3handler.h"
+#include "s3/s3response.h"
+#include "s3/s3callbackwrapper.h"
+
+#include "bench.h"
+
+// Parses a page of a bucket listing like S3Connection::listBucket does and
+// checks the keys. Reports the parse time per key, next to the time
+// libxml2 needs without any handler.
+
+using namespace aws::s3;
+
+namespace {
+
+  // the size of the chunks curl passes to the write callback
+  const size_t CHUNK_SIZE = 16384;
+
+  const int KEYS = 1000;
+
+  std::string
+  generate(int aKeys)
+  {
+    std::ostringstream lPage;
+    lPage << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          << "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+          << "<Name>bucket</Name><Prefix>photos/</Prefix><Marker></Marker>"
+          << "<MaxKeys>1000</MaxKeys><EncodingType>url</EncodingType>"
+          << "<IsTruncated>false</IsTruncated>";
+    for (int i = 0; i < aKeys; ++i) {
+      lPage << "<Contents><Key>photos/2008/" << i << "/my+image%26" << i << ".jpg</Key>"
+            << "<LastModified>2008-11-09T13:05:" << i % 6 << i % 10 << ".000Z</LastModified>"
+            << "<ETag>&quot;828ef3fdfa96f00ad9f27c383fc9ac7f&quot;</ETag>"
+            << "<Size>" << i * 1000 << "</Size>"
+            << "<Owner><ID>bcaf1ffd86f41161ca5fb16fd081034f</ID>"
+            << "<DisplayName>webfile</DisplayName></Owner>"
+            << "<StorageClass>STANDARD</StorageClass></Contents>";
+    }
+    lPage << "</ListBucketResult>";
+    return lPage.str();
+  }
+
+  void
+  parse(const std::string& aPage, S3CallBackWrapper& aWrapper)
+  {
+    aWrapper.createParser();
+    for (size_t i = 0; i < aPage.size(); i += CHUNK_SIZE) {
+      size_t lSize = aPage.size() - i < CHUNK_SIZE ? aPage.size() - i : CHUNK_SIZE;
+      xmlParseChunk(aWrapper.theParserCtxt, aPage.data() + i, lSize, 0);
+    }
+    xmlParseChunk(aWrapper.theParserCtxt, 0, 0, 1);
+    aWrapper.destroyParser();
+  }
+
+  ListBucketResponse*
+  listBucket(const std::string& aPage)
+  {
+    ListBucketResponse* lRes = new ListBucketResponse("bucket", "photos/", "", -1);
+    ListBucketHandler   lHandler;
+    S3CallBackWrapper   lWrapper;
+    lWrapper.theResponse = lRes;
+    lWrapper.theHandler  = &lHandler;
+    lWrapper.theSAXHandler.startElementNs = &ListBucketHandler::startElementNs;
+    lWrapper.theSAXHandler.characters     = &ListBucketHandler::charactersSAXFunc;
+    lWrapper.theSAXHandler.endElementNs   = &ListBucketHandler::endElementNs;
+    parse(aPage, lWrapper);
+    return lRes;
+  }
+
+  void
+  ignoreStartElementNs(void*, const xmlChar*, const xmlChar*, const xmlChar*, int,
+                       const xmlChar**, int, int, const xmlChar**)
+  {}
+
+  void
+  ignoreCharacters(void*, const xmlChar*, int)
+  {}
+
+  void
+  ignoreEndElementNs(void*, const xmlChar*, const xmlChar*, const xmlChar*)
+  {}
+
+  void
+  parseOnly(const std::string& aPage)
+  {
+    S3CallBackWrapper lWrapper;
+    lWrapper.theSAXHandler.startElementNs = &ignoreStartElementNs;
+    lWrapper.theSAXHandler.characters     = &ignoreCharacters;
+    lWrapper.theSAXHandler.endElementNs   = &ignoreEndElementNs;
+    parse(aPage, lWrapper);
+  }
+
+  int
+  check(ListBucketResponse* aRes)
+  {
+    ListBucketResponse::Key lKey;
+    int lKeys = 0;
+    aRes->open();
+    while (aRes->next(lKey)) {
+      std::ostringstream lExpected;
+      lExpected << "photos/2008/" << lKeys << "/my image&" << lKeys << ".jpg";
+      if (lKey.KeyValue != lExpected.str()
+          || lKey.ETag != "828ef3fdfa96f00ad9f27c383fc9ac7f"
+          || lKey.Length != lKeys * 1000
+          || lKey.LastModifiedTime.getSeconds() != 1226235900 + lKeys % 6 * 10 + lKeys % 10) {
+        std::cerr << "key " << lKeys << " differs: " << lKey.KeyValue << " " << lKey.ETag
+                  << " " << lKey.Length << " " << lKey.LastModified << std::endl;
+        return 1;
+      }
+      ++lKeys;
+    }
+    aRes->close();
+    if (lKeys != KEYS || aRes->isTruncated()) {
+      std::cerr << lKeys << " keys instead of " << KEYS << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+} /* namespace */
+
+int
+main(int argc, char** argv)
+{
+  int lIterations = bench::iterations(argc, argv, 100);
+
+  std::string lPage = generate(KEYS);
+  ListBucketResponse* lRes = listBucket(lPage);
+  int lResult = check(lRes);
+  delete lRes;
+  if (lResult != 0 || lIterations == 0)
+    return lResult;
+
+  bench::Timer lTimer;
+  for (int i = 0; i < lIterations; ++i)
+    parseOnly(lPage);
+  double lParse = lTimer.lap();
+
+  for (int i = 0; i < lIterations; ++i)
+    delete listBucket(lPage);
+  double lList = lTimer.lap();
+
+  double lKeys = (double) KEYS * lIterations;
+  std::cout << "list bucket: " << bench::nanoseconds(lKeys, lList) << " ns per key ("
+            << bench::nanoseconds(lKeys, lParse) << " ns without handler)" << std::endl;
+  return 0;
+}
@@ -15,6 +15,8 @@
  */
 #include <iostream>
 #include <sstream>
+#include <map>
+#include <vector>
 #include <stdlib.h>
 #include <libaws/aws.h>
 
@@ -88,6 +90,58 @@ put(S3Connection* lS3Rest)
   return 0;
 }
 
+int
+headmany(S3Connection* lS3Rest, int aConcurrency)
+{
+  // existing keys (see put) and missing ones, mixed
+  std::map<std::string, long long> lExpected;
+  lExpected["a/b/c"] = 25;
+  lExpected["missing/1"] = -1;
+  lExpected["a/b/c/d"] = 5;
+  lExpected["missing/2"] = -1;
+
+  std::vector<std::string> lKeys;
+  for (std::map<std::string, long long>::iterator lIter = lExpected.begin();
+       lIter != lExpected.end(); ++lIter) {
+    lKeys.push_back(lIter->first);
+  }
+
+  try {
+    HeadManyResponsePtr lHeads = lS3Rest->headMany(bucketName, lKeys, aConcurrency);
+    HeadManyResponse::Object lObject;
+    lHeads->open();
+    // the results come in completion order, every key exactly once
+    while (lHeads->next(lObject)) {
+      std::map<std::string, long long>::iterator lIter = lExpected.find(lObject.KeyValue);
+      if (lIter == lExpected.end()) {
+        std::cerr << "unexpected or duplicate key " << lObject.KeyValue << std::endl;
+        return 5;
+      }
+      bool lExists = lIter->second >= 0;
+      if (lObject.IsSuccessful != lExists
+          || (lExists && lObject.ContentLength != lIter->second)
+          || (!lExists && lObject.ErrorCode != S3Exception::NoSuchKey)) {
+        std::cerr << "wrong head result for " << lObject.KeyValue << ": "
+                  << lObject.ErrorMessage << std::endl;
+        return 5;
+      }
+      lExpected.erase(lIter);
+    }
+    lHeads->close();
+  } catch (AWSException& e) {
+    std::cerr << "Couldn't head objects" << std::endl;
+    std::cerr << e.what() << std::endl;
+    return 5;
+  }
+
+  if (!lExpected.empty()) {
+    std::cerr << lExpected.size() << " keys are missing in the head results" << std::endl;
+    return 5;
+  }
+  std::cout << "Objects headed successfully (concurrency " << aConcurrency << ")" << std::endl;
+  return 0;
+}
+
 int
 listbucket(S3Connection* lS3Rest)
 {
@@ -223,6 +277,14 @@ s3objecttest(int argc, char* argv[])
     if (lReturnCode != 0)
       return lReturnCode;
 
+    lReturnCode = headmany(lS3Rest.get(), 1);
+    if (lReturnCode != 0)
+      return lReturnCode;
+
+    lReturnCode = headmany(lS3Rest.get(), 10);
+    if (lReturnCode != 0)
+      return lReturnCode;
+
     lReturnCode = listbucket(lS3Rest.get());
     if (lReturnCode != 0)
       return lReturnCode;
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <libaws/aws.h>
+
+using namespace aws;
+
+const char packBucketName[] = "28msec_s3packstoretest";
+
+int
+fill(S3PackStore* lStore)
+{
+  for (int i = 0; i < 100; ++i) {
+    std::ostringstream lKey, lData;
+    lKey << "dir/file" << i;
+    lData << "content of file " << i;
+    lStore->put(lKey.str(), lData.str().c_str(), lData.str().length());
+  }
+  lStore->flush();
+  std::cout << "Objects packed successfully" << std::endl;
+  return 0;
+}
+
+int
+check(S3PackStore* lStore, int aFrom, int aTo)
+{
+  for (int i = aFrom; i < aTo; ++i) {
+    std::ostringstream lKey, lData;
+    lKey << "dir/file" << i;
+    lData << "content of file " << i;
+
+    std::string lContent;
+    if (!lStore->get(lKey.str(), lContent)) {
+      std::cerr << "Object " << lKey.str() << " is missing" << std::endl;
+      return 1;
+    }
+    if (lContent != lData.str()) {
+      std::cerr << "Object " << lKey.str() << " has the wrong content: " << lContent << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "Objects retrieved successfully" << std::endl;
+  return 0;
+}
+
+int
+deleteandcompact(S3PackStore* lStore)
+{
+  for (int i = 0; i < 50; ++i) {
+    std::ostringstream lKey;
+    lKey << "dir/file" << i;
+    if (!lStore->del(lKey.str())) {
+      std::cerr << "Couldn't delete " << lKey.str() << std::endl;
+      return 1;
+    }
+  }
+  lStore->compact(0.5);
+
+  std::string lContent;
+  if (lStore->get("dir/file0", lContent)) {
+    std::cerr << "Deleted object still exists" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> lKeys;
+  lStore->keys("dir/", lKeys);
+  if (lKeys.size() != 50) {
+    std::cerr << "Expected 50 keys but got " << lKeys.size() << std::endl;
+    return 1;
+  }
+  std::cout << "Objects deleted and compacted successfully" << std::endl;
+  return 0;
+}
+
+int
+checkempty(S3PackStore* lStore)
+{
+  std::string lContent = "not empty";
+  long long lSize = -1;
+  if (!lStore->get("empty", lContent) || !lContent.empty()
+      || !lStore->size("empty", &lSize) || lSize != 0) {
+    std::cerr << "Empty object is missing or not empty" << std::endl;
+    return 1;
+  }
+  std::cout << "Empty object retrieved successfully" << std::endl;
+  return 0;
+}
+
+int
+s3packstoretest(int argc, char* argv[]) 
+{
+  AWSConnectionFactory* lFactory = AWSConnectionFactory::getInstance();
+
+  std::cout << "Testing libaws version " << lFactory->getVersion() << std::endl;
+
+  char* lAccessKeyId = getenv("AWS_ACCESS_KEY");
+  char* lSecretAccessKey = getenv("AWS_SECRET_ACCESS_KEY");
+
+  if (lAccessKeyId == 0 || lSecretAccessKey == 0) {
+    std::cerr << "Environment variables (i.e. AWS_ACCESS_KEY or AWS_SECRET_ACCESS_KEY) not set" 
+              << std::endl;
+    return 1;
+  }
+
+  S3ConnectionPtr lS3Rest = lFactory->createS3Connection(lAccessKeyId, lSecretAccessKey);
+
+  int lReturnCode;
+  try {
+    lS3Rest->createBucket(packBucketName);
+
+    {
+      // small packs to get more than one of them
+      S3PackStore lStore(lS3Rest, packBucketName, "store/", 512);
+      lStore.load();
+
+      lReturnCode = fill(&lStore);
+      if (lReturnCode != 0)
+        return lReturnCode;
+
+      lReturnCode = check(&lStore, 0, 100);
+      if (lReturnCode != 0)
+        return lReturnCode;
+
+      lReturnCode = deleteandcompact(&lStore);
+      if (lReturnCode != 0)
+        return lReturnCode;
+    }
+
+    {
+      // the index on S3 must have the same content
+      S3PackStore lStore(lS3Rest, packBucketName, "store/", 512);
+      lStore.load();
+
+      lReturnCode = check(&lStore, 50, 100);
+      if (lReturnCode != 0)
+        return lReturnCode;
+    }
+
+    {
+      // a flush of nothing but empty objects writes no pack but the index
+      S3PackStore lStore(lS3Rest, packBucketName, "empty/", 512);
+      lStore.load();
+
+      lStore.put("empty", "", 0);
+      lStore.flush();
+      lReturnCode = checkempty(&lStore);
+      if (lReturnCode != 0)
+        return lReturnCode;
+    }
+
+    {
+      S3PackStore lStore(lS3Rest, packBucketName, "empty/", 512);
+      lStore.load();
+
+      lReturnCode = checkempty(&lStore);
+      if (lReturnCode != 0)
+        return lReturnCode;
+    }
+
+    lS3Rest->deleteAll(packBucketName);
+    lS3Rest->deleteBucket(packBucketName);
+
+  } catch (S3Exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 3;
+  } catch (AWSException& e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+
+  lFactory->shutdown();
+
+  return 0;
+}
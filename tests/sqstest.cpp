@@ -15,8 +15,10 @@
  */
 #include <iostream>
 #include <sstream>
+#include <map>
 #include <libaws/aws.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <../src/logging/logging.hh> //HACK 
 
 using namespace aws;
@@ -135,6 +137,14 @@ testMessages(SQSConnection* lSQSCon)
       		lMessage.receipt_handle);
       std::cout << "Message with ID " << lMessage.message_id << " has been deleted" << std::endl;
 
+      // long polling on the empty queue returns after the wait time without messages
+      lReceiveResponse = lSQSCon->receiveMessage(lAQueueURL, 1, -1, true, 2);
+      if (lReceiveResponse->getNumberOfRetrievedMessages() != 0) {
+      	std::cout << "Wrong number of messages (exp. 0): "
+      	          << lReceiveResponse->getNumberOfRetrievedMessages() << std::endl;
+      	return 1;
+      }
+
       // delete queue
 			DeleteQueueResponsePtr lDeleteQueue = lSQSCon->deleteQueue(lAQueueURL);
       std::cout << "Queue " << lAQueueURL << " has been deleted" << std::endl;
@@ -148,6 +158,287 @@ testMessages(SQSConnection* lSQSCon)
   return 0;
 }
 
+int
+testBatchMessages(SQSConnection* lSQSCon)
+{
+  {
+    try {
+      CreateQueueResponsePtr lCreateQueue = lSQSCon->createQueue("aBatchQueue");
+      std::string lQueueURL = lCreateQueue->getQueueUrl();
+      std::cout << "Queue created successfully. QueueUrl: " << lQueueURL << std::endl;
+
+      // send a batch of messages
+      std::vector<std::string> lBodies;
+      for (int i = 0; i < 3; ++i) {
+        std::stringstream lBody;
+        lBody << "batch body " << i;
+        lBodies.push_back(lBody.str());
+      }
+      SendMessageBatchResponsePtr lSendResponse = lSQSCon->sendMessageBatch(lQueueURL, lBodies);
+      SendMessageBatchResponse::Entry lEntry;
+      int lCount = 0;
+      lSendResponse->open();
+      while (lSendResponse->next(lEntry)) {
+        if (!lEntry.successful) {
+          std::cout << "Sending message " << lEntry.index << " failed: "
+                    << lEntry.error_message << std::endl;
+          return 1;
+        }
+        std::cout << "Message " << lEntry.index << " sent. ID: " << lEntry.message_id << std::endl;
+        lCount++;
+      }
+      lSendResponse->close();
+      if (lCount != 3) {
+        std::cout << "Wrong number of sent messages (exp. 3): " << lCount << std::endl;
+        return 1;
+      }
+
+      // receive them
+      std::vector<std::string> lReceiptHandles;
+      for (int lTries = 0; lTries < 10 && lReceiptHandles.size() < 3; ++lTries) {
+        ReceiveMessageResponsePtr lReceiveResponse = lSQSCon->receiveMessage(lQueueURL, 10, -1);
+        ReceiveMessageResponse::Message lMessage;
+        lReceiveResponse->open();
+        while (lReceiveResponse->next(lMessage)) {
+          lReceiptHandles.push_back(lMessage.receipt_handle);
+        }
+        lReceiveResponse->close();
+      }
+      if (lReceiptHandles.size() != 3) {
+        std::cout << "Wrong number of messages (exp. 3): " << lReceiptHandles.size() << std::endl;
+        return 1;
+      }
+
+      // make them visible again right away
+      ChangeMessageVisibilityBatchResponsePtr lVisibilityResponse =
+          lSQSCon->changeMessageVisibilityBatch(lQueueURL, lReceiptHandles, 0);
+      if (lVisibilityResponse->getNumberOfFailedEntries() != 0) {
+        std::cout << "Changing the visibility failed for "
+                  << lVisibilityResponse->getNumberOfFailedEntries() << " messages" << std::endl;
+        return 1;
+      }
+
+      // delete them plus an invalid handle that must fail on its own
+      lReceiptHandles.push_back("invalid-receipt-handle");
+      DeleteMessageBatchResponsePtr lDeleteResponse =
+          lSQSCon->deleteMessageBatch(lQueueURL, lReceiptHandles);
+      if (lDeleteResponse->getNumberOfEntries() != 4
+          || lDeleteResponse->getNumberOfFailedEntries() != 1) {
+        std::cout << "Unexpected delete result (exp. 4 entries, 1 failed): "
+                  << lDeleteResponse->getNumberOfEntries() << " entries, "
+                  << lDeleteResponse->getNumberOfFailedEntries() << " failed" << std::endl;
+        return 1;
+      }
+
+      DeleteQueueResponsePtr lDeleteQueue = lSQSCon->deleteQueue(lQueueURL);
+      std::cout << "Queue " << lQueueURL << " has been deleted" << std::endl;
+
+    } catch (SQSException& e) {
+      std::cerr << "Batch request failed" << std::endl;
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void
+countSent(const SQSProducer::Result& aResult, void* aCount)
+{
+  if (aResult.successful)
+    __sync_fetch_and_add((int*) aCount, 1);
+  else
+    std::cout << "Sending failed: " << aResult.error_message << std::endl;
+}
+
+int
+testProducer(SQSConnection* lSQSCon, const char* aAccessKeyId, const char* aSecretAccessKey)
+{
+  {
+    try {
+      CreateQueueResponsePtr lCreateQueue = lSQSCon->createQueue("aProducerQueue");
+      std::string lQueueURL = lCreateQueue->getQueueUrl();
+      std::cout << "Queue created successfully. QueueUrl: " << lQueueURL << std::endl;
+
+      int lSent = 0;
+      {
+        ConnectionPool<SQSConnectionPtr> lPool(2, aAccessKeyId, aSecretAccessKey);
+        SQSProducer lProducer(&lPool, 2);
+        lProducer.start();
+        for (int i = 0; i < 25; ++i) {
+          std::stringstream lBody;
+          lBody << "producer body " << i;
+          lProducer.send(lQueueURL, lBody.str(), countSent, &lSent);
+        }
+        lProducer.flush();
+        lProducer.stop();
+      }
+      if (lSent != 25) {
+        std::cout << "Wrong number of sent messages (exp. 25): " << lSent << std::endl;
+        return 1;
+      }
+
+      DeleteQueueResponsePtr lDeleteQueue = lSQSCon->deleteQueue(lQueueURL);
+      std::cout << "Queue " << lQueueURL << " has been deleted" << std::endl;
+
+    } catch (SQSException& e) {
+      std::cerr << "Producer test failed" << std::endl;
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+bool
+countHandled(const SQSConsumer::Message& aMessage, void* aCount)
+{
+  __sync_fetch_and_add((int*) aCount, 1);
+  return true;
+}
+
+int
+testConsumer(SQSConnection* lSQSCon, const char* aAccessKeyId, const char* aSecretAccessKey)
+{
+  {
+    try {
+      CreateQueueResponsePtr lCreateQueue = lSQSCon->createQueue("aConsumerQueue");
+      std::string lQueueURL = lCreateQueue->getQueueUrl();
+      std::cout << "Queue created successfully. QueueUrl: " << lQueueURL << std::endl;
+
+      std::vector<std::string> lBodies;
+      for (int i = 0; i < 10; ++i) {
+        std::stringstream lBody;
+        lBody << "consumer body " << i;
+        lBodies.push_back(lBody.str());
+      }
+      lSQSCon->sendMessageBatch(lQueueURL, lBodies);
+      lSQSCon->sendMessageBatch(lQueueURL, lBodies);
+
+      int lHandled = 0;
+      SQSConsumer::Statistics lStatistics;
+      {
+        ConnectionPool<SQSConnectionPtr> lPool(3, aAccessKeyId, aSecretAccessKey);
+        SQSConsumer lConsumer(&lPool, lQueueURL, countHandled, &lHandled, 2, 4);
+        lConsumer.start();
+        for (int lWait = 0; lWait < 60 && lConsumer.getStatistics().processed < 20; ++lWait)
+          sleep(1);
+        lConsumer.stop();
+        lStatistics = lConsumer.getStatistics();
+      }
+      std::cout << "Consumer processed " << lStatistics.processed << " messages, "
+                << lStatistics.throughput << " per second" << std::endl;
+      if (lHandled != 20 || lStatistics.deleted != 20) {
+        std::cout << "Wrong number of handled/deleted messages (exp. 20): "
+                  << lHandled << "/" << lStatistics.deleted << std::endl;
+        return 1;
+      }
+
+      DeleteQueueResponsePtr lDeleteQueue = lSQSCon->deleteQueue(lQueueURL);
+      std::cout << "Queue " << lQueueURL << " has been deleted" << std::endl;
+
+    } catch (SQSException& e) {
+      std::cerr << "Consumer test failed" << std::endl;
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+testExtendedClient(const SQSConnectionPtr& aSQSCon, const S3ConnectionPtr& aS3Con)
+{
+  {
+    try {
+      CreateQueueResponsePtr lCreateQueue = aSQSCon->createQueue("anExtendedQueue");
+      std::string lQueueURL = lCreateQueue->getQueueUrl();
+      std::cout << "Queue created successfully. QueueUrl: " << lQueueURL << std::endl;
+      aS3Con->createBucket("28msec_sqsextendedtest");
+
+      SQSExtendedClient lClient(aSQSCon, aS3Con, "28msec_sqsextendedtest", "sqs-payloads/", 100);
+
+      // message id -> the body and whether it must have been offloaded
+      std::map<std::string, std::pair<std::string, bool> > lExpected;
+      std::string lSmall = "small body";
+      lExpected[lClient.sendMessage(lQueueURL, lSmall)] = std::make_pair(lSmall, false);
+      std::string lLarge(1000, 'x');
+      lExpected[lClient.sendMessage(lQueueURL, lLarge)] = std::make_pair(lLarge, true);
+
+      // a plain body that looks like a pointer of this client stays plain
+      std::string lLookalike = "libaws-sqs-pointer 1\t28msec_sqsextendedtest\tsqs-payloads/x\t5";
+      lExpected[lClient.sendMessage(lQueueURL, lLookalike)] = std::make_pair(lLookalike, false);
+
+      // a pointer to a foreign bucket isn't followed
+      std::string lForeign = "libaws-sqs-pointer 1\tsomeotherbucket\tsqs-payloads/x\t5";
+      lExpected[aSQSCon->sendMessage(lQueueURL, lForeign)->getMessageId()] =
+          std::make_pair(lForeign, false);
+
+      std::vector<SQSExtendedClient::Message> lReceived;
+      for (int lTries = 0; lTries < 10 && !lExpected.empty(); ++lTries) {
+        std::vector<SQSExtendedClient::Message> lMessages;
+        lClient.receiveMessage(lQueueURL, lMessages, 10);
+        for (size_t i = 0; i < lMessages.size(); ++i) {
+          const SQSExtendedClient::Message& lMessage = lMessages[i];
+          std::map<std::string, std::pair<std::string, bool> >::iterator lIter =
+              lExpected.find(lMessage.message_id);
+          if (lIter == lExpected.end()) {
+            std::cout << "Unexpected message: " << lMessage.message_id << std::endl;
+            return 1;
+          }
+          std::string lBody;
+          lClient.getBody(lMessage, lBody);
+          if (lMessage.offloaded != lIter->second.second || lBody != lIter->second.first
+              || lMessage.payload_size != (long long) lBody.size()) {
+            std::cout << "Wrong message " << lMessage.message_id << " (offloaded "
+                      << lMessage.offloaded << "): " << lBody << std::endl;
+            return 1;
+          }
+          lExpected.erase(lIter);
+          lReceived.push_back(lMessage);
+        }
+      }
+      if (!lExpected.empty()) {
+        std::cout << lExpected.size() << " messages weren't received" << std::endl;
+        return 1;
+      }
+
+      // objects outside of the bucket and prefix are never read or deleted
+      SQSExtendedClient::Message lPointer = lReceived.front();
+      lPointer.offloaded = true;
+      lPointer.payload_bucket = "someotherbucket";
+      lPointer.payload_key = "sqs-payloads/x";
+      try {
+        lClient.getPayload(lPointer);
+        std::cout << "A foreign bucket was read" << std::endl;
+        return 1;
+      } catch (S3Exception&) {
+      }
+      lPointer.payload_bucket = "28msec_sqsextendedtest";
+      lPointer.payload_key = "other/x";
+      try {
+        lClient.deleteMessage(lQueueURL, lPointer);
+        std::cout << "A foreign prefix was deleted" << std::endl;
+        return 1;
+      } catch (S3Exception&) {
+      }
+
+      for (size_t i = 0; i < lReceived.size(); ++i)
+        lClient.deleteMessage(lQueueURL, lReceived[i]);
+
+      DeleteQueueResponsePtr lDeleteQueue = aSQSCon->deleteQueue(lQueueURL);
+      std::cout << "Queue " << lQueueURL << " has been deleted" << std::endl;
+      aS3Con->deleteBucket("28msec_sqsextendedtest");
+
+    } catch (AWSException& e) {
+      std::cerr << "Extended client test failed" << std::endl;
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
 int
 sqstest(int argc, char* argv[])
 {
@@ -186,6 +477,26 @@ sqstest(int argc, char* argv[])
     if (lReturnCode != 0)
       return lReturnCode;
 
+    lReturnCode = testBatchMessages(lS3Rest.get());
+    if (lReturnCode != 0)
+      return lReturnCode;
+
+    // the connection pool always connects to the default host
+    if (lHost == 0) {
+      lReturnCode = testProducer(lS3Rest.get(), lAccessKeyId, lSecretAccessKey);
+      if (lReturnCode != 0)
+        return lReturnCode;
+
+      lReturnCode = testConsumer(lS3Rest.get(), lAccessKeyId, lSecretAccessKey);
+      if (lReturnCode != 0)
+        return lReturnCode;
+
+      S3ConnectionPtr lS3Con = lFactory->createS3Connection(lAccessKeyId, lSecretAccessKey);
+      lReturnCode = testExtendedClient(lS3Rest, lS3Con);
+      if (lReturnCode != 0)
+        return lReturnCode;
+    }
+
 
   } catch (AWSConnectionException& e) {
     std::cerr << e.what() << std::endl;
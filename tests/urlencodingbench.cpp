@@ -0,0 +1,134 @@
+/*
+ * Copyright 2008 28msec, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <curl/curl.h>
+#include <../src/urlencoding.h> //HACK
+
+#include "bench.h"
+
+// Compares the url encoding with curl_escape/curl_unescape and checks
+// that both produce the same results.
+
+using namespace aws;
+
+namespace {
+
+  std::string
+  curlEncode(const std::string& aData)
+  {
+    char* lEscaped = curl_easy_escape(0, aData.data(), aData.size());
+    std::string lResult(lEscaped);
+    curl_free(lEscaped);
+    return lResult;
+  }
+
+  std::string
+  curlDecode(const std::string& aData)
+  {
+    int lSize;
+    char* lUnescaped = curl_easy_unescape(0, aData.data(), aData.size(), &lSize);
+    std::string lResult(lUnescaped, lSize);
+    curl_free(lUnescaped);
+    return lResult;
+  }
+
+  int
+  run(const std::string& aName, const std::string& aData, int aIterations)
+  {
+    std::string lExpected = curlEncode(aData);
+    std::vector<char> lEncoded(UrlEncoding::encodedSize(aData.size()) + 1);
+    size_t lEncodedSize = UrlEncoding::encode(aData.data(), aData.size(), &lEncoded[0]);
+    if (lExpected != std::string(&lEncoded[0], lEncodedSize)) {
+      std::cerr << aName << ": encoding of " << aData.size() << " bytes differs from curl"
+                << std::endl;
+      return 1;
+    }
+
+    std::string lDecoded;
+    UrlEncoding::decode(lExpected, lDecoded);
+    if (lDecoded != aData || curlDecode(lExpected) != aData) {
+      std::cerr << aName << ": decoding of " << aData.size() << " bytes failed" << std::endl;
+      return 1;
+    }
+    if (aIterations == 0)
+      return 0;
+
+    bench::Timer lTimer;
+    for (int i = 0; i < aIterations; ++i)
+      curlEncode(aData);
+    double lCurlEncode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      UrlEncoding::encode(aData.data(), aData.size(), &lEncoded[0]);
+    double lEncode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      curlDecode(lExpected);
+    double lCurlDecode = lTimer.lap();
+
+    for (int i = 0; i < aIterations; ++i)
+      UrlEncoding::decode(lExpected, lDecoded);
+    double lDecode = lTimer.lap();
+
+    size_t lSize = aData.size();
+    std::cout << aName << " (" << lSize << " bytes): encode "
+              << bench::megabytesPerSecond(lSize, aIterations, lCurlEncode) << " MB/s (curl) "
+              << bench::megabytesPerSecond(lSize, aIterations, lEncode) << " MB/s, decode "
+              << bench::megabytesPerSecond(lSize, aIterations, lCurlDecode) << " MB/s (curl) "
+              << bench::megabytesPerSecond(lSize, aIterations, lDecode) << " MB/s" << std::endl;
+    return 0;
+  }
+
+  std::string
+  generate(size_t aSize, const char* aAlphabet, size_t aAlphabetSize)
+  {
+    std::string lResult;
+    for (size_t i = 0; i < aSize; ++i)
+      lResult += aAlphabet[rand() % aAlphabetSize];
+    return lResult;
+  }
+
+} /* namespace */
+
+int
+main(int argc, char** argv)
+{
+  int lIterations = bench::iterations(argc, argv, 100000);
+
+  const char lKey[] = "abcdefghijklmnopqrstuvwxyz0123456789/-_.";
+  const char lBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
+
+  // a typical S3 key, an SQS message body and binary data
+  if (run("key", generate(64, lKey, sizeof(lKey) - 1), lIterations) != 0
+      || run("message", generate(8192, lBase64, sizeof(lBase64) - 1), lIterations / 10) != 0)
+    return 1;
+
+  std::string lBinary;
+  for (size_t i = 0; i < 4096; ++i)
+    lBinary += (char) rand();
+  if (run("binary", lBinary, lIterations / 10) != 0)
+    return 1;
+
+  // the tails of the vector code
+  for (size_t lSize = 0; lSize < 100; ++lSize) {
+    if (run("tail", generate(lSize, lBase64, sizeof(lBase64) - 1), 0) != 0)
+      return 1;
+  }
+  return 0;
+}